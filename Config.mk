@@ -6,6 +6,16 @@
 BOARD?=pi3-64
 HDMI_CONSOLE?=0
 
+# Smaller memory reserves and lazily-loaded ROMs, for 512MB boards like the Pi Zero 2 W
+LOW_MEMORY?=0
+
+# Profile-guided optimization (needs GCC 12 or later)
+#   generate: instrumented build; custom SysEx F0 7D 0C F7 runs the benchmark workload and saves profile data to SD:pgo/
+#   use:      optimized build using the profile data copied from SD:pgo/ into PGO_PROFILE_DIR
+# Both builds must be made from the same source tree at the same absolute path; run "make mrproper" when switching.
+PGO?=
+PGO_PROFILE_DIR?=$(abspath pgo-profile)
+
 # Serial bootloader config
 SERIALPORT?=/dev/ttyUSB0
 FLASHBAUD?=3000000
@@ -58,6 +68,18 @@ ifeq ($(strip $(GC_SECTIONS)),1)
 CFLAGS_EXTERNAL += -ffunction-sections -fdata-sections
 endif
 
+# Profile-guided optimization flags, used for the kernel and external dependencies alike
+ifeq ($(PGO), generate)
+# Value profiling needs libgcov's thread-local state, which Circle doesn't provide, so only arcs are profiled;
+# the counters are collected in a linker section instead of being registered by constructors
+PGO_FLAGS = -fprofile-generate -fno-profile-values -fprofile-update=atomic -fprofile-info-section=gcov_info
+else ifeq ($(PGO), use)
+PGO_FLAGS = -fprofile-use=$(PGO_PROFILE_DIR) -fno-vpt -fprofile-partial-training -Wno-missing-profile
+else ifneq ($(strip $(PGO)),)
+$(error Invalid PGO mode "$(PGO)"; please specify one of [ generate | use ])
+endif
+CFLAGS_EXTERNAL += $(PGO_FLAGS)
+
 ifeq ($(PREFIX), arm-none-eabi-)
 CMAKE_TOOLCHAIN_FLAGS=-DCMAKE_TOOLCHAIN_FILE=../cmake/arm-none-eabi.cmake
 else
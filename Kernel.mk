@@ -10,27 +10,43 @@ OBJS		:=	src/config.o \
 			src/control/rotaryencoder.o \
 			src/control/simplebuttons.o \
 			src/control/simpleencoder.o \
+			src/coreload.o \
+			src/coremailbox.o \
+			src/firmwarestatus.o \
+			src/gcovwriter.o \
 			src/kernel.o \
 			src/lcd/drivers/hd44780.o \
 			src/lcd/drivers/hd44780fourbit.o \
 			src/lcd/drivers/hd44780i2c.o \
 			src/lcd/drivers/sh1106.o \
 			src/lcd/drivers/ssd1306.o \
+			src/lcd/mainmenu.o \
+			src/lcd/menu.o \
 			src/lcd/ui.o \
 			src/main.o \
 			src/midimonitor.o \
 			src/midiparser.o \
+			src/midistats.o \
+			src/midistress.o \
 			src/mt32pi.o \
 			src/net/applemidi.o \
 			src/net/ftpdaemon.o \
 			src/net/ftpworker.o \
+			src/net/midiadmission.o \
 			src/net/udpmidi.o \
 			src/pisound.o \
 			src/power.o \
+			src/profilemanager.o \
+			src/renderscheduler.o \
 			src/rommanager.o \
 			src/soundfontmanager.o \
+			src/stackmonitor.o \
+			src/synth/lightreverb.o \
 			src/synth/mt32synth.o \
+			src/synth/soundfontregistry.o \
 			src/synth/soundfontsynth.o \
+			src/sysexfiletransfer.o \
+			src/telemetry.o \
 			src/zoneallocator.o
 
 EXTRACLEAN	+=	src/*.d src/*.o \
@@ -75,6 +91,16 @@ ifeq ($(HDMI_CONSOLE), 1)
 DEFINE		+=	-D HDMI_CONSOLE
 endif
 
+ifeq ($(LOW_MEMORY), 1)
+DEFINE		+=	-D LOW_MEMORY
+endif
+
+CFLAGS		+=	$(PGO_FLAGS)
+ifeq ($(PGO), generate)
+DEFINE		+=	-D PGO_GENERATE
+LIBS		+=	$(shell $(CC) $(ARCH) -print-file-name=libgcov.a)
+endif
+
 -include $(DEPS)
 
 INCLUDE		+=	-I $(MT32EMUBUILDDIR)/include
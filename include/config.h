@@ -30,6 +30,7 @@
 #include "lcd/drivers/ssd1306.h"
 #include "synth/mt32romset.h"
 #include "synth/mt32synth.h"
+#include "synth/soundfontsynth.h"
 #include "utility.h"
 
 class CConfig
@@ -55,6 +56,8 @@ public:
 	using TMT32EmuMIDIChannels     = CMT32Synth::TMIDIChannels;
 	using TMT32EmuROMSet           = TMT32ROMSet;
 
+	using TFluidSynthInterpolation = CSoundFontSynth::TInterpolation;
+
 	using TLCDRotation             = CSSD1306::TLCDRotation;
 	using TLCDMirror               = CSSD1306::TLCDMirror;
 
@@ -79,6 +82,9 @@ public:
 	CConfig();
 	bool Initialize(const char* pPath);
 
+	// Re-reads the file, but only updates options that can take effect without a reboot
+	bool Reload(const char* pPath);
+
 	static CConfig* Get() { return s_pThis; }
 
 	// Expand all config variables from definition file
@@ -96,6 +102,9 @@ public:
 	static bool ParseOption(const char* pString, TMT32EmuResamplerQuality* pOut);
 	static bool ParseOption(const char* pString, TMT32EmuMIDIChannels* pOut);
 	static bool ParseOption(const char* pString, TMT32EmuROMSet* pOut);
+	static bool ParseOption(const char* pString, TFluidSynthInterpolation* pOut);
+	static bool ParseOption(const char* pString, TReverbEngine* pOut);
+	static bool ParseOption(const char* pString, TChorusEngine* pOut);
 	static bool ParseOption(const char* pString, TLCDType* pOut);
 	static bool ParseOption(const char* pString, TControlScheme* pOut);
 	static bool ParseOption(const char* pString, TEncoderType* pOut);
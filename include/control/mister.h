@@ -42,6 +42,7 @@ private:
 	void ResetState();
 	void ApplyConfig(const TMisterStatus& NewStatus, const TMisterStatus& SystemStatus);
 	void EnqueueDisplayImageEvent();
+	void EnqueueApplyProfileEvent(size_t nIndex);
 	void EnqueueAllSoundOffEvent();
 
 	CI2CMaster* m_pI2CMaster;
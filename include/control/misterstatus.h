@@ -29,10 +29,15 @@
 
 enum class TMisterSynth : u8
 {
-	Mute      = 0xA0,
-	MT32      = 0xA1,
-	SoundFont = 0xA2,
-	Unknown   = 0xFF,
+	Mute         = 0xA0,
+	MT32         = 0xA1,
+	SoundFont    = 0xA2,
+
+	// Apply game profile 0-31 from profiles.cfg
+	ProfileFirst = 0xC0,
+	ProfileLast  = 0xDF,
+
+	Unknown      = 0xFF,
 };
 
 struct TMisterStatus
@@ -0,0 +1,69 @@
+//
+// coreload.h
+//
+// mt32-pi - A baremetal MIDI synthesizer for Raspberry Pi
+// Copyright (C) 2020-2023 Dale Whinham <daleyo@gmail.com>
+//
+// This file is part of mt32-pi.
+//
+// mt32-pi is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// mt32-pi is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// mt32-pi. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef _coreload_h
+#define _coreload_h
+
+#include <circle/sysconfig.h>
+#include <circle/types.h>
+
+// Per-core busy time accounting; each core only writes its own counter, and the main core turns them into load percentages
+class CCoreLoad
+{
+public:
+	// Counts the lifetime of this object as busy time on the given core
+	class CScope
+	{
+	public:
+		CScope(CCoreLoad& CoreLoad, unsigned nCore);
+		~CScope();
+
+	private:
+		CCoreLoad& m_CoreLoad;
+		unsigned m_nCore;
+		unsigned m_nStartTime;
+	};
+
+	CCoreLoad();
+
+	void AddBusyTime(unsigned nCore, unsigned nClockTicks) { __atomic_store_n(&m_nBusyTime[nCore], m_nBusyTime[nCore] + nClockTicks, __ATOMIC_RELAXED); }
+
+	// Called periodically by the main core; recalculates the load figures once per second
+	void Update(unsigned int nTicks);
+	void ResetPeaks();
+
+	u8 GetLoad(unsigned nCore) const { return m_nLoad[nCore]; }
+	u8 GetPeakLoad(unsigned nCore) const { return m_nPeakLoad[nCore]; }
+
+private:
+	// Written by the owning core only; wraps harmlessly as only differences are used
+	u32 m_nBusyTime[CORES];
+
+	u32 m_nLastBusyTime[CORES];
+	unsigned m_nLastClockTime;
+	unsigned int m_nLastUpdateTime;
+
+	volatile u8 m_nLoad[CORES];
+	volatile u8 m_nPeakLoad[CORES];
+};
+
+#endif
@@ -0,0 +1,89 @@
+//
+// coremailbox.h
+//
+// mt32-pi - A baremetal MIDI synthesizer for Raspberry Pi
+// Copyright (C) 2020-2023 Dale Whinham <daleyo@gmail.com>
+//
+// This file is part of mt32-pi.
+//
+// mt32-pi is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// mt32-pi is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// mt32-pi. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef _coremailbox_h
+#define _coremailbox_h
+
+#include <circle/multicore.h>
+#include <circle/types.h>
+
+struct TCoreMessage
+{
+	u32 nType;
+	u32 nParam;
+};
+
+// Lock-free message queues between each pair of cores, with an inter-processor interrupt as a doorbell so that receivers can sleep
+class CCoreMailbox
+{
+public:
+	static constexpr size_t QueueSize = 16;
+	static constexpr unsigned DoorbellIPI = IPI_USER;
+
+	CCoreMailbox();
+
+	// Returns false if the queue to the receiver is full; don't call from interrupt handlers, as each queue has a single producer
+	bool Send(unsigned nFrom, unsigned nTo, const TCoreMessage& Message);
+	bool Receive(unsigned nCore, TCoreMessage& OutMessage);
+
+	// Sleeps until a message for this core arrives
+	void Wait(unsigned nCore);
+
+	// Call from CMultiCoreSupport::IPIHandler()
+	void OnDoorbell(unsigned nCore);
+
+	void Dump() const;
+	void ResetStats();
+
+private:
+	static_assert((QueueSize & (QueueSize - 1)) == 0, "Queue size must be a power of 2");
+
+	// Single producer, single consumer
+	struct TQueue
+	{
+		u32 nHead;
+		u32 nTail;
+		TCoreMessage Messages[QueueSize];
+	};
+
+	struct TCoreStats
+	{
+		u32 nReceived;
+		u32 nDropped;
+		u32 nDoorbells;
+		u32 nWakes;
+		unsigned nIRQLatencyPeak;
+		unsigned nWakeLatencyPeak;
+		u64 nWakeLatencyTotal;
+	};
+
+	bool HasMessages(unsigned nCore) const;
+
+	// Indexed by receiver, then sender
+	TQueue m_Queues[CORES][CORES];
+
+	bool m_bSleeping[CORES];
+	unsigned m_nRingTime[CORES];
+	TCoreStats m_Stats[CORES];
+};
+
+#endif
@@ -66,6 +66,16 @@ struct TDisplayImageEvent
 	TImage Image;
 };
 
+struct TMasterVolumeEvent
+{
+	u8 nVolume;
+};
+
+struct TApplyProfileEvent
+{
+	size_t Index;
+};
+
 enum class TEventType
 {
 	Button,
@@ -75,6 +85,8 @@ enum class TEventType
 	SwitchSoundFont,
 	AllSoundOff,
 	DisplayImage,
+	MasterVolume,
+	ApplyProfile,
 };
 
 struct TEvent
@@ -90,6 +102,8 @@ struct TEvent
 		TSwitchSoundFontEvent SwitchSoundFont;
 		TAllSoundOffEvent AllSoundOff;
 		TDisplayImageEvent DisplayImage;
+		TMasterVolumeEvent MasterVolume;
+		TApplyProfileEvent ApplyProfile;
 	};
 };
 
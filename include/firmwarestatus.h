@@ -0,0 +1,65 @@
+//
+// firmwarestatus.h
+//
+// mt32-pi - A baremetal MIDI synthesizer for Raspberry Pi
+// Copyright (C) 2020-2023 Dale Whinham <daleyo@gmail.com>
+//
+// This file is part of mt32-pi.
+//
+// mt32-pi is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// mt32-pi is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// mt32-pi. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef _firmwarestatus_h
+#define _firmwarestatus_h
+
+#include <circle/bcmpropertytags.h>
+#include <circle/sched/task.h>
+#include <circle/types.h>
+
+// Polls the VideoCore firmware for throttling, temperature and clock status at a low rate and caches the results,
+// so that readers on any core don't have to make a slow property mailbox round-trip
+class CFirmwareStatus : protected CTask
+{
+public:
+	static constexpr unsigned UpdatePeriodMillis = 1000;
+
+	CFirmwareStatus();
+
+	void Initialize();
+
+	virtual void Run() override;
+
+	u32 GetThrottledStatus() const { return __atomic_load_n(&m_nThrottledStatus, __ATOMIC_RELAXED); }
+
+	// Degrees Celsius
+	unsigned GetTemperature() const { return __atomic_load_n(&m_nTemperature, __ATOMIC_RELAXED); }
+
+	// ARM clock rate in Hz
+	unsigned GetClockRate() const { return __atomic_load_n(&m_nClockRate, __ATOMIC_RELAXED); }
+
+	static CFirmwareStatus* Get() { return s_pThis; }
+
+private:
+	void Query();
+
+	CBcmPropertyTags m_Tags;
+
+	u32 m_nThrottledStatus;
+	unsigned m_nTemperature;
+	unsigned m_nClockRate;
+
+	static CFirmwareStatus* s_pThis;
+};
+
+#endif
@@ -0,0 +1,39 @@
+//
+// gcovwriter.h
+//
+// mt32-pi - A baremetal MIDI synthesizer for Raspberry Pi
+// Copyright (C) 2020-2023 Dale Whinham <daleyo@gmail.com>
+//
+// This file is part of mt32-pi.
+//
+// mt32-pi is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// mt32-pi is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// mt32-pi. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef _gcovwriter_h
+#define _gcovwriter_h
+
+// Writes the profile counters of an instrumented build (make PGO=generate) to the SD card as .gcda files,
+// named so that a later make PGO=use build can find them
+class CGcovWriter
+{
+public:
+	static bool Write(const char* pDirectory);
+
+private:
+	static void OnFileName(const char* pFileName, void* pParam);
+	static void OnData(const void* pData, unsigned nSize, void* pParam);
+	static void* OnAllocate(unsigned nSize, void* pParam);
+};
+
+#endif
@@ -61,6 +61,7 @@ public:
 	virtual void DrawChar(char chChar, u8 nCursorX, u8 nCursorY, bool bInverted = false, bool bDoubleWidth = false) override;
 	virtual void DrawImage(TImage Image, bool bImmediate = false) override;
 	virtual void Flip() override;
+	virtual void DrawBitmap(const u8* pBitmap, u8 nBitmapWidth, u8 nBitmapHeight, u8 nX, u8 nY, u8 nScaleX = 1, u8 nScaleY = 1) override;
 
 	virtual void SetBacklightState(bool bEnabled) override;
 
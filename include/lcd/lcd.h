@@ -62,6 +62,9 @@ public:
 	virtual void DrawImage(TImage Image, bool bImmediate = false) {};
 	virtual void Flip() {};
 
+	// Blits a 1bpp bitmap (row-major, MSB first, rows padded to whole bytes) with integer scaling
+	virtual void DrawBitmap(const u8* pBitmap, u8 nBitmapWidth, u8 nBitmapHeight, u8 nX, u8 nY, u8 nScaleX = 1, u8 nScaleY = 1) {};
+
 	bool GetBacklightState() const { return m_bBacklightEnabled; }
 	virtual void SetBacklightState(bool bEnabled) {};
 
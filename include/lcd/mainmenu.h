@@ -0,0 +1,190 @@
+//
+// mainmenu.h
+//
+// mt32-pi - A baremetal MIDI synthesizer for Raspberry Pi
+// Copyright (C) 2020-2023 Dale Whinham <daleyo@gmail.com>
+//
+// This file is part of mt32-pi.
+//
+// mt32-pi is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// mt32-pi is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// mt32-pi. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef _mainmenu_h
+#define _mainmenu_h
+
+#include <circle/types.h>
+
+#include "event.h"
+#include "lcd/menu.h"
+#include "midistats.h"
+#include "profilemanager.h"
+#include "snapshot.h"
+#include "soundfontmanager.h"
+#include "synth/mt32synth.h"
+#include "synth/soundfontsynth.h"
+#include "synth/synth.h"
+
+class CSynthMenu : public CMenu
+{
+public:
+	CSynthMenu(TEventQueue& EventQueue);
+
+	virtual size_t GetItemCount() const override { return 2; }
+	virtual void GetItemText(size_t nIndex, char* pOutBuffer, size_t nSize) const override;
+	virtual size_t GetInitialIndex() const override { return static_cast<size_t>(m_CurrentSynth); }
+	virtual bool Select(size_t nIndex) override;
+
+	void SetCurrentSynth(TSynth Synth) { m_CurrentSynth = Synth; }
+
+private:
+	TEventQueue& m_EventQueue;
+	volatile TSynth m_CurrentSynth;
+};
+
+class CMT32ROMSetMenu : public CMenu
+{
+public:
+	CMT32ROMSetMenu(TEventQueue& EventQueue);
+
+	virtual size_t GetItemCount() const override { return m_pMT32Synth ? 3 : 0; }
+	virtual void GetItemText(size_t nIndex, char* pOutBuffer, size_t nSize) const override;
+	virtual size_t GetInitialIndex() const override;
+	virtual bool Select(size_t nIndex) override;
+
+	void SetSynth(CMT32Synth* pMT32Synth) { m_pMT32Synth = pMT32Synth; }
+
+private:
+	TEventQueue& m_EventQueue;
+	CMT32Synth* m_pMT32Synth;
+};
+
+class CSoundFontMenu : public CMenu
+{
+public:
+	CSoundFontMenu(TEventQueue& EventQueue);
+
+	virtual size_t GetItemCount() const override;
+	virtual void GetItemText(size_t nIndex, char* pOutBuffer, size_t nSize) const override;
+	virtual size_t GetInitialIndex() const override;
+	virtual bool Select(size_t nIndex) override;
+
+	void SetSynth(CSoundFontSynth* pSoundFontSynth) { m_pSoundFontSynth = pSoundFontSynth; }
+
+	// Called by the main core after each rescan; the UI core can't read the SoundFont list while it is being rebuilt
+	void SetSoundFontNames(const CSoundFontManager& SoundFontManager);
+
+private:
+	struct TName
+	{
+		char Text[20 + 1];
+	};
+
+	TEventQueue& m_EventQueue;
+	CSoundFontSynth* m_pSoundFontSynth;
+
+	CSnapshot<TName> m_Names[CSoundFontManager::MaxSoundFonts];
+	volatile size_t m_nNameCount;
+};
+
+class CProfileMenu : public CMenu
+{
+public:
+	CProfileMenu(TEventQueue& EventQueue, const CProfileManager& ProfileManager);
+
+	virtual size_t GetItemCount() const override { return m_ProfileManager.GetProfileCount(); }
+	virtual void GetItemText(size_t nIndex, char* pOutBuffer, size_t nSize) const override;
+	virtual bool Select(size_t nIndex) override;
+
+private:
+	TEventQueue& m_EventQueue;
+	const CProfileManager& m_ProfileManager;
+};
+
+// Read-only view of the MIDI traffic counters
+class CMIDIStatsMenu : public CMenu
+{
+public:
+	CMIDIStatsMenu(const CMIDIStats& MIDIStats);
+
+	virtual size_t GetItemCount() const override;
+	virtual void GetItemText(size_t nIndex, char* pOutBuffer, size_t nSize) const override;
+
+private:
+	const CMIDIStats& m_MIDIStats;
+};
+
+// Read-only view of FluidSynth voice usage
+class CVoiceStatsMenu : public CMenu
+{
+public:
+	CVoiceStatsMenu();
+
+	virtual size_t GetItemCount() const override;
+	virtual void GetItemText(size_t nIndex, char* pOutBuffer, size_t nSize) const override;
+
+	void SetSynth(const CSoundFontSynth* pSoundFontSynth) { m_pSoundFontSynth = pSoundFontSynth; }
+
+private:
+	const CSoundFontSynth* m_pSoundFontSynth;
+};
+
+class CMainMenu : public CMenu
+{
+public:
+	CMainMenu(TEventQueue& EventQueue, const CMIDIStats& MIDIStats, const CProfileManager& ProfileManager);
+
+	virtual size_t GetItemCount() const override { return static_cast<size_t>(TItem::Max); }
+	virtual void GetItemText(size_t nIndex, char* pOutBuffer, size_t nSize) const override;
+	virtual CMenu* GetSubmenu(size_t nIndex) override;
+	virtual bool IsEditable(size_t nIndex) const override { return nIndex == static_cast<size_t>(TItem::Volume); }
+	virtual void Adjust(size_t nIndex, int nDelta) override;
+	virtual bool Select(size_t nIndex) override { return nIndex == static_cast<size_t>(TItem::Exit); }
+
+	// State pushed in by the main core
+	void SetCurrentSynth(TSynth Synth) { m_SynthMenu.SetCurrentSynth(Synth); }
+	void SetMasterVolume(u8 nVolume) { m_nMasterVolume = nVolume; }
+	void SetSynths(CMT32Synth* pMT32Synth, CSoundFontSynth* pSoundFontSynth);
+	void SetSoundFontNames(const CSoundFontManager& SoundFontManager) { m_SoundFontMenu.SetSoundFontNames(SoundFontManager); }
+
+private:
+	enum class TItem
+	{
+		Synth,
+		MT32ROMSet,
+		SoundFont,
+		Profile,
+		Volume,
+		MIDIStats,
+		VoiceStats,
+		Exit,
+
+		Max,
+	};
+
+	TEventQueue& m_EventQueue;
+	volatile u8 m_nMasterVolume;
+
+	// Synths may be created after the menu; submenus pick them up when entered
+	CMT32Synth* volatile m_pMT32Synth;
+	CSoundFontSynth* volatile m_pSoundFontSynth;
+
+	CSynthMenu m_SynthMenu;
+	CMT32ROMSetMenu m_MT32ROMSetMenu;
+	CSoundFontMenu m_SoundFontMenu;
+	CProfileMenu m_ProfileMenu;
+	CMIDIStatsMenu m_MIDIStatsMenu;
+	CVoiceStatsMenu m_VoiceStatsMenu;
+};
+
+#endif
@@ -0,0 +1,116 @@
+//
+// menu.h
+//
+// mt32-pi - A baremetal MIDI synthesizer for Raspberry Pi
+// Copyright (C) 2020-2023 Dale Whinham <daleyo@gmail.com>
+//
+// This file is part of mt32-pi.
+//
+// mt32-pi is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// mt32-pi is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// mt32-pi. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef _menu_h
+#define _menu_h
+
+#include <circle/types.h>
+
+#include "lcd/lcd.h"
+#include "ringbuffer.h"
+
+enum class TMenuInput : u8
+{
+	Up,
+	Down,
+	Select,
+	Back,
+};
+
+// A node in the menu tree; items are generated on demand so that long lists don't need to be stored
+class CMenu
+{
+public:
+	CMenu(const char* pTitle) : m_pTitle(pTitle) {}
+	virtual ~CMenu() = default;
+
+	const char* GetTitle() const { return m_pTitle; }
+
+	virtual size_t GetItemCount() const = 0;
+	virtual void GetItemText(size_t nIndex, char* pOutBuffer, size_t nSize) const = 0;
+	virtual size_t GetInitialIndex() const { return 0; }
+
+	// Returns a child menu to enter, or nullptr
+	virtual CMenu* GetSubmenu(size_t nIndex) { return nullptr; }
+
+	// Value editors are adjusted with up/down while being edited
+	virtual bool IsEditable(size_t nIndex) const { return false; }
+	virtual void Adjust(size_t nIndex, int nDelta) {}
+
+	// Returns true if the menu should be closed
+	virtual bool Select(size_t nIndex) { return false; }
+
+private:
+	const char* m_pTitle;
+};
+
+// Retained view of the menu tree; keeps the last drawn text of each row and only reports damage for rows that changed
+class CMenuSystem
+{
+public:
+	CMenuSystem();
+
+	void SetRootMenu(CMenu* pMenu) { m_pRootMenu = pMenu; }
+	bool IsOpen() const { return m_bOpen; }
+	bool QueueInput(TMenuInput Input) { return m_InputQueue.Enqueue(Input); }
+
+	bool Update(const CLCD& LCD, unsigned int nTicks);
+	void Draw(CLCD& LCD, bool bRedrawAll);
+
+private:
+	void ProcessInput(TMenuInput Input, size_t nItemRows);
+	void Open();
+	void Close();
+	void EnterMenu(CMenu* pMenu);
+	void LeaveMenu();
+	bool RefreshRows(const CLCD& LCD);
+
+	static u8 GetRowCount(const CLCD& LCD);
+	static u8 GetRowWidth(const CLCD& LCD);
+
+	static constexpr size_t MaxRows = 4;
+	static constexpr size_t RowTextSize = 20 + 1;
+	static constexpr size_t MaxDepth = 4;
+	static constexpr size_t InputQueueSize = 16;
+	static constexpr unsigned TimeoutMillis = 10000;
+
+	CMenu* m_pRootMenu;
+	CMenu* m_pMenu;
+	volatile bool m_bOpen;
+	bool m_bEditing;
+	size_t m_nSelectedIndex;
+	size_t m_nScrollOffset;
+	unsigned m_nLastInputTime;
+
+	// Parent menus and their selected items
+	CMenu* m_MenuStack[MaxDepth];
+	size_t m_IndexStack[MaxDepth];
+	size_t m_nDepth;
+
+	// Last drawn row text and rows that need redrawing
+	char m_RowText[MaxRows][RowTextSize];
+	u8 m_nDirtyRows;
+
+	CRingBuffer<TMenuInput, InputQueueSize> m_InputQueue;
+};
+
+#endif
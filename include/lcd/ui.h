@@ -27,6 +27,7 @@
 
 #include "lcd/barchars.h"
 #include "lcd/lcd.h"
+#include "lcd/menu.h"
 
 class CSynthBase;
 
@@ -39,9 +40,23 @@ public:
 		Yamaha,
 	};
 
+	// Widget damage flags
+	enum TWidget : u8
+	{
+		WidgetNone          = 0,
+		WidgetChannelLevels = 1 << 0,
+		WidgetStatusLine    = 1 << 1,
+		WidgetMessage       = 1 << 2,
+		WidgetSysEx         = 1 << 3,
+		WidgetImage         = 1 << 4,
+		WidgetMenu          = 1 << 5,
+		WidgetAll           = 0xFF,
+	};
+
 	CUserInterface();
 
 	void Update(CLCD& LCD, CSynthBase& Synth, unsigned int nTicks);
+	void Invalidate(u8 nWidgets = WidgetAll) { __atomic_fetch_or(&m_nDamage, nWidgets, __ATOMIC_RELEASE); }
 
 	void ShowSystemMessage(const char* pMessage, bool bSpinner = false);
 	void ClearSpinnerMessage();
@@ -51,10 +66,17 @@ public:
 	void EnterPowerSavingMode();
 	void ExitPowerSavingMode();
 
+	void SetRootMenu(CMenu* pMenu) { m_MenuSystem.SetRootMenu(pMenu); }
+	bool IsMenuOpen() const { return m_MenuSystem.IsOpen(); }
+	void QueueMenuInput(TMenuInput Input) { m_MenuSystem.QueueInput(Input); }
+
 	bool IsScrolling() const { return m_bIsScrolling; }
+	bool IsAnimating() const { return m_bIsAnimating; }
+	bool IsDamaged() const { return __atomic_load_n(&m_nDamage, __ATOMIC_ACQUIRE) != WidgetNone; }
 
 	static u8 CenterMessageOffset(CLCD& LCD, const char* pMessage);
 	static void DrawChannelLevels(CLCD& LCD, u8 nBarHeight, float* pChannelLevels, float* pPeakLevels, u8 nChannels, bool bDrawBarBases);
+	static bool QuantizeChannelLevels(const CLCD& LCD, u8 nBarHeight, const float* pChannelLevels, const float* pPeakLevels, u8 nChannels, u8* pLevelPixels, u8* pPeakPixels);
 
 private:
 	enum class TState
@@ -89,6 +111,8 @@ private:
 	TState m_State;
 	unsigned m_nStateTime;
 	bool m_bIsScrolling;
+	bool m_bIsAnimating;
+	u8 m_nDamage;
 	size_t m_nCurrentScrollOffset;
 	size_t m_nCurrentSpinnerChar;
 	TImage m_CurrentImage;
@@ -96,6 +120,9 @@ private:
 	TSysExDisplayMessage m_SysExDisplayMessageType;
 	char m_SysExTextBuffer[SyxExTextBufferSize];
 	u8 m_SysExPixelBuffer[SysExPixelBufferSize];
+
+	// Menu state
+	CMenuSystem m_MenuSystem;
 };
 
 #endif
@@ -25,12 +25,40 @@
 
 #include <circle/types.h>
 
+#include "midistats.h"
+
 class CMIDIParser
 {
+private:
+	enum class TState
+	{
+		StatusByte,
+		DataByte,
+		SysExByte
+	};
+
+	// Matches mt32emu's SysEx buffer size
+	static constexpr size_t SysExBufferSize = 1000;
+
 public:
+	// Parser state for one byte stream; inputs that can interleave need one each so SysEx and running status don't mix
+	struct TStream
+	{
+		TStream();
+
+		TState State;
+		u8 MessageBuffer[SysExBufferSize];
+		size_t nMessageLength;
+		bool bRunningStatus;
+		u32 nErrors;
+	};
+
 	CMIDIParser();
 
-	void ParseMIDIBytes(const u8* pData, size_t nSize, bool bIgnoreNoteOns = false);
+	void ParseMIDIBytes(const u8* pData, size_t nSize, TMIDISource Source, bool bIgnoreNoteOns = false);
+	void ParseMIDIBytes(const u8* pData, size_t nSize, TMIDISource Source, TStream& Stream, bool bIgnoreNoteOns = false);
+
+	const CMIDIStats& GetMIDIStats() const { return m_MIDIStats; }
 
 protected:
 	virtual void OnShortMessage(u32 nMessage) = 0;
@@ -39,25 +67,27 @@ protected:
 	virtual void OnUnexpectedStatus();
 	virtual void OnSysExOverflow();
 
-private:
-	enum class TState
-	{
-		StatusByte,
-		DataByte,
-		SysExByte
-	};
+	// Interface the bytes currently being parsed were received from
+	TMIDISource GetCurrentSource() const { return m_CurrentSource; }
 
-	// Matches mt32emu's SysEx buffer size
-	static constexpr size_t SysExBufferSize = 1000;
+	// True while called back from ParseMIDIBytes()
+	bool IsParsing() const { return m_bParsing; }
 
+	CMIDIStats m_MIDIStats;
+
+private:
 	void ParseStatusByte(u8 nByte);
 	bool CheckCompleteShortMessage(bool bIgnoreNoteOns = false);
 	u32 PrepareShortMessage() const;
 	void ResetState(bool bClearStatusByte);
+	void CountError(CMIDIStats::TParserError Error);
+
+	TMIDISource m_CurrentSource;
+	TStream m_DefaultStream;
 
-	TState m_State;
-	u8 m_MessageBuffer[SysExBufferSize];
-	size_t m_nMessageLength;
+	// Stream the bytes currently being parsed belong to
+	TStream* m_pStream;
+	bool m_bParsing;
 };
 
 #endif
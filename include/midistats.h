@@ -0,0 +1,153 @@
+//
+// midistats.h
+//
+// mt32-pi - A baremetal MIDI synthesizer for Raspberry Pi
+// Copyright (C) 2020-2023 Dale Whinham <daleyo@gmail.com>
+//
+// This file is part of mt32-pi.
+//
+// mt32-pi is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// mt32-pi is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// mt32-pi. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef _midistats_h
+#define _midistats_h
+
+#include <circle/types.h>
+
+enum class TMIDISource : u8
+{
+	Serial,
+	USBSerial,
+	USB,		// All USB MIDI devices and Pisound
+	AppleMIDI,
+	UDPMIDI,
+	Generator,	// Built-in stress generator
+
+	Count,
+};
+
+// Traffic counters maintained by the MIDI parser; written only by the main core, so readers on other cores may see slightly stale values
+class CMIDIStats
+{
+public:
+	enum class TMessageType : u8
+	{
+		NoteOff,
+		NoteOn,
+		PolyPressure,
+		ControlChange,
+		ProgramChange,
+		ChannelPressure,
+		PitchBend,
+		SystemCommon,
+		SystemRealTime,
+		SysEx,
+
+		Count,
+	};
+
+	enum class TParserError : u8
+	{
+		UnexpectedStatus,
+		UnexpectedStatusInSysEx,
+		SysExOverflow,
+
+		Count,
+	};
+
+	static constexpr size_t SysExSizeBucketCount = 4;
+	static constexpr u8 ChannelCount = 16;
+
+	CMIDIStats();
+
+	void Reset();
+
+	// Called by the parser for every byte range and complete message
+	void SetSource(TMIDISource Source, size_t nBytes)
+	{
+		m_Source = Source;
+		m_SourceBytes[static_cast<size_t>(Source)] += nBytes;
+	}
+
+	void CountShortMessage(u8 nStatus, bool bRunningStatus)
+	{
+		++m_SourceMessages[static_cast<size_t>(m_Source)];
+
+		if (nStatus < 0xF0)
+		{
+			++m_MessageTypes[(nStatus >> 4) - 0x8];
+			++m_ChannelMessages[nStatus & 0x0F];
+			++m_nChannelMessages;
+			if (bRunningStatus)
+				++m_nRunningStatusMessages;
+		}
+		else
+			++m_MessageTypes[static_cast<size_t>(nStatus >= 0xF8 ? TMessageType::SystemRealTime : TMessageType::SystemCommon)];
+	}
+
+	void CountSysEx(size_t nSize)
+	{
+		++m_SourceMessages[static_cast<size_t>(m_Source)];
+		++m_MessageTypes[static_cast<size_t>(TMessageType::SysEx)];
+		++m_SysExSizes[nSize <= 16 ? 0 : nSize <= 64 ? 1 : nSize <= 256 ? 2 : 3];
+	}
+
+	void CountError(TParserError Error) { ++m_ParserErrors[static_cast<size_t>(Error)]; }
+
+	// Recalculates per-second rates; call periodically from the main core
+	void Update(unsigned int nTicks);
+
+	u32 GetTotalRate() const { return m_nTotalRate; }
+	u32 GetSourceRate(TMIDISource Source) const { return m_SourceRates[static_cast<size_t>(Source)]; }
+	u32 GetSourceBytes(TMIDISource Source) const { return m_SourceBytes[static_cast<size_t>(Source)]; }
+	u32 GetChannelRate(u8 nChannel) const { return m_ChannelRates[nChannel]; }
+	u32 GetMessageCount(TMessageType Type) const { return m_MessageTypes[static_cast<size_t>(Type)]; }
+	u32 GetSysExSizeCount(size_t nBucket) const { return m_SysExSizes[nBucket]; }
+	u32 GetParserErrorCount(TParserError Error) const { return m_ParserErrors[static_cast<size_t>(Error)]; }
+	u8 GetRunningStatusPercent() const;
+
+	void Dump() const;
+
+	static const char* GetSourceName(TMIDISource Source);
+	static const char* GetMessageTypeName(TMessageType Type);
+	static const char* GetParserErrorName(TParserError Error);
+	static const char* GetSysExSizeBucketName(size_t nBucket);
+
+private:
+	static constexpr size_t SourceCount = static_cast<size_t>(TMIDISource::Count);
+
+	TMIDISource m_Source;
+
+	// Running totals
+	u32 m_SourceBytes[SourceCount];
+	u32 m_SourceMessages[SourceCount];
+	u32 m_ChannelMessages[ChannelCount];
+	u32 m_MessageTypes[static_cast<size_t>(TMessageType::Count)];
+	u32 m_nChannelMessages;
+	u32 m_nRunningStatusMessages;
+	u32 m_SysExSizes[SysExSizeBucketCount];
+	u32 m_ParserErrors[static_cast<size_t>(TParserError::Count)];
+
+	// Totals at the start of the current rate window
+	unsigned int m_nRateWindowStartTime;
+	u32 m_PrevSourceMessages[SourceCount];
+	u32 m_PrevChannelMessages[ChannelCount];
+
+	// Messages per second over the last window
+	u32 m_nTotalRate;
+	u32 m_SourceRates[SourceCount];
+	u32 m_ChannelRates[ChannelCount];
+};
+
+#endif
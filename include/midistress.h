@@ -0,0 +1,98 @@
+//
+// midistress.h
+//
+// mt32-pi - A baremetal MIDI synthesizer for Raspberry Pi
+// Copyright (C) 2020-2023 Dale Whinham <daleyo@gmail.com>
+//
+// This file is part of mt32-pi.
+//
+// mt32-pi is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// mt32-pi is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// mt32-pi. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef _midistress_h
+#define _midistress_h
+
+#include <circle/types.h>
+
+// Synthesizes MIDI traffic for load and latency testing; the output is fed straight into the parser
+class CMIDIStressGenerator
+{
+public:
+	enum class TPattern : u8
+	{
+		Stop,
+		NoteClusters,
+		CCStorm,
+		RunningStatusFlood,
+		MT32TimbreSysEx,
+
+		Count,
+	};
+
+	struct TReport
+	{
+		u32 nBursts;
+		u32 nBytes;
+		u32 nAvgLatenessMicros;
+		u32 nMaxLatenessMicros;
+		u32 nMaxDispatchMicros;
+	};
+
+	CMIDIStressGenerator();
+
+	// nCount is the number of messages per burst, nRate the number of bursts per second, nDuration in seconds (0 = until stopped)
+	void Start(TPattern Pattern, u8 nCount, u8 nRate, u8 nDuration, unsigned int nTicks);
+	void Stop() { m_Pattern = TPattern::Stop; }
+	bool IsRunning() const { return m_Pattern != TPattern::Stop; }
+
+	// Writes the next burst if one is due; returns the number of bytes written
+	size_t Generate(unsigned int nTicks, u8* pOutBuffer, size_t nSize);
+	void AddDispatchTime(unsigned int nMicros);
+
+	// Returns true and fills the report once per reporting period
+	bool TakeReport(unsigned int nTicks, TReport& OutReport);
+
+private:
+	static constexpr unsigned ReportPeriodMillis = 1000;
+
+	// Roland DT1 header + 246 bytes of timbre data + checksum + EOX
+	static constexpr size_t TimbreSysExSize = 8 + 246 + 2;
+
+	static constexpr u8 GetClusterNote(u8 nIndex) { return 24 + (nIndex * 5) % 96; }
+
+	size_t GenerateNoteCluster(u8* pOutBuffer, size_t nSize);
+	size_t ReleaseNoteCluster(u8* pOutBuffer, size_t nSize);
+	size_t GenerateCCStorm(u8* pOutBuffer, size_t nSize);
+	size_t GenerateRunningStatusFlood(u8* pOutBuffer, size_t nSize);
+	size_t GenerateTimbreSysEx(u8* pOutBuffer, size_t nSize);
+
+	TPattern m_Pattern;
+	u8 m_nCount;
+	unsigned int m_nPeriod;
+	unsigned int m_nStartTime;
+	unsigned int m_nDuration;
+	unsigned int m_nNextBurstTime;
+	u32 m_nBurstIndex;
+
+	// Notes held by the previous cluster
+	u8 m_nClusterChannel;
+	u8 m_nClusterSize;
+
+	// Current reporting period
+	unsigned int m_nReportTime;
+	TReport m_Report;
+	u64 m_nTotalLatenessMicros;
+};
+
+#endif
@@ -50,22 +50,31 @@
 #include "config.h"
 #include "control/control.h"
 #include "control/mister.h"
+#include "coremailbox.h"
+#include "coreload.h"
 #include "event.h"
+#include "firmwarestatus.h"
+#include "lcd/mainmenu.h"
 #include "lcd/ui.h"
 #include "midiparser.h"
+#include "midistress.h"
 #include "net/applemidi.h"
 #include "net/ftpdaemon.h"
 #include "net/udpmidi.h"
 #include "pisound.h"
 #include "power.h"
+#include "profilemanager.h"
+#include "renderscheduler.h"
 #include "ringbuffer.h"
+#include "stackmonitor.h"
+#include "sysexfiletransfer.h"
+#include "telemetry.h"
 #include "synth/mt32romset.h"
 #include "synth/mt32synth.h"
+#include "synth/soundfontregistry.h"
 #include "synth/soundfontsynth.h"
 #include "synth/synth.h"
 
-//#define MONITOR_TEMPERATURE
-
 class CMT32Pi : CMultiCoreSupport, CPower, CMIDIParser, CAppleMIDIHandler, CUDPMIDIHandler
 {
 public:
@@ -75,6 +84,7 @@ public:
 	bool Initialize(bool bSerialMIDIAvailable = true);
 
 	virtual void Run(unsigned nCore) override;
+	virtual void IPIHandler(unsigned nCore, unsigned nIPI) override;
 
 private:
 	enum class TLCDLogType
@@ -88,6 +98,10 @@ private:
 
 	static constexpr size_t MIDIRxBufferSize = 2048;
 
+	// Simultaneous USB MIDI devices (keyboards, controllers, sequencers); umidiN device numbers searched
+	static constexpr size_t MaxUSBMIDIDevices = 4;
+	static constexpr unsigned MaxUSBMIDIDeviceNumber = 16;
+
 	// CPower
 	virtual void OnEnterPowerSavingMode() override;
 	virtual void OnExitPowerSavingMode() override;
@@ -101,29 +115,50 @@ private:
 	virtual void OnSysExOverflow() override;
 
 	// CAppleMIDIHandler
-	virtual void OnAppleMIDIDataReceived(const u8* pData, size_t nSize) override { ParseMIDIBytes(pData, nSize); };
+	virtual void OnAppleMIDIDataReceived(const u8* pData, size_t nSize) override { ParseMIDIBytes(pData, nSize, TMIDISource::AppleMIDI); };
 	virtual void OnAppleMIDIConnect(const CIPAddress* pIPAddress, const char* pName) override;
 	virtual void OnAppleMIDIDisconnect(const CIPAddress* pIPAddress, const char* pName) override;
 
 	// CUDPMIDIHandler
-	virtual void OnUDPMIDIDataReceived(const u8* pData, size_t nSize) override { ParseMIDIBytes(pData, nSize); };
+	virtual void OnUDPMIDIDataReceived(const u8* pData, size_t nSize) override { ParseMIDIBytes(pData, nSize, TMIDISource::UDPMIDI); };
 
 	// Initialization
 	bool InitNetwork();
 	bool InitMT32Synth();
 	bool InitSoundFontSynth();
+	void RescanROMs();
+	void RescanSoundFonts();
+	void UpdateMainMenuSynths();
+	void ReportMemoryMap() const;
+	void InitCoreMap();
+	void ReportCoreMap(bool bShowLoad) const;
 
 	// Tasks for specific CPU cores
 	void MainTask();
-	void UITask();
-	void AudioTask();
+	void UITask(unsigned nCore);
+	void AudioTask(unsigned nCore);
+	void RenderHelperTask(unsigned nCore);
+
+	void UpdateUI(unsigned nCore);
+	void StopUI();
 
 	void UpdateUSB(bool bStartup = false);
 	void UpdateNetwork();
 	void UpdateMIDI();
+	void UpdateMIDIStressGenerator();
+	void StartBenchmark();
+	void StartBenchmarkStep();
+	void UpdateBenchmark();
+	void FinishBenchmark();
 	void PurgeMIDIBuffers();
 	size_t ReceiveSerialMIDI(u8* pOutData, size_t nSize);
+	size_t ReceiveUSBMIDI(bool bIgnoreNoteOns);
+	bool IsUSBMIDIConnected() const;
+	void DumpUSBMIDIStats() const;
+	void ResetUSBMIDIStats();
 	bool ParseCustomSysEx(const u8* pData, size_t nSize);
+	void HandleFileTransfer(const u8* pData, size_t nSize);
+	void SendMIDIReply(TMIDISource Source, const u8* pData, size_t nSize);
 
 	void ProcessEventQueue();
 	void ProcessButtonEvent(const TButtonEvent& Event);
@@ -135,6 +170,8 @@ private:
 	void SwitchSoundFont(size_t nIndex);
 	void DeferSwitchSoundFont(size_t nIndex);
 	void SetMasterVolume(s32 nVolume);
+	void ApplyProfile(size_t nIndex);
+	void SoftRestart();
 
 	const char* GetNetworkDeviceShortName() const;
 	void LEDOn();
@@ -163,15 +200,14 @@ private:
 	CAppleMIDIParticipant* m_pAppleMIDIParticipant;
 	CUDPMIDIReceiver* m_pUDPMIDIReceiver;
 	CFTPDaemon* m_pFTPDaemon;
+	CNetMIDIAdmission m_NetMIDIAdmission;
 
 	CBcmRandomNumberGenerator m_Random;
 
 	CLCD* m_pLCD;
 	unsigned m_nLCDUpdateTime;
 	CUserInterface m_UserInterface;
-#ifdef MONITOR_TEMPERATURE
-	unsigned m_nTempUpdateTime;
-#endif
+	CMainMenu* m_pMainMenu;
 
 	CControl* m_pControl;
 
@@ -179,6 +215,24 @@ private:
 	CMisterControl m_MisterControl;
 	unsigned m_nMisterUpdateTime;
 
+	// Soft restart requested via SysEx
+	bool m_bSoftRestartFlag;
+
+	// Standard workload for benchmarking and collecting profile data; the audio core only accumulates timings while running
+	volatile bool m_bBenchmarkRunning;
+	size_t m_nBenchmarkStep;
+	CSynthBase* m_pBenchmarkPreviousSynth;
+	u64 m_nBenchmarkSynthRenderMicros[2];
+	u64 m_nBenchmarkSynthFrames[2];
+	u64 m_nBenchmarkSynthVoiceFrames[2];
+
+	// MIDI buffer purge requested from inside a message handler
+	bool m_bDeferredMIDIPurgeFlag;
+
+	// Rescan after a SysEx file transfer; handled from the main loop
+	bool m_bDeferredROMRescanFlag;
+	bool m_bDeferredSoundFontRescanFlag;
+
 	// Deferred SoundFont switch
 	bool m_bDeferredSoundFontSwitchFlag;
 	size_t m_nDeferredSoundFontSwitchIndex;
@@ -188,8 +242,20 @@ private:
 	bool m_bSerialMIDIAvailable;
 	bool m_bSerialMIDIEnabled;
 
-	// USB devices
-	CUSBMIDIDevice* m_pUSBMIDIDevice;
+	// USB devices; each MIDI device has its own receive buffer and parser state, so interleaved SysEx can't mix
+	struct TUSBMIDIPort
+	{
+		CUSBMIDIDevice* pDevice;
+		unsigned nDeviceNumber;
+		CRingBuffer<u8, MIDIRxBufferSize> RxBuffer;
+		CMIDIParser::TStream ParserStream;
+		u32 nBytes;
+		volatile u32 nPackets;
+		volatile u32 nOverruns;
+	};
+
+	TUSBMIDIPort m_USBMIDIPorts[MaxUSBMIDIDevices];
+	TUSBMIDIPort* m_pUSBMIDIReplyPort;
 	CUSBSerialDevice* m_pUSBSerialDevice;
 	CUSBBulkOnlyMassStorageDevice* volatile m_pUSBMassStorageDevice;
 
@@ -198,11 +264,27 @@ private:
 
 	volatile bool m_bRunning;
 	volatile bool m_bUITaskDone;
+
+	// Core assignments from the [cores] config section
+	unsigned m_nUICore;
+	unsigned m_nAudioCore;
+	unsigned m_nRenderHelperCore;
+	CCoreLoad m_CoreLoad;
+
+	// Splits audio chunk work between the audio and render helper cores
+	CRenderScheduler m_RenderScheduler;
+
+	// Cross-core messages and doorbells
+	CCoreMailbox m_CoreMailbox;
 	bool m_bLEDOn;
 	unsigned m_nLEDOnTime;
 
 	// Audio output
 	CSoundBaseDevice* m_pSound;
+	volatile u32 m_nRenderLoadPeak;
+	volatile u32 m_nBenchmarkRenderMicros;
+	volatile u32 m_nBenchmarkFrames;
+	volatile u32 m_nBenchmarkVoiceFrames;
 
 	// Extra devices
 	CPisound* m_pPisound;
@@ -213,16 +295,43 @@ private:
 	CMT32Synth* m_pMT32Synth;
 	CSoundFontSynth* m_pSoundFontSynth;
 
-	// MIDI receive buffer
+	// Named synth setups from profiles.cfg
+	CProfileManager m_ProfileManager;
+
+	// Pisound MIDI receive buffer
 	CRingBuffer<u8, MIDIRxBufferSize> m_MIDIRxBuffer;
 
+	// Built-in MIDI load generator
+	CMIDIStressGenerator m_MIDIStressGenerator;
+	u8 m_MIDIStressBuffer[MIDIRxBufferSize];
+	CMIDIParser::TStream m_MIDIStressStream;
+
+	// File upload over SysEx
+	CSysExFileTransfer m_SysExFileTransfer;
+	u8 m_nFileTransferPercent;
+
+	// Stack high-water marks
+	CStackMonitor m_StackMonitor;
+
+	// Shares SoundFont data between every FluidSynth instance
+	CSoundFontRegistry m_SoundFontRegistry;
+
+	// Cached throttling/temperature/clock status
+	CFirmwareStatus* m_pFirmwareStatus;
+
+	// Thermal/clock history captured around audio underruns
+	CTelemetry m_Telemetry;
+
 	// Event handling
 	TEventQueue m_EventQueue;
 
 	static void EventHandler(const TEvent& Event);
 	static void USBMIDIDeviceRemovedHandler(CDevice* pDevice, void* pContext);
+	template <size_t nPort>
 	static void USBMIDIPacketHandler(unsigned nCable, u8* pPacket, unsigned nLength);
+	static TMIDIPacketHandler* const USBMIDIPacketHandlers[MaxUSBMIDIDevices];
 	static void IRQMIDIReceiveHandler(const u8* pData, size_t nSize);
+	static void RenderHelperWakeHandler(void* pParam);
 
 	static void PanicHandler();
 
@@ -28,6 +28,8 @@
 #include <circle/net/socket.h>
 #include <circle/sched/task.h>
 
+#include "net/midiadmission.h"
+
 class CAppleMIDIHandler
 {
 public:
@@ -39,7 +41,7 @@ public:
 class CAppleMIDIParticipant : protected CTask
 {
 public:
-	CAppleMIDIParticipant(CBcmRandomNumberGenerator* pRandom, CAppleMIDIHandler* pHandler);
+	CAppleMIDIParticipant(CBcmRandomNumberGenerator* pRandom, CAppleMIDIHandler* pHandler, CNetMIDIAdmission* pAdmission);
 	virtual ~CAppleMIDIParticipant() override;
 
 	bool Initialize();
@@ -85,6 +87,9 @@ private:
 	// Callback handler
 	CAppleMIDIHandler* m_pHandler;
 
+	// Per-peer allowlist/rate limit
+	CNetMIDIAdmission* m_pAdmission;
+
 	// Participant state machine
 	enum class TState
 	{
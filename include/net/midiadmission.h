@@ -0,0 +1,90 @@
+//
+// midiadmission.h
+//
+// mt32-pi - A baremetal MIDI synthesizer for Raspberry Pi
+// Copyright (C) 2020-2023 Dale Whinham <daleyo@gmail.com>
+//
+// This file is part of mt32-pi.
+//
+// mt32-pi is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// mt32-pi is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// mt32-pi. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef _midiadmission_h
+#define _midiadmission_h
+
+#include <circle/net/ipaddress.h>
+#include <circle/types.h>
+
+// Per-peer allowlist and token-bucket rate limit for network MIDI, applied by the socket tasks before parsing
+// Only used from core 0's cooperative tasks, so no locking is needed
+class CNetMIDIAdmission
+{
+public:
+	CNetMIDIAdmission();
+
+	// Comma-separated addresses with optional prefix lengths (e.g. "192.168.1.10, 10.0.0.0/8"); empty allows everyone
+	// Rate limit in bytes per second per peer; 0 disables it
+	void Configure(const char* pAllowlist, unsigned int nRateLimit);
+
+	bool IsAllowed(const CIPAddress& Address) const;
+
+	// Returns false if the packet should be dropped
+	bool Admit(const CIPAddress& Address, size_t nBytes);
+
+	void Dump() const;
+	void ResetStats();
+
+private:
+	static constexpr size_t MaxAllowEntries = 8;
+	static constexpr size_t MaxPeers = 8;
+
+	struct TAllowEntry
+	{
+		u32 nAddress;
+		u32 nMask;
+	};
+
+	struct TPeer
+	{
+		u32 nAddress;
+		unsigned int nLastSeen;
+		u64 nTokens;
+		bool bThrottled;
+		u32 nAcceptedPackets;
+		u32 nAcceptedBytes;
+		u32 nDroppedPackets;
+		u32 nDroppedBytes;
+	};
+
+	static u32 ToHostOrder(const CIPAddress& Address);
+	static void FormatAddress(u32 nAddress, CString& OutString);
+	bool IsAllowed(u32 nAddress) const;
+	TPeer& GetPeer(u32 nAddress, unsigned int nTicks);
+
+	TAllowEntry m_AllowEntries[MaxAllowEntries];
+	size_t m_nAllowEntries;
+
+	// Token bucket in bytes scaled by 1000000, so refill doesn't lose fractions between closely spaced packets
+	u64 m_nRefillPerMicro;
+	u64 m_nBucketSize;
+
+	TPeer m_Peers[MaxPeers];
+	size_t m_nPeers;
+
+	// Peers outside the allowlist are only counted
+	u32 m_nDeniedPackets;
+	u32 m_nLastDeniedAddress;
+};
+
+#endif
@@ -27,6 +27,8 @@
 #include <circle/net/socket.h>
 #include <circle/sched/task.h>
 
+#include "net/midiadmission.h"
+
 class CUDPMIDIHandler
 {
 public:
@@ -36,7 +38,7 @@ public:
 class CUDPMIDIReceiver : protected CTask
 {
 public:
-	CUDPMIDIReceiver(CUDPMIDIHandler* pHandler);
+	CUDPMIDIReceiver(CUDPMIDIHandler* pHandler, CNetMIDIAdmission* pAdmission);
 	virtual ~CUDPMIDIReceiver() override;
 
 	bool Initialize();
@@ -49,9 +51,14 @@ private:
 
 	// Socket receive buffer
 	u8 m_MIDIBuffer[FRAME_BUFFER_SIZE];
+	CIPAddress m_ForeignIPAddress;
+	u16 m_nForeignPort;
 
 	// Callback handler
 	CUDPMIDIHandler* m_pHandler;
+
+	// Per-peer allowlist/rate limit
+	CNetMIDIAdmission* m_pAdmission;
 };
 
 #endif
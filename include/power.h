@@ -23,7 +23,6 @@
 #ifndef _power_h
 #define _power_h
 
-#include <circle/bcmpropertytags.h>
 #include <circle/types.h>
 
 class CPower
@@ -55,7 +54,6 @@ private:
 	unsigned int m_nLastActivityTime;
 	TState m_State;
 
-	CBcmPropertyTags m_Tags;
 	u32 m_LastThrottledStatus;
 };
 
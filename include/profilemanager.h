@@ -0,0 +1,70 @@
+//
+// profilemanager.h
+//
+// mt32-pi - A baremetal MIDI synthesizer for Raspberry Pi
+// Copyright (C) 2020-2023 Dale Whinham <daleyo@gmail.com>
+//
+// This file is part of mt32-pi.
+//
+// mt32-pi is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// mt32-pi is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// mt32-pi. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef _profilemanager_h
+#define _profilemanager_h
+
+#include <circle/string.h>
+#include <circle/types.h>
+
+#include "config.h"
+#include "optional.h"
+#include "synth/fxprofile.h"
+#include "synth/mt32romset.h"
+#include "synth/mt32synth.h"
+
+// A named set of synth settings that can be switched to in one go
+struct TProfile
+{
+	CString Name;
+
+	TOptional<CConfig::TSystemDefaultSynth> Synth;
+	TOptional<int> nVolume;
+
+	TOptional<TMT32ROMSet> MT32ROMSet;
+	TOptional<CMT32Synth::TMIDIChannels> MT32MIDIChannels;
+	TOptional<bool> bMT32ReversedStereo;
+
+	TOptional<int> nSoundFont;
+	TFXProfile FXProfile;
+};
+
+class CProfileManager
+{
+public:
+	CProfileManager();
+
+	bool LoadProfiles(const char* pPath);
+	size_t GetProfileCount() const { return m_nProfiles; }
+	const TProfile* GetProfile(size_t nIndex) const;
+	const char* GetProfileName(size_t nIndex) const;
+
+	static constexpr size_t MaxProfiles = 32;
+
+private:
+	static int INIHandler(void* pUser, const char* pSection, const char* pName, const char* pValue);
+
+	size_t m_nProfiles;
+	TProfile m_Profiles[MaxProfiles];
+};
+
+#endif
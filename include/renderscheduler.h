@@ -0,0 +1,118 @@
+//
+// renderscheduler.h
+//
+// mt32-pi - A baremetal MIDI synthesizer for Raspberry Pi
+// Copyright (C) 2020-2023 Dale Whinham <daleyo@gmail.com>
+//
+// This file is part of mt32-pi.
+//
+// mt32-pi is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// mt32-pi is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// mt32-pi. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef _renderscheduler_h
+#define _renderscheduler_h
+
+#include <circle/sysconfig.h>
+#include <circle/types.h>
+
+// Fork/join job system for splitting each audio chunk across the audio core and a helper core.
+// Jobs are registered once up front; each chunk, the audio core submits job IDs and waits for them all to finish.
+// Every worker owns a deque: it takes jobs from one end, while idle workers steal from the other.
+class CRenderScheduler
+{
+public:
+	using TJobFunction = void (*)(void* pParam);
+	using TWakeHandler = void (*)(void* pParam);
+
+	static constexpr size_t MaxJobs = 16;
+	static constexpr size_t MaxWorkers = CORES - 1;
+	static constexpr size_t InvalidJob = MaxJobs;
+
+	CRenderScheduler();
+
+	// Call before any chunk is run; worker 0 is always the audio core
+	size_t AddJob(const char* pName, TJobFunction pFunction, void* pParam);
+	void SetWorkerCount(size_t nWorkers);
+	size_t GetWorkerCount() const { return m_nWorkers; }
+
+	// Called on the audio core each time a chunk is published, so that sleeping helpers can be woken
+	void SetWakeHandler(TWakeHandler pHandler, void* pParam);
+
+	// Audio core: queue jobs, then run them alongside the helpers; returns false if the deadline was missed
+	void Submit(size_t nJob);
+	bool Run(unsigned nDeadlineClockTicks);
+
+	// Helper cores: call continuously; runs jobs from a newly published chunk and returns the time spent on them
+	unsigned Poll(size_t nWorker);
+
+	void Dump() const;
+	void ResetStats();
+
+private:
+	struct TJob
+	{
+		const char* pName;
+		TJobFunction pFunction;
+		void* pParam;
+
+		// Written by whichever worker ran the job last
+		unsigned nLastTime;
+		unsigned nPeakTime;
+		u64 nTotalTime;
+		u32 nRuns;
+		u8 nLastWorker;
+	};
+
+	// Packed as generation:8 | head:8 | tail:8 so that a stale steal attempt from an earlier chunk can't succeed
+	struct TDeque
+	{
+		u32 nState;
+		u8 Jobs[MaxJobs];
+	};
+
+	void BeginChunk();
+	size_t Pop(size_t nWorker);
+	size_t Steal(size_t nThief);
+	void Execute(size_t nWorker, size_t nJob);
+	void WorkUntilEmpty(size_t nWorker);
+
+	TJob m_Jobs[MaxJobs];
+	size_t m_nJobs;
+	size_t m_nWorkers;
+	TWakeHandler m_pWakeHandler;
+	void* m_pWakeParam;
+
+	TDeque m_Deques[MaxWorkers];
+	size_t m_nNextWorker;
+	u8 m_nGeneration;
+	bool m_bChunkOpen;
+
+	// Chunk state shared with the helpers
+	u32 m_nChunk;
+	u32 m_nPendingJobs;
+	u32 m_nSeenChunk[MaxWorkers];
+	unsigned m_nWorkerBusyTime[MaxWorkers];
+
+	// Statistics; written by the audio core except for the steal count
+	u32 m_nChunks;
+	u32 m_nSteals;
+	u32 m_nDeadlineMisses;
+	unsigned m_nPeakChunkTime;
+	u8 m_nImbalance;
+	u8 m_nPeakImbalance;
+	u64 m_nImbalanceTotal;
+	u32 m_nImbalanceChunks;
+};
+
+#endif
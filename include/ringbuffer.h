@@ -97,6 +97,9 @@ public:
 		return nDequeued;
 	}
 
+	// Approximate when other cores are enqueuing/dequeuing concurrently
+	size_t GetCount() const { return (m_nInPtr - m_nOutPtr) & BufferMask; }
+
 private:
 	static_assert(Utility::IsPowerOfTwo(N), "Ring buffer size must be a power of 2");
 
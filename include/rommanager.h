@@ -23,6 +23,7 @@
 #ifndef _rommanager_h
 #define _rommanager_h
 
+#include <circle/string.h>
 #include <mt32emu/mt32emu.h>
 
 #include "synth/mt32romset.h"
@@ -35,11 +36,20 @@ public:
 
 	bool ScanROMs();
 	bool HaveROMSet(TMT32ROMSet ROMSet) const;
-	bool GetROMSet(TMT32ROMSet ROMSet, TMT32ROMSet& pOutROMSet, const MT32Emu::ROMImage*& pOutControl, const MT32Emu::ROMImage*& pOutPCM) const;
+	bool GetROMSet(TMT32ROMSet ROMSet, TMT32ROMSet& pOutROMSet, const MT32Emu::ROMImage*& pOutControl, const MT32Emu::ROMImage*& pOutPCM);
+
+	// Frees PCM ROM images in low-memory builds once a synth has been opened with them
+	void ReleasePCMROMs();
+	size_t GetResidentSize() const;
 
 private:
+	bool HaveMT32PCM() const { return m_MT32PCMPath.GetLength() > 0; }
+	bool HaveCM32LPCM() const { return m_CM32LPCMPath.GetLength() > 0; }
+
+	static const MT32Emu::ROMImage* LoadROM(const char* pPath);
+	static void FreeROM(const MT32Emu::ROMImage*& pROMImage);
 	bool CheckROM(const char* pPath);
-	bool StoreROM(const MT32Emu::ROMImage& ROMImage);
+	bool StoreROM(const MT32Emu::ROMImage& ROMImage, const char* pPath);
 
 	// Control ROMs
 	const MT32Emu::ROMImage* m_pMT32OldControl;
@@ -49,6 +59,8 @@ private:
 	// PCM ROMs
 	const MT32Emu::ROMImage* m_pMT32PCM;
 	const MT32Emu::ROMImage* m_pCM32LPCM;
+	CString m_MT32PCMPath;
+	CString m_CM32LPCMPath;
 };
 
 #endif
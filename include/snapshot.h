@@ -0,0 +1,72 @@
+//
+// snapshot.h
+//
+// mt32-pi - A baremetal MIDI synthesizer for Raspberry Pi
+// Copyright (C) 2020-2023 Dale Whinham <daleyo@gmail.com>
+//
+// This file is part of mt32-pi.
+//
+// mt32-pi is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// mt32-pi is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// mt32-pi. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef _snapshot_h
+#define _snapshot_h
+
+#include <circle/types.h>
+
+// Single-writer, multiple-reader snapshot of a trivially copyable value (sequence lock)
+// The writer never blocks; readers retry if they raced with a write
+template <class T>
+class CSnapshot
+{
+public:
+	CSnapshot()
+		: m_nSequence(0),
+		  m_Value{}
+	{
+	}
+
+	void Publish(const T& Value)
+	{
+		// Odd sequence number marks a write in progress
+		__atomic_store_n(&m_nSequence, m_nSequence + 1, __ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_RELEASE);
+
+		m_Value = Value;
+
+		__atomic_store_n(&m_nSequence, m_nSequence + 1, __ATOMIC_RELEASE);
+	}
+
+	// Returns the sequence number of the copied value; 0 if nothing has been published yet
+	u32 Read(T& OutValue) const
+	{
+		u32 nBefore, nAfter;
+
+		do
+		{
+			nBefore = __atomic_load_n(&m_nSequence, __ATOMIC_ACQUIRE);
+			OutValue = m_Value;
+			__atomic_thread_fence(__ATOMIC_ACQUIRE);
+			nAfter = __atomic_load_n(&m_nSequence, __ATOMIC_RELAXED);
+		} while ((nBefore & 1) || nBefore != nAfter);
+
+		return nBefore / 2;
+	}
+
+private:
+	u32 m_nSequence;
+	T m_Value;
+};
+
+#endif
@@ -24,6 +24,7 @@
 #define _soundfontmanager_h
 
 #include <circle/string.h>
+#include <circle/types.h>
 
 #include "synth/fxprofile.h"
 
@@ -40,7 +41,18 @@ public:
 	TFXProfile GetSoundFontFXProfile(size_t nIndex) const;
 	const char* GetFirstValidSoundFontPath() const;
 
+	// Finds the MIDI controllers used as sources by a SoundFont's preset and instrument modulators
+	static bool GetModulatorControllers(const char* pPath, u32 OutControllerMask[4], size_t& nOutModulators);
+
+	// Also parses effects overrides in game profiles
+	static int INIHandler(void* pUser, const char* pSection, const char* pName, const char* pValue);
+
+#ifdef LOW_MEMORY
+	// Saves heap for SoundFont samples; the menu can select any entry, custom SysEx and MiSTer only the first 128
+	static constexpr size_t MaxSoundFonts = 128;
+#else
 	static constexpr size_t MaxSoundFonts = 512;
+#endif
 
 private:
 	struct TSoundFontListEntry
@@ -56,7 +68,6 @@ private:
 	size_t m_nSoundFonts;
 	TSoundFontListEntry m_SoundFontList[MaxSoundFonts];
 
-	static int INIHandler(void* pUser, const char* pSection, const char* pName, const char* pValue);
 	inline static bool SoundFontListComparator(const TSoundFontListEntry& lhs, const TSoundFontListEntry& rhs);
 };
 
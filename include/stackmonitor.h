@@ -0,0 +1,82 @@
+//
+// stackmonitor.h
+//
+// mt32-pi - A baremetal MIDI synthesizer for Raspberry Pi
+// Copyright (C) 2020-2023 Dale Whinham <daleyo@gmail.com>
+//
+// This file is part of mt32-pi.
+//
+// mt32-pi is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// mt32-pi is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// mt32-pi. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef _stackmonitor_h
+#define _stackmonitor_h
+
+#include <circle/multicore.h>
+#include <circle/sched/task.h>
+#include <circle/types.h>
+
+// Measures stack high-water marks by filling unused stack with a pattern and checking how much of it has been overwritten
+class CStackMonitor
+{
+public:
+	// Registers the calling scheduler task for the lifetime of this object; declare at the top of CTask::Run()
+	class CTaskScope
+	{
+	public:
+		CTaskScope(const char* pName, const CTask* pTask);
+		~CTaskScope();
+
+	private:
+		size_t m_nIndex;
+	};
+
+	static constexpr size_t MaxTasks = 8;
+
+	CStackMonitor();
+
+	// Call on each core before it does any real work
+	void PaintCoreStack(unsigned nCore);
+
+	// Called periodically by the main core; warns when a stack gets close to its limit
+	void Update(unsigned int nTicks);
+	void Dump() const;
+
+	static CStackMonitor* Get() { return s_pThis; }
+
+private:
+	static constexpr size_t RegionCount = CORES + MaxTasks;
+
+	struct TStackRegion
+	{
+		const char* pName;
+		uintptr nBottom;
+		size_t nSize;
+		size_t nPaintedSize;
+		size_t nPeak;
+		u8 nWarnedPercent;
+	};
+
+	size_t AddTask(const char* pName, const CTask* pTask);
+	void RemoveTask(size_t nIndex);
+	static void Paint(uintptr nStart, uintptr nEnd);
+	static size_t Measure(const TStackRegion& Region);
+
+	TStackRegion m_Regions[RegionCount];
+	unsigned int m_nLastUpdateTime;
+
+	static CStackMonitor* s_pThis;
+};
+
+#endif
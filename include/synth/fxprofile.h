@@ -24,22 +24,57 @@
 #define _fxprofile_h
 
 #include "optional.h"
+#include "utility.h"
+
+// FluidSynth's own effects, or cheaper ones (see lightreverb.h)
+#define ENUM_REVERBENGINE(ENUM)      \
+	ENUM(FluidSynth, fluidsynth) \
+	ENUM(Light, light)
+
+#define ENUM_CHORUSENGINE(ENUM)      \
+	ENUM(FluidSynth, fluidsynth) \
+	ENUM(Light, light)
+
+CONFIG_ENUM(TReverbEngine, ENUM_REVERBENGINE);
+CONFIG_ENUM(TChorusEngine, ENUM_CHORUSENGINE);
 
 struct TFXProfile
 {
 	TOptional<float> nGain;
 
 	TOptional<bool> bReverbActive;
+	TOptional<TReverbEngine> ReverbEngine;
 	TOptional<float> nReverbDamping;
 	TOptional<float> nReverbLevel;
 	TOptional<float> nReverbRoomSize;
 	TOptional<float> nReverbWidth;
 
 	TOptional<bool> bChorusActive;
+	TOptional<TChorusEngine> ChorusEngine;
 	TOptional<float> nChorusDepth;
 	TOptional<float> nChorusLevel;
 	TOptional<int> nChorusVoices;
 	TOptional<float> nChorusSpeed;
+
+	// Override with any values set in another profile
+	void Merge(const TFXProfile& Other)
+	{
+		#define MERGE(MEMBER) if (Other.MEMBER) MEMBER = Other.MEMBER
+		MERGE(nGain);
+		MERGE(bReverbActive);
+		MERGE(ReverbEngine);
+		MERGE(nReverbDamping);
+		MERGE(nReverbLevel);
+		MERGE(nReverbRoomSize);
+		MERGE(nReverbWidth);
+		MERGE(bChorusActive);
+		MERGE(ChorusEngine);
+		MERGE(nChorusDepth);
+		MERGE(nChorusLevel);
+		MERGE(nChorusVoices);
+		MERGE(nChorusSpeed);
+		#undef MERGE
+	}
 };
 
 #endif
@@ -0,0 +1,86 @@
+//
+// lightreverb.h
+//
+// mt32-pi - A baremetal MIDI synthesizer for Raspberry Pi
+// Copyright (C) 2020-2023 Dale Whinham <daleyo@gmail.com>
+//
+// This file is part of mt32-pi.
+//
+// mt32-pi is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// mt32-pi is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// mt32-pi. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef _lightreverb_h
+#define _lightreverb_h
+
+#include <circle/types.h>
+
+// Schroeder/Freeverb-style reverb with 4 combs and 2 allpasses per channel, for use as a cheaper alternative to FluidSynth's FDN reverb
+// Runs on the final stereo mix, so per-channel reverb sends (CC 91) are not taken into account
+class CLightReverb
+{
+public:
+	struct TParameters
+	{
+		bool bEnabled;
+		float nRoomSize;
+		float nDamping;
+		float nWidth;
+		float nLevel;
+	};
+
+	CLightReverb();
+	~CLightReverb();
+
+	bool Initialize(unsigned int nSampleRate);
+	void SetParameters(const TParameters& Parameters);
+	bool IsEnabled() const { return m_Parameters.bEnabled; }
+
+	// Adds reverb to an interleaved stereo buffer
+	void Process(float* pBuffer, size_t nFrames);
+	void Process(s16* pBuffer, size_t nFrames);
+
+private:
+	static constexpr size_t CombCount = 4;
+	static constexpr size_t AllpassCount = 2;
+	static constexpr size_t DelayCount = (CombCount + AllpassCount) * 2;
+
+	struct TDelay
+	{
+		size_t nOffset;
+		size_t nLength;
+		size_t nIndex;
+	};
+
+	void Clear();
+
+	template <class TSample>
+	void ProcessSamples(TSample* pBuffer, size_t nFrames);
+
+	TParameters m_Parameters;
+
+	// Delay lines share one allocation; left channel delays first, then right
+	u8* m_pMemory;
+	TDelay m_Delays[DelayCount];
+
+	// Comb lowpass state, per channel
+	float m_CombStates[2][CombCount];
+
+	float m_nFeedback;
+	float m_nDamping;
+	float m_nInputGain;
+	float m_nWet1;
+	float m_nWet2;
+};
+
+#endif
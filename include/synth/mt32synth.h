@@ -56,17 +56,23 @@ public:
 	virtual bool Initialize() override;
 	virtual void HandleMIDIShortMessage(u32 nMessage) override;
 	virtual void HandleMIDISysExMessage(const u8* pData, size_t nSize) override;
-	virtual bool IsActive() override { return m_pSynth->isActive(); }
 	virtual void AllSoundOff() override;
+	virtual void Reset() override;
 	virtual void SetMasterVolume(u8 nVolume) override;
 	virtual size_t Render(s16* pBuffer, size_t nFrames) override;
 	virtual size_t Render(float* pBuffer, size_t nFrames) override;
 	virtual void ReportStatus() const override;
+	virtual u8 UpdateLCDState(const CLCD& LCD, unsigned int nTicks) override;
 	virtual void UpdateLCD(CLCD& LCD, unsigned int nTicks) override;
 
 	void SetMIDIChannels(TMIDIChannels Channels);
 	void SetReversedStereo(bool bEnabled) { m_pSynth->setReversedStereoEnabled(bEnabled); }
 	bool SwitchROMSet(TMT32ROMSet ROMSet);
+
+	// Open a standby synth with another ROM set, then swap it in at a chunk boundary
+	bool PrepareROMSet(TMT32ROMSet ROMSet);
+	bool CommitROMSet();
+	void DiscardStandby();
 	bool NextROMSet();
 	TMT32ROMSet GetROMSet() const;
 	const char* GetControlROMName() const;
@@ -74,13 +80,20 @@ public:
 
 	u8 GetMasterVolume() const;
 
+	// Counting sounding partials walks every partial after each chunk, so it's only done while the benchmark wants it
+	void SetPartialCounting(bool bEnabled) { m_bCountPartials = bEnabled; }
+
 private:
 	static constexpr size_t MT32ChannelCount = 9;
+	static constexpr u32 MaxPartials = 256;
 
 	// N characters plus null terminator
-	static constexpr size_t LCDTextBufferSize = 20 + 1;
+	static constexpr size_t LCDTextBufferSize = sizeof(TSynthStatus::DisplayText);
 
-	void GetPartLevels(unsigned int nTicks, float PartLevels[9], float PartPeaks[9]);
+	MT32Emu::SampleRateConverter* CreateSampleRateConverter(MT32Emu::Synth& Synth) const;
+	void PublishStatus();
+	void GetPartLevels(unsigned int nTicks, const u8 MIDIChannelPartMap[9], float PartLevels[9], float PartPeaks[9]);
+	static void GetLCDLayout(const CLCD& LCD, u8& nStatusRow, u8& nBarHeight, bool& bNarrowPartStateText);
 
 	// MT32Emu::ReportHandler
 	virtual bool onMIDIQueueOverflow() override;
@@ -92,20 +105,32 @@ private:
 	static const u8 AlternateMIDIChannelsSysEx[];
 
 	MT32Emu::Synth* m_pSynth;
+	MT32Emu::Synth* m_pStandbySynth;
 
 	float m_nGain;
 	float m_nReverbGain;
 
 	TResamplerQuality m_ResamplerQuality;
 	MT32Emu::SampleRateConverter* m_pSampleRateConverter;
+	MT32Emu::SampleRateConverter* m_pStandbySampleRateConverter;
 
 	CROMManager m_ROMManager;
 	TMT32ROMSet m_CurrentROMSet;
 	const MT32Emu::ROMImage* m_pControlROMImage;
-	const MT32Emu::ROMImage* m_pPCMROMImage;
+
+	bool m_bStandbyReady;
+	TMT32ROMSet m_StandbyROMSet;
+	const MT32Emu::ROMImage* m_pStandbyControlROMImage;
 
 	// LCD state
 	char m_LCDTextBuffer[LCDTextBufferSize];
+	volatile bool m_bNarrowPartStateText;
+
+	// Audio core's copy of the published status; part states and display text are only refreshed when the UI asks
+	TSynthStatus m_Status;
+	volatile bool m_bStatusDetailRequested;
+	volatile bool m_bCountPartials;
+	MT32Emu::PartialState m_PartialStates[MaxPartials];
 };
 
 #endif
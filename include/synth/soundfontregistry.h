@@ -0,0 +1,95 @@
+//
+// soundfontregistry.h
+//
+// mt32-pi - A baremetal MIDI synthesizer for Raspberry Pi
+// Copyright (C) 2020-2023 Dale Whinham <daleyo@gmail.com>
+//
+// This file is part of mt32-pi.
+//
+// mt32-pi is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// mt32-pi is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// mt32-pi. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef _soundfontregistry_h
+#define _soundfontregistry_h
+
+#include <circle/string.h>
+#include <circle/types.h>
+
+#include <fluidsynth.h>
+
+// Keeps each loaded SoundFont in memory once, no matter how many FluidSynth instances use it
+// Each SoundFont is loaded into its own silent owner synth; other synths get lightweight wrappers through a custom loader
+// Not thread-safe; SoundFonts must be loaded and synths deleted from the same core
+class CSoundFontRegistry
+{
+public:
+	CSoundFontRegistry();
+	~CSoundFontRegistry();
+
+	bool Initialize(unsigned int nSampleRate);
+
+	// Installs the shared loader; SoundFonts loaded by this synth afterwards come from the registry
+	void AddLoader(fluid_synth_t* pSynth);
+
+	size_t GetSharedCount() const;
+
+	static CSoundFontRegistry* Get() { return s_pThis; }
+
+private:
+	static constexpr size_t MaxEntries = 4;
+
+	struct TEntry
+	{
+		CSoundFontRegistry* pRegistry;
+		CString Path;
+		u32 nFileSize;
+		u32 nFileTimestamp;
+		fluid_synth_t* pOwnerSynth;
+		fluid_sfont_t* pSoundFont;
+		size_t nPresetCount;
+		unsigned int nRefCount;
+	};
+
+	// One per synth using an entry; its presets wrap the shared ones so that FluidSynth's bookkeeping refers to it
+	struct TWrapper
+	{
+		TEntry* pEntry;
+		fluid_preset_t** pPresets;
+		size_t nPresetCount;
+		size_t nIterationIndex;
+	};
+
+	TEntry* Acquire(const char* pPath);
+	void Release(TEntry* pEntry);
+
+	static fluid_sfont_t* LoadCallback(fluid_sfloader_t* pLoader, const char* pPath);
+	static const char* GetNameCallback(fluid_sfont_t* pSoundFont);
+	static fluid_preset_t* GetPresetCallback(fluid_sfont_t* pSoundFont, int nBank, int nProgram);
+	static void IterationStartCallback(fluid_sfont_t* pSoundFont);
+	static fluid_preset_t* IterationNextCallback(fluid_sfont_t* pSoundFont);
+	static int FreeCallback(fluid_sfont_t* pSoundFont);
+
+	static const char* GetPresetNameCallback(fluid_preset_t* pPreset);
+	static int GetPresetBankCallback(fluid_preset_t* pPreset);
+	static int GetPresetNumberCallback(fluid_preset_t* pPreset);
+	static int PresetNoteOnCallback(fluid_preset_t* pPreset, fluid_synth_t* pSynth, int nChannel, int nKey, int nVelocity);
+
+	fluid_settings_t* m_pSettings;
+	TEntry m_Entries[MaxEntries];
+	unsigned int m_nNextVoiceGroup;
+
+	static CSoundFontRegistry* s_pThis;
+};
+
+#endif
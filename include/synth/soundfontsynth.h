@@ -27,13 +27,77 @@
 
 #include <fluidsynth.h>
 
+#include "snapshot.h"
 #include "soundfontmanager.h"
 #include "synth/fxprofile.h"
+#include "synth/lightreverb.h"
 #include "synth/synthbase.h"
+#include "utility.h"
+
+// Voice usage published by the audio core after each rendered chunk
+struct TVoiceStats
+{
+	static constexpr size_t MaxPresets = 16;
+
+	struct TPresetPeak
+	{
+		u16 nBank;
+		u8 nProgram;
+		u16 nPeakVoices;
+	};
+
+	u16 nPolyphony;
+	u16 nActiveVoices;
+	u16 nPeakVoices;
+	u16 ChannelVoices[16];
+	u32 ChannelSteals[16];
+	u32 nEndedVoices;
+	u32 nAvgLifetimeMillis;
+	size_t nPresets;
+	TPresetPeak Presets[MaxPresets];
+};
+
+// Adaptive interpolation state published by the audio core after each rendered chunk
+struct TInterpolationStats
+{
+	static constexpr size_t LevelCount = 3;
+
+	u8 nLevel;
+	u8 nLoad;
+	u32 nLevelChanges;
+	u32 LevelChunks[LevelCount];
+};
+
+// Cost of the light effects engines, published by the audio core while they are in use
+struct TEffectsStats
+{
+	u64 nReverbMicros;
+	u64 nReverbFrames;
+};
+
+// Controller message handling, published by the audio core after each rendered chunk
+struct TControllerStats
+{
+	u32 nReceived;
+	u32 nApplied;
+	u32 nCoalesced;
+	u32 nRedundant;
+	u32 nUnused;
+	u64 nControlMicros;
+};
 
 class CSoundFontSynth : public CSynthBase
 {
 public:
+	#define ENUM_INTERPOLATION(ENUM) \
+		ENUM(Adaptive, adaptive)     \
+		ENUM(None, none)             \
+		ENUM(Linear, linear)         \
+		ENUM(FourthOrder, 4thorder)  \
+		ENUM(SeventhOrder, 7thorder)
+
+	CONFIG_ENUM(TInterpolation, ENUM_INTERPOLATION);
+
 	CSoundFontSynth(unsigned nSampleRate);
 	virtual ~CSoundFontSynth() override;
 
@@ -41,21 +105,67 @@ public:
 	virtual bool Initialize() override;
 	virtual void HandleMIDIShortMessage(u32 nMessage) override;
 	virtual void HandleMIDISysExMessage(const u8* pData, size_t nSize) override;
-	virtual bool IsActive() override;
 	virtual void AllSoundOff() override;
+	virtual void Reset() override;
 	virtual void SetMasterVolume(u8 nVolume) override;
 	virtual size_t Render(s16* pOutBuffer, size_t nFrames) override;
 	virtual size_t Render(float* pOutBuffer, size_t nFrames) override;
 	virtual void ReportStatus() const override;
+	virtual u8 UpdateLCDState(const CLCD& LCD, unsigned int nTicks) override;
 	virtual void UpdateLCD(CLCD& LCD, unsigned int nTicks) override;
 
-	bool SwitchSoundFont(size_t nIndex);
+	bool SwitchSoundFont(size_t nIndex, const TFXProfile* pFXOverrides = nullptr);
+
+	// Load a SoundFont into a standby synth while the current one keeps playing, then swap it in at a chunk boundary
+	bool PrepareSoundFont(size_t nIndex, const TFXProfile* pFXOverrides = nullptr);
+	bool CommitSoundFont();
+	void DiscardStandby();
 	size_t GetSoundFontIndex() const { return m_nCurrentSoundFontIndex; }
 	CSoundFontManager& GetSoundFontManager() { return m_SoundFontManager; }
 
+	// The list is re-sorted by a rescan, so the current SoundFont is found again by path
+	bool RescanSoundFonts();
+
+	// Current SoundFont is still loaded but no longer in the list (e.g. USB disk removed)
+	static constexpr size_t NoSoundFontIndex = static_cast<size_t>(-1);
+
+	// Voice accounting (if enabled in config); safe to call from any core
+	bool IsVoiceStatsEnabled() const { return m_pVoiceTable != nullptr; }
+	void GetVoiceStats(TVoiceStats& OutStats) const { m_VoiceStatsSnapshot.Read(OutStats); }
+	void ResetVoiceStats() { m_bVoiceStatsResetRequested = true; }
+	void DumpVoiceStats() const;
+
+	// Adaptive interpolation; safe to call from any core
+	void ResetInterpolationStats() { m_bInterpolationStatsResetRequested = true; }
+	void DumpInterpolationStats() const;
+
+	// Light effects engine cost; safe to call from any core
+	void ResetEffectsStats() { m_bEffectsStatsResetRequested = true; }
+	void DumpEffectsStats() const;
+
+	// Controller fast path; safe to call from any core
+	void ResetControllerStats() { m_bControllerStatsResetRequested = true; }
+	void DumpControllerStats() const;
+
 private:
 	bool Reinitialize(const char* pSoundFontPath, const TFXProfile* pFXProfile);
+	fluid_synth_t* CreateSynth(const TFXProfile* pFXProfile, float& nOutInitialGain, CLightReverb::TParameters& OutReverbParameters);
+	float ApplyFXProfile(fluid_synth_t* pSynth, const TFXProfile* pFXProfile, CLightReverb::TParameters& OutReverbParameters);
+	static bool LoadSoundFont(fluid_synth_t* pSynth, const char* pSoundFontPath);
 	void ResetMIDIMonitor();
+	void UpdateVoiceStats();
+	void PublishStatus();
+	void ClearVoiceTable();
+	void UpdateInterpolation(unsigned int nRenderMicros, size_t nFrames);
+	void ApplyInterpolation();
+	void UpdateEffectsStats(unsigned int nReverbMicros, size_t nFrames);
+	static void GetModulatedControllers(const char* pSoundFontPath, u32 OutControllerMask[4]);
+	bool DeferController(u8 nType, u8 nChannel, u8 nData1, u8 nData2);
+	void FlushControllers(u8 nChannel);
+	void FlushControllers();
+	void ClearControllers();
+	void InvalidateControllers(u8 nChannel);
+	void UpdateControllerStats();
 #ifndef NDEBUG
 	void DumpFXSettings() const;
 #endif
@@ -65,6 +175,7 @@ private:
 
 	fluid_settings_t* m_pSettings;
 	fluid_synth_t* m_pSynth;
+	fluid_synth_t* m_pStandbySynth;
 
 	u8 m_nVolume;
 	float m_nInitialGain;
@@ -72,8 +183,79 @@ private:
 	u16 m_nPercussionMask;
 	size_t m_nCurrentSoundFontIndex;
 
+	bool m_bStandbyIsCurrent;
+	size_t m_nStandbySoundFontIndex;
+	float m_nStandbyInitialGain;
+	TFXProfile m_StandbyFXProfile;
+	CLightReverb::TParameters m_StandbyReverbParameters;
+
+	// Replaces FluidSynth's reverb when a light engine is selected
+	CLightReverb m_LightReverb;
+	volatile bool m_bEffectsStatsResetRequested;
+	TEffectsStats m_EffectsStats;
+	CSnapshot<TEffectsStats> m_EffectsStatsSnapshot;
+
 	CSoundFontManager m_SoundFontManager;
 
+	// Voice accounting; voices are tracked by their slot in FluidSynth's fixed voice pool
+	struct TTrackedVoice
+	{
+		const fluid_voice_t* pVoice;
+		unsigned int nID;
+		unsigned int nStartTime;
+		u32 nLastSeenChunk;
+		u8 nChannel;
+		bool bOn;
+		bool bActive;
+	};
+
+	TTrackedVoice* FindTrackedVoice(const fluid_voice_t* pVoice);
+	void EndTrackedVoice(TTrackedVoice& Voice, unsigned int nTicks);
+
+	fluid_voice_t** m_pVoiceList;
+	TTrackedVoice* m_pVoiceTable;
+	size_t m_nVoiceTableMask;
+	u32 m_nVoiceStatsChunk;
+	u64 m_nTotalLifetime;
+	volatile bool m_bVoiceStatsResetRequested;
+	TVoiceStats m_VoiceStats;
+	CSnapshot<TVoiceStats> m_VoiceStatsSnapshot;
+
+	// Interpolation methods are per channel and only affect new voices; adaptive mode lowers them under load
+	TInterpolation m_InterpolationMode;
+	bool m_bInterpolationApplied;
+	u16 m_nInterpolationPercussionMask;
+	u8 m_nAppliedInterpolationLevel;
+	unsigned int m_nInterpolationChangeTime;
+	unsigned int m_nInterpolationHeadroomTime;
+	volatile bool m_bInterpolationStatsResetRequested;
+	TInterpolationStats m_InterpolationStats;
+	CSnapshot<TInterpolationStats> m_InterpolationStatsSnapshot;
+
+	// Controllers that only feed modulators are held back until the next event on their channel or the next chunk,
+	// so FluidSynth updates its voices once with the latest value instead of once per message
+	struct TChannelControllers
+	{
+		u32 PendingMask[4];
+		u8 Values[128];
+		u8 AppliedValues[128];
+		u16 nPitchBend;
+		u16 nAppliedPitchBend;
+		u8 nPressure;
+		u8 nAppliedPressure;
+		bool bPitchBendPending;
+		bool bPressurePending;
+	};
+
+	bool m_bControllerFastPath;
+	u32 m_ModulatedControllers[4];
+	u32 m_StandbyModulatedControllers[4];
+	u16 m_nPendingControllerChannels;
+	TChannelControllers m_ChannelControllers[16];
+	volatile bool m_bControllerStatsResetRequested;
+	TControllerStats m_ControllerStats;
+	CSnapshot<TControllerStats> m_ControllerStatsSnapshot;
+
 	static void FluidSynthLogCallback(int nLevel, const char* pMessage, void* pUser);
 };
 
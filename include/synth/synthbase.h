@@ -29,6 +29,18 @@
 #include "lcd/lcd.h"
 #include "lcd/ui.h"
 #include "midimonitor.h"
+#include "snapshot.h"
+
+// Synth state published by the audio core after each chunk, so that other cores can read it without taking the synth lock
+struct TSynthStatus
+{
+	bool bActive;
+	u8 nMasterVolume;
+	u16 nActiveVoices;		// FluidSynth voices or MT-32 partials
+	u16 nPartStates;		// MT-32 only; one bit per part with notes playing
+	u8 MIDIChannelPartMap[9];	// MT-32 only
+	char DisplayText[20 + 1];	// MT-32 only
+};
 
 class CSynthBase
 {
@@ -36,28 +48,77 @@ public:
 	CSynthBase(unsigned int nSampleRate)
 		: m_Lock(TASK_LEVEL),
 		  m_nSampleRate(nSampleRate),
-		  m_pUI(nullptr)
+		  m_pUI(nullptr),
+		  m_LCDLevels{0.0f},
+		  m_LCDPeaks{0.0f},
+		  m_LCDLevelPixels{0},
+		  m_LCDPeakPixels{0},
+		  m_bLCDLevelsActive(false)
 	{
 	}
 
 	virtual ~CSynthBase() = default;
 
 	virtual bool Initialize() = 0;
-	virtual void HandleMIDIShortMessage(u32 nMessage) { m_MIDIMonitor.OnShortMessage(nMessage); };
+	virtual void HandleMIDIShortMessage(u32 nMessage)
+	{
+		m_MIDIMonitor.OnShortMessage(nMessage);
+
+		// Wake the UI up from its idle frame rate so new notes show up promptly
+		if (m_pUI && (nMessage & 0xF0) == 0x90)
+			m_pUI->Invalidate(CUserInterface::WidgetChannelLevels);
+	};
 	virtual void HandleMIDISysExMessage(const u8* pData, size_t nSize) = 0;
-	virtual bool IsActive() = 0;
 	virtual void AllSoundOff() { m_MIDIMonitor.AllNotesOff(); };
+
+	// Return to the power-on state, keeping ROMs/SoundFonts loaded
+	virtual void Reset() = 0;
 	virtual void SetMasterVolume(u8 nVolume) = 0;
 	virtual size_t Render(s16* pOutBuffer, size_t nFrames) = 0;
 	virtual size_t Render(float* pOutBuffer, size_t nFrames) = 0;
 	virtual void ReportStatus() const = 0;
+	virtual u8 UpdateLCDState(const CLCD& LCD, unsigned int nTicks) = 0;
 	virtual void UpdateLCD(CLCD& LCD, unsigned int nTicks) = 0;
+	bool IsLCDAnimating() const { return m_bLCDLevelsActive; }
 	void SetUserInterface(CUserInterface* pUI) { m_pUI = pUI; }
 
+	// As of the last rendered chunk
+	TSynthStatus GetStatus() const
+	{
+		TSynthStatus Status;
+		m_StatusSnapshot.Read(Status);
+		return Status;
+	}
+	bool IsActive() const { return GetStatus().bActive; }
+
 	CSpinLock m_Lock;
 	unsigned int m_nSampleRate;
 	CMIDIMonitor m_MIDIMonitor;
 	CUserInterface* m_pUI;
+
+protected:
+	// Quantizes the sampled levels and returns level meter damage
+	u8 UpdateLCDLevels(const CLCD& LCD, u8 nBarHeight, u8 nChannels)
+	{
+		m_bLCDLevelsActive = false;
+		for (u8 nChannel = 0; nChannel < nChannels; ++nChannel)
+			m_bLCDLevelsActive |= m_LCDLevels[nChannel] > 0.0f || m_LCDPeaks[nChannel] > 0.0f;
+
+		const bool bChanged = CUserInterface::QuantizeChannelLevels(LCD, nBarHeight, m_LCDLevels, m_LCDPeaks, nChannels, m_LCDLevelPixels, m_LCDPeakPixels);
+		return bChanged ? CUserInterface::WidgetChannelLevels : CUserInterface::WidgetNone;
+	}
+
+	static constexpr size_t LCDMaxChannels = 16;
+
+	// Written by the audio core while holding m_Lock
+	CSnapshot<TSynthStatus> m_StatusSnapshot;
+
+	// Display state sampled by UpdateLCDState()
+	float m_LCDLevels[LCDMaxChannels];
+	float m_LCDPeaks[LCDMaxChannels];
+	u8 m_LCDLevelPixels[LCDMaxChannels];
+	u8 m_LCDPeakPixels[LCDMaxChannels];
+	bool m_bLCDLevelsActive;
 };
 
 #endif
@@ -0,0 +1,119 @@
+//
+// sysexfiletransfer.h
+//
+// mt32-pi - A baremetal MIDI synthesizer for Raspberry Pi
+// Copyright (C) 2020-2023 Dale Whinham <daleyo@gmail.com>
+//
+// This file is part of mt32-pi.
+//
+// mt32-pi is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// mt32-pi is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// mt32-pi. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef _sysexfiletransfer_h
+#define _sysexfiletransfer_h
+
+#include <circle/types.h>
+#include <fatfs/ff.h>
+
+// Receives files sent as custom SysEx messages (F0 7D 07 ...) and writes them to SD or USB storage
+//
+// Host to device (checksum makes the 7-bit sum of all bytes after the sub-command zero):
+//   Open:  F0 7D 07 01 vv s0 s1 s2 s3 s4 <path> cs F7   (vv: 00 = SD, 01 = USB; file size as 5 7-bit groups, LSB first)
+//   Data:  F0 7D 07 02 q0 q1 <packed data> cs F7        (14-bit sequence number, LSB first; 7 bytes packed into 8)
+//   Close: F0 7D 07 03 F7
+//   Abort: F0 7D 07 04 F7
+//
+// Whole messages must fit the MIDI parser's SysEx buffer (CMIDIParser::SysExBufferSize, 1000 bytes including F0/F7),
+// so a data block carries at most 124 packed groups (868 bytes); longer messages are dropped by the parser
+//
+// Device to host:
+//   ACK:   F0 7D 07 7E cc q0 q1 F7                      (cc: sub-command acknowledged, q: sequence number)
+//   NAK:   F0 7D 07 7F cc ee q0 q1 F7                   (ee: error, q: sequence number expected next)
+class CSysExFileTransfer
+{
+public:
+	enum class TCommand : u8
+	{
+		Open  = 0x01,
+		Data  = 0x02,
+		Close = 0x03,
+		Abort = 0x04,
+
+		Ack   = 0x7E,
+		Nak   = 0x7F,
+	};
+
+	enum class TError : u8
+	{
+		None,
+		Checksum,
+		Sequence,
+		File,
+		NotOpen,
+		BadRequest,
+		SizeMismatch,
+	};
+
+	enum class TResult
+	{
+		Ignored,
+		Started,
+		Progress,
+		Completed,
+		Aborted,
+		Failed,
+	};
+
+	static constexpr size_t MaxReplySize = 9;
+
+	CSysExFileTransfer();
+	~CSysExFileTransfer();
+
+	// Handles a complete custom SysEx message; fills in a reply to be sent back to the host
+	TResult HandleMessage(const u8* pData, size_t nSize, u8* pOutReply, size_t& nOutReplySize);
+
+	bool IsActive() const { return m_bActive; }
+	const char* GetPath() const { return m_Path; }
+	u8 GetProgressPercent() const;
+
+private:
+	static constexpr size_t MaxPathLength = 127;
+	static constexpr size_t WriteBufferSize = 4096;
+
+	TResult Open(const u8* pData, size_t nSize);
+	TResult WriteBlock(u16 nSequence, const u8* pData, size_t nSize);
+	TResult Close();
+	void Abort();
+	bool FlushWriteBuffer();
+
+	static bool IsValidPath(const char* pPath);
+	static bool VerifyChecksum(const u8* pData, size_t nSize);
+
+	bool m_bActive;
+	FIL m_File;
+	// Volume prefix + path (+ temporary suffix) + terminator
+	char m_Path[4 + MaxPathLength + 1];
+	char m_TempPath[4 + MaxPathLength + 5 + 1];
+
+	u32 m_nFileSize;
+	u32 m_nReceivedSize;
+	u16 m_nExpectedSequence;
+	TError m_LastError;
+
+	// Blocks are collected into larger writes to reduce card accesses
+	u8 m_WriteBuffer[WriteBufferSize];
+	size_t m_nWriteBufferSize;
+};
+
+#endif
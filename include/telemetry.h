@@ -0,0 +1,85 @@
+//
+// telemetry.h
+//
+// mt32-pi - A baremetal MIDI synthesizer for Raspberry Pi
+// Copyright (C) 2020-2023 Dale Whinham <daleyo@gmail.com>
+//
+// This file is part of mt32-pi.
+//
+// mt32-pi is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// mt32-pi is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// mt32-pi. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef _telemetry_h
+#define _telemetry_h
+
+#include <circle/types.h>
+
+// Keeps a once-per-second history of SoC temperature, ARM clock, throttling status and render load,
+// and appends the samples surrounding each audio underrun or render stall to a log file on the SD card
+class CTelemetry
+{
+public:
+	static constexpr size_t HistorySize      = 120;
+	static constexpr size_t PreEventSamples  = 30;
+	static constexpr size_t PostEventSamples = 10;
+
+	CTelemetry();
+
+	void SetLogEnabled(bool bEnabled) { m_bLogEnabled = bEnabled; }
+
+	// Called by the audio core for each chunk; a load over 100% means the chunk took longer to render than to play
+	void OnRender(u32 nLoad);
+	void OnUnderrun() { __atomic_add_fetch(&m_nUnderruns, 1, __ATOMIC_RELAXED); }
+
+	// Called periodically by the main core; takes samples and writes completed captures
+	void Update(unsigned int nTicks);
+	void Dump() const;
+
+private:
+	struct TSample
+	{
+		u32 nTime;
+		u32 nThrottledStatus;
+		u16 nClockMHz;
+		u16 nRenderLoadPeak;
+		u16 nUnderruns;
+		u16 nStalls;
+		u8 nTemperature;
+	};
+
+	const TSample& GetSample(u32 nIndex) const { return m_Samples[nIndex % HistorySize]; }
+	void WriteCapture();
+
+	bool m_bLogEnabled;
+	unsigned int m_nLastUpdateTime;
+
+	// Written by the audio core
+	volatile u32 m_nRenderLoadPeak;
+	volatile u32 m_nUnderruns;
+	volatile u32 m_nStalls;
+
+	u32 m_nLastUnderruns;
+	u32 m_nLastStalls;
+
+	TSample m_Samples[HistorySize];
+	u32 m_nSampleCount;
+
+	// Range of samples to be written out, as indices into the whole sample sequence
+	bool m_bCapturing;
+	u32 m_nCaptureBegin;
+	u32 m_nCaptureEnd;
+	u32 m_nCaptureCount;
+};
+
+#endif
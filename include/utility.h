@@ -61,6 +61,13 @@ namespace Utility
 		return nLHS > nRHS ? nLHS : nRHS;
 	}
 
+	// Templated function for taking the absolute value
+	template <class T>
+	constexpr T Abs(const T& nValue)
+	{
+		return nValue < 0 ? -nValue : nValue;
+	}
+
 	// Function for performing a linear interpolation of a value
 	constexpr float Lerp(float nValue, float nMinA, float nMaxA, float nMinB, float nMaxB)
 	{
@@ -45,6 +45,8 @@ public:
 	void* Realloc(void* pPtr, size_t nSize, TZoneTag Tag);
 	void Free(void* pPtr);
 	size_t GetAllocCount() const { return m_nAllocCount; }
+	size_t GetHeapSize() const { return m_nHeapSize; }
+	size_t GetFreeSpace(size_t* pOutLargestBlock = nullptr) const;
 
 	void FreeTag(u32 nTag);
 	void Clear();
@@ -62,6 +62,9 @@ CONFIG_ENUM_STRINGS(TAudioOutputDevice, ENUM_AUDIOOUTPUTDEVICE);
 CONFIG_ENUM_STRINGS(TMT32EmuResamplerQuality, ENUM_RESAMPLERQUALITY);
 CONFIG_ENUM_STRINGS(TMT32EmuMIDIChannels, ENUM_MIDICHANNELS);
 CONFIG_ENUM_STRINGS(TMT32EmuROMSet, ENUM_MT32ROMSET);
+CONFIG_ENUM_STRINGS(TFluidSynthInterpolation, ENUM_INTERPOLATION);
+CONFIG_ENUM_STRINGS(TReverbEngine, ENUM_REVERBENGINE);
+CONFIG_ENUM_STRINGS(TChorusEngine, ENUM_CHORUSENGINE);
 CONFIG_ENUM_STRINGS(TLCDType, ENUM_LCDTYPE);
 CONFIG_ENUM_STRINGS(TControlScheme, ENUM_CONTROLSCHEME);
 CONFIG_ENUM_STRINGS(TEncoderType, ENUM_ENCODERTYPE);
@@ -113,6 +116,47 @@ bool CConfig::Initialize(const char* pPath)
 
 }
 
+bool CConfig::Reload(const char* pPath)
+{
+	// Parse into a copy holding default values; keep ourselves as the global instance
+	CConfig NewConfig;
+	s_pThis = this;
+
+	if (!NewConfig.Initialize(pPath))
+		return false;
+
+	SystemVerbose                    = NewConfig.SystemVerbose;
+	SystemDefaultSynth               = NewConfig.SystemDefaultSynth;
+	SystemPowerSaveTimeout           = NewConfig.SystemPowerSaveTimeout;
+	SystemTelemetryLog               = NewConfig.SystemTelemetryLog;
+
+	ControlSwitchTimeout             = NewConfig.ControlSwitchTimeout;
+
+	MT32EmuMIDIChannels              = NewConfig.MT32EmuMIDIChannels;
+	MT32EmuROMSet                    = NewConfig.MT32EmuROMSet;
+	MT32EmuReversedStereo            = NewConfig.MT32EmuReversedStereo;
+
+	FluidSynthSoundFont              = NewConfig.FluidSynthSoundFont;
+	FluidSynthPolyphony              = NewConfig.FluidSynthPolyphony;
+	FluidSynthInterpolation          = NewConfig.FluidSynthInterpolation;
+	FluidSynthControllerFastPath     = NewConfig.FluidSynthControllerFastPath;
+	FluidSynthDefaultGain            = NewConfig.FluidSynthDefaultGain;
+	FluidSynthDefaultReverbActive    = NewConfig.FluidSynthDefaultReverbActive;
+	FluidSynthDefaultReverbEngine    = NewConfig.FluidSynthDefaultReverbEngine;
+	FluidSynthDefaultReverbDamping   = NewConfig.FluidSynthDefaultReverbDamping;
+	FluidSynthDefaultReverbLevel     = NewConfig.FluidSynthDefaultReverbLevel;
+	FluidSynthDefaultReverbRoomSize  = NewConfig.FluidSynthDefaultReverbRoomSize;
+	FluidSynthDefaultReverbWidth     = NewConfig.FluidSynthDefaultReverbWidth;
+	FluidSynthDefaultChorusActive    = NewConfig.FluidSynthDefaultChorusActive;
+	FluidSynthDefaultChorusEngine    = NewConfig.FluidSynthDefaultChorusEngine;
+	FluidSynthDefaultChorusDepth     = NewConfig.FluidSynthDefaultChorusDepth;
+	FluidSynthDefaultChorusLevel     = NewConfig.FluidSynthDefaultChorusLevel;
+	FluidSynthDefaultChorusVoices    = NewConfig.FluidSynthDefaultChorusVoices;
+	FluidSynthDefaultChorusSpeed     = NewConfig.FluidSynthDefaultChorusSpeed;
+
+	return true;
+}
+
 int CConfig::INIHandler(void* pUser, const char* pSection, const char* pName, const char* pValue)
 {
 	CConfig* const pConfig = static_cast<CConfig*>(pUser);
@@ -206,6 +250,9 @@ CONFIG_ENUM_PARSER(TAudioOutputDevice);
 CONFIG_ENUM_PARSER(TMT32EmuResamplerQuality);
 CONFIG_ENUM_PARSER(TMT32EmuMIDIChannels);
 CONFIG_ENUM_PARSER(TMT32EmuROMSet);
+CONFIG_ENUM_PARSER(TFluidSynthInterpolation);
+CONFIG_ENUM_PARSER(TReverbEngine);
+CONFIG_ENUM_PARSER(TChorusEngine);
 CONFIG_ENUM_PARSER(TLCDType);
 CONFIG_ENUM_PARSER(TControlScheme);
 CONFIG_ENUM_PARSER(TEncoderType);
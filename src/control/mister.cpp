@@ -61,6 +61,24 @@ void CMisterControl::Update(const TMisterStatus& SystemStatus)
 		return;
 	}
 
+	// A profile was selected from OSD; apply it once, then report the resulting state back
+	if (MisterStatus.Synth >= TMisterSynth::ProfileFirst && MisterStatus.Synth <= TMisterSynth::ProfileLast)
+	{
+		if (MisterStatus != m_LastMisterStatus)
+		{
+			EnqueueApplyProfileEvent(static_cast<u8>(MisterStatus.Synth) - static_cast<u8>(TMisterSynth::ProfileFirst));
+			m_LastMisterStatus = MisterStatus;
+		}
+
+		if (!WriteConfigToMister(SystemStatus))
+			ResetState();
+		else
+			bMisterActive = true;
+
+		m_LastSystemStatus = SystemStatus;
+		return;
+	}
+
 	if (bMisterActive)
 	{
 		// If the state has been changed by user controls/SysEx, we just need to update the MiSTer status
@@ -167,6 +185,14 @@ void CMisterControl::EnqueueDisplayImageEvent()
 	m_pEventQueue->Enqueue(Event);
 }
 
+void CMisterControl::EnqueueApplyProfileEvent(size_t nIndex)
+{
+	TEvent Event;
+	Event.Type = TEventType::ApplyProfile;
+	Event.ApplyProfile.Index = nIndex;
+	m_pEventQueue->Enqueue(Event);
+}
+
 void CMisterControl::EnqueueAllSoundOffEvent()
 {
 	TEvent Event;
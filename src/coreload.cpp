@@ -0,0 +1,80 @@
+//
+// coreload.cpp
+//
+// mt32-pi - A baremetal MIDI synthesizer for Raspberry Pi
+// Copyright (C) 2020-2023 Dale Whinham <daleyo@gmail.com>
+//
+// This file is part of mt32-pi.
+//
+// mt32-pi is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// mt32-pi is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// mt32-pi. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <circle/timer.h>
+
+#include "coreload.h"
+
+CCoreLoad::CScope::CScope(CCoreLoad& CoreLoad, unsigned nCore)
+	: m_CoreLoad(CoreLoad),
+	  m_nCore(nCore),
+	  m_nStartTime(CTimer::GetClockTicks())
+{
+}
+
+CCoreLoad::CScope::~CScope()
+{
+	m_CoreLoad.AddBusyTime(m_nCore, CTimer::GetClockTicks() - m_nStartTime);
+}
+
+CCoreLoad::CCoreLoad()
+	: m_nBusyTime{},
+	  m_nLastBusyTime{},
+	  m_nLastClockTime(0),
+	  m_nLastUpdateTime(0),
+	  m_nLoad{},
+	  m_nPeakLoad{}
+{
+}
+
+void CCoreLoad::Update(unsigned int nTicks)
+{
+	if (nTicks - m_nLastUpdateTime < HZ)
+		return;
+
+	m_nLastUpdateTime = nTicks;
+
+	const unsigned nClockTime = CTimer::GetClockTicks();
+	const unsigned nElapsed = nClockTime - m_nLastClockTime;
+	m_nLastClockTime = nClockTime;
+
+	for (unsigned nCore = 0; nCore < CORES; ++nCore)
+	{
+		const u32 nBusyTime = __atomic_load_n(&m_nBusyTime[nCore], __ATOMIC_RELAXED);
+		const u32 nBusy = nBusyTime - m_nLastBusyTime[nCore];
+		m_nLastBusyTime[nCore] = nBusyTime;
+
+		u32 nLoad = nElapsed ? static_cast<u64>(nBusy) * 100 / nElapsed : 0;
+		if (nLoad > 100)
+			nLoad = 100;
+
+		m_nLoad[nCore] = nLoad;
+		if (nLoad > m_nPeakLoad[nCore])
+			m_nPeakLoad[nCore] = nLoad;
+	}
+}
+
+void CCoreLoad::ResetPeaks()
+{
+	for (unsigned nCore = 0; nCore < CORES; ++nCore)
+		m_nPeakLoad[nCore] = 0;
+}
@@ -0,0 +1,167 @@
+//
+// coremailbox.cpp
+//
+// mt32-pi - A baremetal MIDI synthesizer for Raspberry Pi
+// Copyright (C) 2020-2023 Dale Whinham <daleyo@gmail.com>
+//
+// This file is part of mt32-pi.
+//
+// mt32-pi is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// mt32-pi is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// mt32-pi. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <circle/logger.h>
+#include <circle/synchronize.h>
+#include <circle/timer.h>
+
+#include "coremailbox.h"
+
+LOGMODULE("coremailbox");
+
+CCoreMailbox::CCoreMailbox()
+	: m_Queues{},
+	  m_bSleeping{},
+	  m_nRingTime{},
+	  m_Stats{}
+{
+}
+
+bool CCoreMailbox::Send(unsigned nFrom, unsigned nTo, const TCoreMessage& Message)
+{
+	assert(nFrom < CORES && nTo < CORES);
+
+	TQueue& Queue = m_Queues[nTo][nFrom];
+	const u32 nTail = Queue.nTail;
+
+	if (nTail - __atomic_load_n(&Queue.nHead, __ATOMIC_ACQUIRE) == QueueSize)
+	{
+		__atomic_add_fetch(&m_Stats[nTo].nDropped, 1, __ATOMIC_RELAXED);
+		return false;
+	}
+
+	Queue.Messages[nTail % QueueSize] = Message;
+
+	// Sequentially consistent so that either we see the receiver going to sleep, or it sees this message
+	__atomic_store_n(&Queue.nTail, nTail + 1, __ATOMIC_SEQ_CST);
+
+	if (__atomic_load_n(&m_bSleeping[nTo], __ATOMIC_SEQ_CST))
+	{
+		__atomic_store_n(&m_nRingTime[nTo], CTimer::GetClockTicks(), __ATOMIC_RELAXED);
+		CMultiCoreSupport::SendIPI(nTo, DoorbellIPI);
+	}
+
+	return true;
+}
+
+bool CCoreMailbox::Receive(unsigned nCore, TCoreMessage& OutMessage)
+{
+	assert(nCore < CORES);
+
+	for (unsigned nSender = 0; nSender < CORES; ++nSender)
+	{
+		TQueue& Queue = m_Queues[nCore][nSender];
+		const u32 nHead = Queue.nHead;
+
+		if (nHead == __atomic_load_n(&Queue.nTail, __ATOMIC_ACQUIRE))
+			continue;
+
+		OutMessage = Queue.Messages[nHead % QueueSize];
+		__atomic_store_n(&Queue.nHead, nHead + 1, __ATOMIC_RELEASE);
+		++m_Stats[nCore].nReceived;
+
+		return true;
+	}
+
+	return false;
+}
+
+void CCoreMailbox::Wait(unsigned nCore)
+{
+	assert(nCore < CORES);
+
+	TCoreStats& Stats = m_Stats[nCore];
+
+	// Forget rings for messages we've already handled
+	__atomic_store_n(&m_nRingTime[nCore], 0u, __ATOMIC_RELAXED);
+	__atomic_store_n(&m_bSleeping[nCore], true, __ATOMIC_SEQ_CST);
+
+	while (!HasMessages(nCore))
+	{
+		// With IRQs masked, a doorbell arriving after the check still ends the WFI instead of being handled before it
+		EnterCritical(IRQ_LEVEL);
+		if (!HasMessages(nCore))
+			WaitForInterrupt();
+		LeaveCritical();
+	}
+
+	__atomic_store_n(&m_bSleeping[nCore], false, __ATOMIC_RELAXED);
+
+	// Other interrupts and stale doorbells also wake us, so only count wakes that followed a ring
+	const unsigned nRingTime = __atomic_exchange_n(&m_nRingTime[nCore], 0u, __ATOMIC_RELAXED);
+	if (nRingTime)
+	{
+		const unsigned nLatency = CTimer::GetClockTicks() - nRingTime;
+		++Stats.nWakes;
+		Stats.nWakeLatencyTotal += nLatency;
+		if (nLatency > Stats.nWakeLatencyPeak)
+			Stats.nWakeLatencyPeak = nLatency;
+	}
+}
+
+void CCoreMailbox::OnDoorbell(unsigned nCore)
+{
+	TCoreStats& Stats = m_Stats[nCore];
+	++Stats.nDoorbells;
+
+	const unsigned nRingTime = __atomic_load_n(&m_nRingTime[nCore], __ATOMIC_RELAXED);
+	if (nRingTime)
+	{
+		const unsigned nLatency = CTimer::GetClockTicks() - nRingTime;
+		if (nLatency > Stats.nIRQLatencyPeak)
+			Stats.nIRQLatencyPeak = nLatency;
+	}
+}
+
+void CCoreMailbox::Dump() const
+{
+	LOGNOTE("Core mailboxes:");
+
+	for (unsigned nCore = 0; nCore < CORES; ++nCore)
+	{
+		const TCoreStats& Stats = m_Stats[nCore];
+		if (!(Stats.nReceived || Stats.nDropped || Stats.nDoorbells))
+			continue;
+
+		const u32 nAverageLatency = Stats.nWakes ? Stats.nWakeLatencyTotal / Stats.nWakes : 0;
+		LOGNOTE("Core %d: %d received, %d dropped, %d doorbells", nCore, Stats.nReceived, Stats.nDropped, Stats.nDoorbells);
+		LOGNOTE("Core %d: wake latency %d us average, %d us peak; interrupt latency %d us peak", nCore, nAverageLatency, Stats.nWakeLatencyPeak, Stats.nIRQLatencyPeak);
+	}
+}
+
+void CCoreMailbox::ResetStats()
+{
+	for (TCoreStats& Stats : m_Stats)
+		Stats = TCoreStats{};
+}
+
+bool CCoreMailbox::HasMessages(unsigned nCore) const
+{
+	for (unsigned nSender = 0; nSender < CORES; ++nSender)
+	{
+		const TQueue& Queue = m_Queues[nCore][nSender];
+		if (__atomic_load_n(&Queue.nHead, __ATOMIC_RELAXED) != __atomic_load_n(&Queue.nTail, __ATOMIC_SEQ_CST))
+			return true;
+	}
+
+	return false;
+}
@@ -0,0 +1,77 @@
+//
+// firmwarestatus.cpp
+//
+// mt32-pi - A baremetal MIDI synthesizer for Raspberry Pi
+// Copyright (C) 2020-2023 Dale Whinham <daleyo@gmail.com>
+//
+// This file is part of mt32-pi.
+//
+// mt32-pi is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// mt32-pi is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// mt32-pi. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <circle/sched/scheduler.h>
+
+#include "firmwarestatus.h"
+#include "stackmonitor.h"
+
+CFirmwareStatus* CFirmwareStatus::s_pThis = nullptr;
+
+CFirmwareStatus::CFirmwareStatus()
+	: CTask(TASK_STACK_SIZE, true),
+	  m_nThrottledStatus(0),
+	  m_nTemperature(0),
+	  m_nClockRate(0)
+{
+	s_pThis = this;
+}
+
+void CFirmwareStatus::Initialize()
+{
+	// Fill the cache before anyone reads it
+	Query();
+
+	// We started as a suspended task; run now that initialization is successful
+	Start();
+}
+
+void CFirmwareStatus::Run()
+{
+	CStackMonitor::CTaskScope StackScope("firmware", this);
+	CScheduler* const pScheduler = CScheduler::Get();
+
+	while (true)
+	{
+		pScheduler->MsSleep(UpdatePeriodMillis);
+		Query();
+	}
+}
+
+void CFirmwareStatus::Query()
+{
+	// Get throttled status from the firmware and clear status bits
+	TPropertyTagSimple ThrottledStatus;
+	ThrottledStatus.nValue = 0xFFFF;
+	if (m_Tags.GetTag(PROPTAG_GET_THROTTLED, &ThrottledStatus, sizeof(ThrottledStatus), sizeof(ThrottledStatus.nValue)))
+		__atomic_store_n(&m_nThrottledStatus, ThrottledStatus.nValue, __ATOMIC_RELAXED);
+
+	TPropertyTagTemperature Temperature;
+	Temperature.nTemperatureId = TEMPERATURE_ID;
+	if (m_Tags.GetTag(PROPTAG_GET_TEMPERATURE, &Temperature, sizeof(Temperature), 4))
+		__atomic_store_n(&m_nTemperature, Temperature.nValue / 1000, __ATOMIC_RELAXED);
+
+	TPropertyTagClockRate ClockRate;
+	ClockRate.nClockId = CLOCK_ID_ARM;
+	if (m_Tags.GetTag(PROPTAG_GET_CLOCK_RATE, &ClockRate, sizeof(ClockRate), 4))
+		__atomic_store_n(&m_nClockRate, ClockRate.nRate, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,141 @@
+//
+// gcovwriter.cpp
+//
+// mt32-pi - A baremetal MIDI synthesizer for Raspberry Pi
+// Copyright (C) 2020-2023 Dale Whinham <daleyo@gmail.com>
+//
+// This file is part of mt32-pi.
+//
+// mt32-pi is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// mt32-pi is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// mt32-pi. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <circle/logger.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fatfs/ff.h>
+
+#include "gcovwriter.h"
+
+#ifdef PGO_GENERATE
+extern "C"
+{
+#include <gcov.h>
+
+// The linker gathers each instrumented translation unit's profile info pointer here (see Config.mk)
+extern const gcov_info* const __start_gcov_info[];
+extern const gcov_info* const __stop_gcov_info[];
+}
+#endif
+
+LOGMODULE("gcovwriter");
+
+namespace
+{
+	struct TWriteState
+	{
+		const char* pDirectory;
+		FIL File;
+		bool bOpen;
+		bool bFailed;
+	};
+}
+
+bool CGcovWriter::Write(const char* pDirectory)
+{
+#ifdef PGO_GENERATE
+	const FRESULT Result = f_mkdir(pDirectory);
+	if (Result != FR_OK && Result != FR_EXIST)
+	{
+		LOGERR("Couldn't create '%s'", pDirectory);
+		return false;
+	}
+
+	TWriteState State;
+	State.pDirectory = pDirectory;
+	size_t nFiles = 0;
+	size_t nFailed = 0;
+
+	for (const gcov_info* const* ppInfo = __start_gcov_info; ppInfo != __stop_gcov_info; ++ppInfo)
+	{
+		State.bOpen   = false;
+		State.bFailed = false;
+
+		__gcov_info_to_gcda(*ppInfo, OnFileName, OnData, OnAllocate, &State);
+
+		if (State.bOpen && f_close(&State.File) != FR_OK)
+			State.bFailed = true;
+
+		++nFiles;
+		if (State.bFailed)
+			++nFailed;
+	}
+
+	LOGNOTE("Wrote profile data for %d objects to '%s' (%d failed)", nFiles - nFailed, pDirectory, nFailed);
+	return nFiles && !nFailed;
+#else
+	LOGWARN("Not an instrumented build; build with PGO=generate to collect profile data");
+	return false;
+#endif
+}
+
+void CGcovWriter::OnFileName(const char* pFileName, void* pParam)
+{
+	TWriteState& State = *static_cast<TWriteState*>(pParam);
+	if (!pFileName)
+	{
+		State.bFailed = true;
+		return;
+	}
+
+	// Flatten the host path the same way GCC does when looking up profiles with -fprofile-use=<dir>
+	char Path[FF_MAX_LFN + 1];
+	const int nPrefixLength = snprintf(Path, sizeof(Path), "%s/", State.pDirectory);
+	if (nPrefixLength < 0 || static_cast<size_t>(nPrefixLength) + strlen(pFileName) >= sizeof(Path))
+	{
+		LOGERR("Path too long for '%s'", pFileName);
+		State.bFailed = true;
+		return;
+	}
+
+	char* pOut = Path + nPrefixLength;
+	for (const char* pIn = pFileName; *pIn; ++pIn)
+		*pOut++ = *pIn == '/' ? '#' : *pIn;
+	*pOut = '\0';
+
+	if (f_open(&State.File, Path, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK)
+	{
+		LOGERR("Couldn't open '%s' for writing", Path);
+		State.bFailed = true;
+		return;
+	}
+
+	State.bOpen = true;
+}
+
+void CGcovWriter::OnData(const void* pData, unsigned nSize, void* pParam)
+{
+	TWriteState& State = *static_cast<TWriteState*>(pParam);
+	if (!State.bOpen || State.bFailed)
+		return;
+
+	UINT nWritten;
+	if (f_write(&State.File, pData, nSize, &nWritten) != FR_OK || nWritten != nSize)
+		State.bFailed = true;
+}
+
+void* CGcovWriter::OnAllocate(unsigned nSize, void* pParam)
+{
+	return malloc(nSize);
+}
@@ -97,12 +97,66 @@ namespace
 					mCharData[i][j] = Function(CharData[i], j);
 		}
 
-		const ColumnData& operator[](size_t nIndex) const { return mCharData[nIndex]; }
+		constexpr const ColumnData& operator[](size_t nIndex) const { return mCharData[nIndex]; }
 
 	private:
 		ColumnData mCharData[N];
 	};
 
+	// Templated array-like structure with precomputed glyphs ready to be copied into the framebuffer.
+	// Each glyph is pre-shifted and split into two pages for normal, inverted and double-width variants.
+	template<size_t N>
+	class CGlyphAtlas
+	{
+	public:
+		static constexpr u8 MaxColumns = 12;
+		using GlyphData = u8[2][MaxColumns];
+
+		template<class F>
+		constexpr CGlyphAtlas(const Font<N, F>& DoubleHeightFont)
+			: m_Glyphs{}
+		{
+			for (size_t i = 0; i < N; ++i)
+			{
+				for (u8 nVariant = 0; nVariant < 4; ++nVariant)
+				{
+					const bool bInverted    = nVariant & 1;
+					const bool bDoubleWidth = nVariant & 2;
+
+					for (u8 j = 0; j < 6; ++j)
+					{
+						u16 nFontColumn = DoubleHeightFont[i][j];
+
+						// Don't invert the leftmost column or last two rows
+						if (j > 0 && bInverted)
+							nFontColumn ^= 0x3FFF;
+
+						// Shift down by 2 pixels
+						nFontColumn = static_cast<u16>(nFontColumn << 2);
+
+						const u8 nColumn = bDoubleWidth ? j * 2 : j;
+						m_Glyphs[i][nVariant][0][nColumn] = nFontColumn & 0xFF;
+						m_Glyphs[i][nVariant][1][nColumn] = (nFontColumn >> 8) & 0xFF;
+
+						if (bDoubleWidth)
+						{
+							m_Glyphs[i][nVariant][0][nColumn + 1] = m_Glyphs[i][nVariant][0][nColumn];
+							m_Glyphs[i][nVariant][1][nColumn + 1] = m_Glyphs[i][nVariant][1][nColumn];
+						}
+					}
+				}
+			}
+		}
+
+		const GlyphData& GetGlyph(size_t nIndex, bool bInverted, bool bDoubleWidth) const
+		{
+			return m_Glyphs[nIndex][(bDoubleWidth ? 2 : 0) | (bInverted ? 1 : 0)];
+		}
+
+	private:
+		GlyphData m_Glyphs[N][4];
+	};
+
 	// Templated array-like structure with precomputed pixel data
 	template<size_t W, size_t H>
 	class CSSD1306Image
@@ -142,6 +196,7 @@ namespace
 // Single and double-height versions of the font
 constexpr auto FontSingle = Font<Utility::ArraySize(Font6x8), decltype(SingleColumn)>(Font6x8, SingleColumn);
 constexpr auto FontDouble = Font<Utility::ArraySize(Font6x8), decltype(DoubleColumn)>(Font6x8, DoubleColumn);
+constexpr auto GlyphAtlas = CGlyphAtlas<Utility::ArraySize(Font6x8)>(FontDouble);
 
 constexpr auto MT32PiLogo = CSSD1306Image<128, 32>(MT32PiLogo128x32);
 constexpr auto MisterLogo = CSSD1306Image<128, 32>(MisterLogo128x32);
@@ -225,13 +280,45 @@ void CSSD1306::WriteFrameBuffer(bool bForceFullUpdate) const
 	// Reset start line
 	WriteCommand(SetStartLine | 0x00);
 
-	// Compare two framebuffers
-	const size_t nFrameBufferSize = m_nWidth * m_nHeight / 8;
-	const bool bNeedsUpdate = bForceFullUpdate || memcmp(m_FrameBuffers[0].FrameBuffer, m_FrameBuffers[1].FrameBuffer, nFrameBufferSize) != 0;
+	// Compare two framebuffers page by page to find the dirty region
+	const u8 nPages = m_nHeight / 8;
+	u8 nFirstPage = nPages, nLastPage = 0;
+
+	for (u8 nPage = 0; nPage < nPages; ++nPage)
+	{
+		const size_t nOffset = nPage * m_nWidth;
+		if (bForceFullUpdate || memcmp(&m_FrameBuffers[0].FrameBuffer[nOffset], &m_FrameBuffers[1].FrameBuffer[nOffset], m_nWidth) != 0)
+		{
+			nFirstPage = Utility::Min(nFirstPage, nPage);
+			nLastPage = nPage;
+		}
+	}
+
+	// Nothing changed
+	if (nFirstPage == nPages)
+		return;
+
+	// Restrict the page address window to the dirty pages
+	WriteCommand(SetColumnAddress);
+	WriteCommand(0x00);
+	WriteCommand(m_nWidth - 1);
+	WriteCommand(SetPageAddress);
+	WriteCommand(nFirstPage);
+	WriteCommand(nLastPage);
 
 	// Copy entire framebuffer
-	if (bNeedsUpdate)
-		m_pI2CMaster->Write(m_nAddress, &m_FrameBuffers[m_nCurrentFrameBuffer], sizeof(TFrameBufferUpdatePacket::DataControlByte) + nFrameBufferSize);
+	if (nFirstPage == 0 && nLastPage == nPages - 1)
+	{
+		m_pI2CMaster->Write(m_nAddress, &m_FrameBuffers[m_nCurrentFrameBuffer], sizeof(TFrameBufferUpdatePacket::DataControlByte) + nPages * m_nWidth);
+		return;
+	}
+
+	// Prefix the dirty pages' pixel data with a data control byte
+	const size_t nSize = (nLastPage - nFirstPage + 1) * m_nWidth;
+	u8 Buffer[sizeof(TFrameBufferUpdatePacket)] = { 0x40 };
+	memcpy(Buffer + 1, &m_FrameBuffers[m_nCurrentFrameBuffer].FrameBuffer[nFirstPage * m_nWidth], nSize);
+
+	m_pI2CMaster->Write(m_nAddress, Buffer, nSize + 1);
 }
 
 void CSSD1306::SwapFrameBuffers()
@@ -325,36 +412,68 @@ void CSSD1306::DrawChar(char chChar, u8 nCursorX, u8 nCursorY, bool bInverted, b
 	else if (chChar < ' ')
 		chChar = ' ';
 
-	for (u8 i = 0; i < 6; ++i)
+	const auto& Glyph     = GlyphAtlas.GetGlyph(static_cast<u8>(chChar - ' '), bInverted, bDoubleWidth);
+	const size_t nColumns = bDoubleWidth ? 12 : 6;
+	const size_t nOffset  = nRowOffset + nColumnOffset;
+
+	// Upper and lower halves of font
+	memcpy(&pFrameBuffer[nOffset], Glyph[0], nColumns);
+	memcpy(&pFrameBuffer[nOffset + m_nWidth], Glyph[1], nColumns);
+}
+
+void CSSD1306::Flip()
+{
+	WriteFrameBuffer();
+	SwapFrameBuffers();
+}
+
+void CSSD1306::DrawBitmap(const u8* pBitmap, u8 nBitmapWidth, u8 nBitmapHeight, u8 nX, u8 nY, u8 nScaleX, u8 nScaleY)
+{
+	if (nScaleX == 0 || nScaleY == 0 || nX >= m_nWidth || nY >= m_nHeight)
+		return;
+
+	const size_t nBytesPerRow = (nBitmapWidth + 7) / 8;
+	const u8 nStartPage       = nY / 8;
+	const u8 nEndPage         = (Utility::Min<unsigned>(nY + nBitmapHeight * nScaleY, m_nHeight) - 1) / 8;
+	const u64 nScaleMask      = nScaleY >= 64 ? ~0ULL : (1ULL << nScaleY) - 1;
+	u8* pFrameBuffer          = m_FrameBuffers[m_nCurrentFrameBuffer].FrameBuffer;
+
+	for (u8 nSourceX = 0; nSourceX < nBitmapWidth; ++nSourceX)
 	{
-		u16 nFontColumn = FontDouble[static_cast<u8>(chChar - ' ')][i];
+		const unsigned nDestX = nX + nSourceX * nScaleX;
+		if (nDestX >= m_nWidth)
+			break;
 
-		// Don't invert the leftmost column or last two rows
-		if (i > 0 && bInverted)
-			nFontColumn ^= 0x3FFF;
+		// Gather the scaled source column into a single bitmask spanning the display height
+		u64 nColumn = 0;
+		for (u8 nSourceY = 0; nSourceY < nBitmapHeight; ++nSourceY)
+		{
+			const unsigned nDestY = nY + nSourceY * nScaleY;
+			if (nDestY >= m_nHeight)
+				break;
 
-		// Shift down by 2 pixels
-		nFontColumn <<= 2;
+			if (pBitmap[nSourceY * nBytesPerRow + nSourceX / 8] >> (7 - nSourceX % 8) & 1)
+				nColumn |= nScaleMask << nDestY;
+		}
 
-		// Upper half of font
-		const size_t nOffset = nRowOffset + nColumnOffset + (bDoubleWidth ? i * 2 : i);
+		if (!nColumn)
+			continue;
 
-		pFrameBuffer[nOffset] = nFontColumn & 0xFF;
-		pFrameBuffer[nOffset + m_nWidth] = (nFontColumn >> 8) & 0xFF;
-		if (bDoubleWidth)
+		// Write whole page bytes, repeated for the horizontal scale factor
+		const unsigned nDestWidth = Utility::Min<unsigned>(nScaleX, m_nWidth - nDestX);
+		for (u8 nPage = nStartPage; nPage <= nEndPage; ++nPage)
 		{
-			pFrameBuffer[nOffset + 1] = pFrameBuffer[nOffset];
-			pFrameBuffer[nOffset + m_nWidth + 1] = pFrameBuffer[nOffset + m_nWidth];
+			const u8 nPageBits = (nColumn >> (nPage * 8)) & 0xFF;
+			if (!nPageBits)
+				continue;
+
+			u8* pPixel = &pFrameBuffer[nPage * m_nWidth + nDestX];
+			for (unsigned i = 0; i < nDestWidth; ++i)
+				pPixel[i] |= nPageBits;
 		}
 	}
 }
 
-void CSSD1306::Flip()
-{
-	WriteFrameBuffer();
-	SwapFrameBuffers();
-}
-
 void CSSD1306::DrawImage(TImage Image, bool bImmediate)
 {
 	u8* pFrameBuffer = m_FrameBuffers[m_nCurrentFrameBuffer].FrameBuffer;
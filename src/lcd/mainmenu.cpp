@@ -0,0 +1,358 @@
+//
+// mainmenu.cpp
+//
+// mt32-pi - A baremetal MIDI synthesizer for Raspberry Pi
+// Copyright (C) 2020-2023 Dale Whinham <daleyo@gmail.com>
+//
+// This file is part of mt32-pi.
+//
+// mt32-pi is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// mt32-pi is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// mt32-pi. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <cstdio>
+
+#include "lcd/mainmenu.h"
+#include "utility.h"
+
+CSynthMenu::CSynthMenu(TEventQueue& EventQueue)
+	: CMenu("Synth"),
+	  m_EventQueue(EventQueue),
+	  m_CurrentSynth(TSynth::MT32)
+{
+}
+
+void CSynthMenu::GetItemText(size_t nIndex, char* pOutBuffer, size_t nSize) const
+{
+	snprintf(pOutBuffer, nSize, "%s", nIndex == static_cast<size_t>(TSynth::MT32) ? "MT-32" : "SoundFont");
+}
+
+bool CSynthMenu::Select(size_t nIndex)
+{
+	TEvent Event;
+	Event.Type = TEventType::SwitchSynth;
+	Event.SwitchSynth.Synth = static_cast<TSynth>(nIndex);
+	m_EventQueue.Enqueue(Event);
+	return true;
+}
+
+CMT32ROMSetMenu::CMT32ROMSetMenu(TEventQueue& EventQueue)
+	: CMenu("MT-32 ROM set"),
+	  m_EventQueue(EventQueue),
+	  m_pMT32Synth(nullptr)
+{
+}
+
+void CMT32ROMSetMenu::GetItemText(size_t nIndex, char* pOutBuffer, size_t nSize) const
+{
+	static const char* const ROMSetNames[] = { "MT-32 (old)", "MT-32 (new)", "CM-32L" };
+	const TMT32ROMSet ROMSet = static_cast<TMT32ROMSet>(nIndex);
+	const bool bAvailable = m_pMT32Synth->GetROMManager().HaveROMSet(ROMSet);
+
+	snprintf(pOutBuffer, nSize, "%s%s", ROMSetNames[nIndex], bAvailable ? "" : " (n/a)");
+}
+
+size_t CMT32ROMSetMenu::GetInitialIndex() const
+{
+	return m_pMT32Synth ? static_cast<size_t>(m_pMT32Synth->GetROMSet()) : 0;
+}
+
+bool CMT32ROMSetMenu::Select(size_t nIndex)
+{
+	TEvent Event;
+	Event.Type = TEventType::SwitchMT32ROMSet;
+	Event.SwitchMT32ROMSet.ROMSet = static_cast<TMT32ROMSet>(nIndex);
+	m_EventQueue.Enqueue(Event);
+	return true;
+}
+
+CSoundFontMenu::CSoundFontMenu(TEventQueue& EventQueue)
+	: CMenu("SoundFont"),
+	  m_EventQueue(EventQueue),
+	  m_pSoundFontSynth(nullptr),
+	  m_nNameCount(0)
+{
+}
+
+size_t CSoundFontMenu::GetItemCount() const
+{
+	return m_pSoundFontSynth ? m_nNameCount : 0;
+}
+
+void CSoundFontMenu::GetItemText(size_t nIndex, char* pOutBuffer, size_t nSize) const
+{
+	TName Name;
+	m_Names[nIndex].Read(Name);
+	snprintf(pOutBuffer, nSize, "%s", Name.Text);
+}
+
+void CSoundFontMenu::SetSoundFontNames(const CSoundFontManager& SoundFontManager)
+{
+	// Rows may show a mix of old and new names until the menu redraws; every entry is always a valid string
+	const size_t nCount = SoundFontManager.GetSoundFontCount();
+	for (size_t i = 0; i < nCount; ++i)
+	{
+		const char* pName = SoundFontManager.GetSoundFontName(i);
+
+		TName Name;
+		snprintf(Name.Text, sizeof(Name.Text), "%s", pName ? pName : "");
+		m_Names[i].Publish(Name);
+	}
+
+	m_nNameCount = nCount;
+}
+
+size_t CSoundFontMenu::GetInitialIndex() const
+{
+	if (!m_pSoundFontSynth)
+		return 0;
+
+	// Current SoundFont may have gone in a rescan
+	const size_t nIndex = m_pSoundFontSynth->GetSoundFontIndex();
+	return nIndex < m_nNameCount ? nIndex : 0;
+}
+
+bool CSoundFontMenu::Select(size_t nIndex)
+{
+	TEvent Event;
+	Event.Type = TEventType::SwitchSoundFont;
+	Event.SwitchSoundFont.Index = nIndex;
+	m_EventQueue.Enqueue(Event);
+	return true;
+}
+
+CProfileMenu::CProfileMenu(TEventQueue& EventQueue, const CProfileManager& ProfileManager)
+	: CMenu("Profile"),
+	  m_EventQueue(EventQueue),
+	  m_ProfileManager(ProfileManager)
+{
+}
+
+void CProfileMenu::GetItemText(size_t nIndex, char* pOutBuffer, size_t nSize) const
+{
+	const char* pName = m_ProfileManager.GetProfileName(nIndex);
+	snprintf(pOutBuffer, nSize, "%s", pName ? pName : "");
+}
+
+bool CProfileMenu::Select(size_t nIndex)
+{
+	TEvent Event;
+	Event.Type = TEventType::ApplyProfile;
+	Event.ApplyProfile.Index = nIndex;
+	m_EventQueue.Enqueue(Event);
+	return true;
+}
+
+CMIDIStatsMenu::CMIDIStatsMenu(const CMIDIStats& MIDIStats)
+	: CMenu("MIDI stats"),
+	  m_MIDIStats(MIDIStats)
+{
+}
+
+// Rows: total rate, sources, channels, message types, running status, SysEx sizes, parser errors
+constexpr size_t MIDIStatsSourceRow        = 1;
+constexpr size_t MIDIStatsChannelRow       = MIDIStatsSourceRow + static_cast<size_t>(TMIDISource::Count);
+constexpr size_t MIDIStatsTypeRow          = MIDIStatsChannelRow + CMIDIStats::ChannelCount;
+constexpr size_t MIDIStatsRunningStatusRow = MIDIStatsTypeRow + static_cast<size_t>(CMIDIStats::TMessageType::Count);
+constexpr size_t MIDIStatsSysExSizeRow     = MIDIStatsRunningStatusRow + 1;
+constexpr size_t MIDIStatsErrorRow         = MIDIStatsSysExSizeRow + CMIDIStats::SysExSizeBucketCount;
+constexpr size_t MIDIStatsRowCount         = MIDIStatsErrorRow + static_cast<size_t>(CMIDIStats::TParserError::Count);
+
+size_t CMIDIStatsMenu::GetItemCount() const
+{
+	return MIDIStatsRowCount;
+}
+
+void CMIDIStatsMenu::GetItemText(size_t nIndex, char* pOutBuffer, size_t nSize) const
+{
+	if (nIndex < MIDIStatsSourceRow)
+		snprintf(pOutBuffer, nSize, "Total: %u/s", m_MIDIStats.GetTotalRate());
+	else if (nIndex < MIDIStatsChannelRow)
+	{
+		const TMIDISource Source = static_cast<TMIDISource>(nIndex - MIDIStatsSourceRow);
+		snprintf(pOutBuffer, nSize, "%s: %u/s", CMIDIStats::GetSourceName(Source), m_MIDIStats.GetSourceRate(Source));
+	}
+	else if (nIndex < MIDIStatsTypeRow)
+	{
+		const u8 nChannel = nIndex - MIDIStatsChannelRow;
+		snprintf(pOutBuffer, nSize, "Ch %d: %u/s", nChannel + 1, m_MIDIStats.GetChannelRate(nChannel));
+	}
+	else if (nIndex < MIDIStatsRunningStatusRow)
+	{
+		const auto Type = static_cast<CMIDIStats::TMessageType>(nIndex - MIDIStatsTypeRow);
+		snprintf(pOutBuffer, nSize, "%s: %u", CMIDIStats::GetMessageTypeName(Type), m_MIDIStats.GetMessageCount(Type));
+	}
+	else if (nIndex < MIDIStatsSysExSizeRow)
+		snprintf(pOutBuffer, nSize, "Running st: %d%%", m_MIDIStats.GetRunningStatusPercent());
+	else if (nIndex < MIDIStatsErrorRow)
+	{
+		const size_t nBucket = nIndex - MIDIStatsSysExSizeRow;
+		snprintf(pOutBuffer, nSize, "SysEx %s: %u", CMIDIStats::GetSysExSizeBucketName(nBucket), m_MIDIStats.GetSysExSizeCount(nBucket));
+	}
+	else
+	{
+		const auto Error = static_cast<CMIDIStats::TParserError>(nIndex - MIDIStatsErrorRow);
+		snprintf(pOutBuffer, nSize, "%s: %u", CMIDIStats::GetParserErrorName(Error), m_MIDIStats.GetParserErrorCount(Error));
+	}
+}
+
+CVoiceStatsMenu::CVoiceStatsMenu()
+	: CMenu("Voice stats"),
+	  m_pSoundFontSynth(nullptr)
+{
+}
+
+// Rows: voice totals, channels, presets
+constexpr size_t VoiceStatsChannelRow = 3;
+constexpr size_t VoiceStatsPresetRow  = VoiceStatsChannelRow + 16;
+
+size_t CVoiceStatsMenu::GetItemCount() const
+{
+	if (!m_pSoundFontSynth || !m_pSoundFontSynth->IsVoiceStatsEnabled())
+		return 1;
+
+	TVoiceStats Stats;
+	m_pSoundFontSynth->GetVoiceStats(Stats);
+	return VoiceStatsPresetRow + Stats.nPresets;
+}
+
+void CVoiceStatsMenu::GetItemText(size_t nIndex, char* pOutBuffer, size_t nSize) const
+{
+	if (!m_pSoundFontSynth || !m_pSoundFontSynth->IsVoiceStatsEnabled())
+	{
+		snprintf(pOutBuffer, nSize, "Disabled");
+		return;
+	}
+
+	TVoiceStats Stats;
+	m_pSoundFontSynth->GetVoiceStats(Stats);
+
+	if (nIndex == 0)
+		snprintf(pOutBuffer, nSize, "Voices: %d/%d", Stats.nActiveVoices, Stats.nPolyphony);
+	else if (nIndex == 1)
+		snprintf(pOutBuffer, nSize, "Peak: %d", Stats.nPeakVoices);
+	else if (nIndex == 2)
+		snprintf(pOutBuffer, nSize, "Avg life: %ums", Stats.nAvgLifetimeMillis);
+	else if (nIndex < VoiceStatsPresetRow)
+	{
+		const u8 nChannel = nIndex - VoiceStatsChannelRow;
+		snprintf(pOutBuffer, nSize, "Ch %d: %d st %u", nChannel + 1, Stats.ChannelVoices[nChannel], Stats.ChannelSteals[nChannel]);
+	}
+	else if (nIndex - VoiceStatsPresetRow < Stats.nPresets)
+	{
+		const TVoiceStats::TPresetPeak& Preset = Stats.Presets[nIndex - VoiceStatsPresetRow];
+		snprintf(pOutBuffer, nSize, "%03d:%03d pk %d", Preset.nBank, Preset.nProgram + 1, Preset.nPeakVoices);
+	}
+	else
+		pOutBuffer[0] = '\0';
+}
+
+CMainMenu::CMainMenu(TEventQueue& EventQueue, const CMIDIStats& MIDIStats, const CProfileManager& ProfileManager)
+	: CMenu("Menu"),
+	  m_EventQueue(EventQueue),
+	  m_nMasterVolume(0),
+	  m_pMT32Synth(nullptr),
+	  m_pSoundFontSynth(nullptr),
+	  m_SynthMenu(EventQueue),
+	  m_MT32ROMSetMenu(EventQueue),
+	  m_SoundFontMenu(EventQueue),
+	  m_ProfileMenu(EventQueue, ProfileManager),
+	  m_MIDIStatsMenu(MIDIStats),
+	  m_VoiceStatsMenu()
+{
+}
+
+void CMainMenu::SetSynths(CMT32Synth* pMT32Synth, CSoundFontSynth* pSoundFontSynth)
+{
+	m_pMT32Synth = pMT32Synth;
+	m_pSoundFontSynth = pSoundFontSynth;
+}
+
+void CMainMenu::GetItemText(size_t nIndex, char* pOutBuffer, size_t nSize) const
+{
+	switch (static_cast<TItem>(nIndex))
+	{
+		case TItem::Synth:
+			snprintf(pOutBuffer, nSize, "Synth");
+			break;
+
+		case TItem::MT32ROMSet:
+			snprintf(pOutBuffer, nSize, "MT-32 ROM set");
+			break;
+
+		case TItem::SoundFont:
+			snprintf(pOutBuffer, nSize, "SoundFont");
+			break;
+
+		case TItem::Profile:
+			snprintf(pOutBuffer, nSize, "Profile");
+			break;
+
+		case TItem::Volume:
+			snprintf(pOutBuffer, nSize, "Volume: %d", m_nMasterVolume);
+			break;
+
+		case TItem::MIDIStats:
+			snprintf(pOutBuffer, nSize, "MIDI stats");
+			break;
+
+		case TItem::VoiceStats:
+			snprintf(pOutBuffer, nSize, "Voice stats");
+			break;
+
+		default:
+			snprintf(pOutBuffer, nSize, "Exit");
+			break;
+	}
+}
+
+CMenu* CMainMenu::GetSubmenu(size_t nIndex)
+{
+	switch (static_cast<TItem>(nIndex))
+	{
+		case TItem::Synth:
+			return &m_SynthMenu;
+
+		case TItem::MT32ROMSet:
+			m_MT32ROMSetMenu.SetSynth(m_pMT32Synth);
+			return &m_MT32ROMSetMenu;
+
+		case TItem::SoundFont:
+			m_SoundFontMenu.SetSynth(m_pSoundFontSynth);
+			return &m_SoundFontMenu;
+
+		case TItem::Profile:
+			return &m_ProfileMenu;
+
+		case TItem::MIDIStats:
+			return &m_MIDIStatsMenu;
+
+		case TItem::VoiceStats:
+			m_VoiceStatsMenu.SetSynth(m_pSoundFontSynth);
+			return &m_VoiceStatsMenu;
+
+		default:
+			return nullptr;
+	}
+}
+
+void CMainMenu::Adjust(size_t nIndex, int nDelta)
+{
+	// Update the displayed value straight away; the main core applies it
+	m_nMasterVolume = Utility::Clamp(m_nMasterVolume + nDelta, 0, 100);
+
+	TEvent Event;
+	Event.Type = TEventType::MasterVolume;
+	Event.MasterVolume.nVolume = m_nMasterVolume;
+	m_EventQueue.Enqueue(Event);
+}
@@ -0,0 +1,252 @@
+//
+// menu.cpp
+//
+// mt32-pi - A baremetal MIDI synthesizer for Raspberry Pi
+// Copyright (C) 2020-2023 Dale Whinham <daleyo@gmail.com>
+//
+// This file is part of mt32-pi.
+//
+// mt32-pi is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// mt32-pi is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// mt32-pi. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <circle/util.h>
+
+#include <cstdio>
+
+#include "lcd/menu.h"
+#include "utility.h"
+
+CMenuSystem::CMenuSystem()
+	: m_pRootMenu(nullptr),
+	  m_pMenu(nullptr),
+	  m_bOpen(false),
+	  m_bEditing(false),
+	  m_nSelectedIndex(0),
+	  m_nScrollOffset(0),
+	  m_nLastInputTime(0),
+	  m_MenuStack{nullptr},
+	  m_IndexStack{0},
+	  m_nDepth(0),
+	  m_RowText{{'\0'}},
+	  m_nDirtyRows(0)
+{
+}
+
+bool CMenuSystem::Update(const CLCD& LCD, unsigned int nTicks)
+{
+	const bool bWasOpen = m_bOpen;
+	const u8 nRows = GetRowCount(LCD);
+	const size_t nItemRows = nRows > 2 ? nRows - 1 : nRows;
+
+	TMenuInput Input;
+	while (m_InputQueue.Dequeue(Input))
+	{
+		ProcessInput(Input, nItemRows);
+		m_nLastInputTime = nTicks;
+	}
+
+	// Close automatically after a period of inactivity
+	if (m_bOpen && (nTicks - m_nLastInputTime) >= Utility::MillisToTicks(TimeoutMillis))
+		Close();
+
+	// Closing damages the whole screen, which the caller takes care of
+	if (!m_bOpen)
+		return bWasOpen;
+
+	// Everything needs drawing when first opened
+	if (!bWasOpen)
+		m_nDirtyRows = 0xFF;
+
+	return RefreshRows(LCD) || !bWasOpen;
+}
+
+void CMenuSystem::Draw(CLCD& LCD, bool bRedrawAll)
+{
+	const u8 nRows = GetRowCount(LCD);
+
+	// Graphical LCDs redraw into a cleared framebuffer; character LCDs are written to directly, so only send changed rows
+	if (LCD.GetType() == CLCD::TType::Graphical)
+		bRedrawAll = true;
+
+	for (u8 nRow = 0; nRow < nRows; ++nRow)
+	{
+		if (bRedrawAll || (m_nDirtyRows & (1 << nRow)))
+			LCD.Print(m_RowText[nRow], 0, nRow, true, false);
+	}
+
+	m_nDirtyRows = 0;
+}
+
+void CMenuSystem::ProcessInput(TMenuInput Input, size_t nItemRows)
+{
+	if (!m_bOpen)
+	{
+		if (Input == TMenuInput::Select)
+			Open();
+		return;
+	}
+
+	const size_t nItems = m_pMenu->GetItemCount();
+
+	switch (Input)
+	{
+		case TMenuInput::Up:
+		case TMenuInput::Down:
+		{
+			const int nDelta = Input == TMenuInput::Up ? -1 : 1;
+
+			if (m_bEditing)
+				m_pMenu->Adjust(m_nSelectedIndex, nDelta);
+			else if (nDelta < 0 && m_nSelectedIndex > 0)
+				--m_nSelectedIndex;
+			else if (nDelta > 0 && m_nSelectedIndex + 1 < nItems)
+				++m_nSelectedIndex;
+			break;
+		}
+
+		case TMenuInput::Select:
+		{
+			if (!nItems)
+				break;
+
+			if (CMenu* pSubmenu = m_pMenu->GetSubmenu(m_nSelectedIndex))
+				EnterMenu(pSubmenu);
+			else if (m_pMenu->IsEditable(m_nSelectedIndex))
+				m_bEditing = !m_bEditing;
+			else if (m_pMenu->Select(m_nSelectedIndex))
+				Close();
+			break;
+		}
+
+		case TMenuInput::Back:
+			if (m_bEditing)
+				m_bEditing = false;
+			else if (m_nDepth > 0)
+				LeaveMenu();
+			else
+				Close();
+			break;
+	}
+
+	if (!m_bOpen)
+		return;
+
+	// List may have shrunk (e.g. SoundFonts removed)
+	const size_t nCurrentItems = m_pMenu->GetItemCount();
+	if (m_nSelectedIndex >= nCurrentItems)
+		m_nSelectedIndex = nCurrentItems ? nCurrentItems - 1 : 0;
+
+	// Keep the selection visible
+	if (m_nSelectedIndex < m_nScrollOffset)
+		m_nScrollOffset = m_nSelectedIndex;
+	else if (m_nSelectedIndex >= m_nScrollOffset + nItemRows)
+		m_nScrollOffset = m_nSelectedIndex - nItemRows + 1;
+}
+
+void CMenuSystem::Open()
+{
+	if (!m_pRootMenu)
+		return;
+
+	m_nDepth = 0;
+	m_pMenu = m_pRootMenu;
+	m_nSelectedIndex = m_pMenu->GetInitialIndex();
+	m_nScrollOffset = 0;
+	m_bEditing = false;
+	m_bOpen = true;
+}
+
+void CMenuSystem::Close()
+{
+	m_bOpen = false;
+	m_bEditing = false;
+}
+
+void CMenuSystem::EnterMenu(CMenu* pMenu)
+{
+	if (m_nDepth >= MaxDepth)
+		return;
+
+	m_MenuStack[m_nDepth] = m_pMenu;
+	m_IndexStack[m_nDepth] = m_nSelectedIndex;
+	++m_nDepth;
+
+	m_pMenu = pMenu;
+	m_nSelectedIndex = pMenu->GetInitialIndex();
+	m_nScrollOffset = 0;
+}
+
+void CMenuSystem::LeaveMenu()
+{
+	--m_nDepth;
+	m_pMenu = m_MenuStack[m_nDepth];
+	m_nSelectedIndex = m_IndexStack[m_nDepth];
+	m_nScrollOffset = 0;
+}
+
+bool CMenuSystem::RefreshRows(const CLCD& LCD)
+{
+	const u8 nRows = GetRowCount(LCD);
+	const u8 nWidth = GetRowWidth(LCD);
+	const bool bShowTitle = nRows > 2;
+	const size_t nItems = m_pMenu->GetItemCount();
+
+	for (u8 nRow = 0; nRow < nRows; ++nRow)
+	{
+		char Buffer[RowTextSize];
+
+		if (bShowTitle && nRow == 0)
+			snprintf(Buffer, sizeof(Buffer), "%s", m_pMenu->GetTitle());
+		else
+		{
+			const size_t nIndex = m_nScrollOffset + nRow - (bShowTitle ? 1 : 0);
+
+			if (nIndex < nItems)
+			{
+				char ItemText[RowTextSize];
+				m_pMenu->GetItemText(nIndex, ItemText, sizeof(ItemText));
+
+				const bool bSelected = nIndex == m_nSelectedIndex;
+				const char chMarker = bSelected ? (m_bEditing ? '*' : '>') : ' ';
+				snprintf(Buffer, sizeof(Buffer), "%c%s", chMarker, ItemText);
+			}
+			else
+				Buffer[0] = '\0';
+		}
+
+		Buffer[nWidth] = '\0';
+
+		// Only rows whose contents differ need redrawing
+		if (strcmp(Buffer, m_RowText[nRow]) != 0)
+		{
+			strcpy(m_RowText[nRow], Buffer);
+			m_nDirtyRows |= 1 << nRow;
+		}
+	}
+
+	return m_nDirtyRows != 0;
+}
+
+u8 CMenuSystem::GetRowCount(const CLCD& LCD)
+{
+	const u8 nRows = LCD.GetType() == CLCD::TType::Graphical ? LCD.Height() / 16 : LCD.Height();
+	return Utility::Min<u8>(nRows, MaxRows);
+}
+
+u8 CMenuSystem::GetRowWidth(const CLCD& LCD)
+{
+	// TODO: API for getting width in pixels/characters for a string
+	const u8 nWidth = LCD.GetType() == CLCD::TType::Graphical ? 20 : LCD.Width();
+	return Utility::Min<u8>(nWidth, RowTextSize - 1);
+}
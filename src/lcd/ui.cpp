@@ -38,6 +38,8 @@ CUserInterface::CUserInterface()
 	: m_State(TState::None),
 	  m_nStateTime(0),
 	  m_bIsScrolling(false),
+	  m_bIsAnimating(false),
+	  m_nDamage(WidgetAll),
 	  m_nCurrentScrollOffset(0),
 	  m_nCurrentSpinnerChar(0),
 	  m_CurrentImage(TImage::None),
@@ -73,6 +75,7 @@ bool CUserInterface::UpdateScroll(CLCD& LCD, unsigned int nTicks)
 	{
 		++m_nCurrentScrollOffset;
 		m_nStateTime = nTicks;
+		Invalidate(m_State == TState::DisplayingMessage ? WidgetMessage : WidgetSysEx);
 	}
 
 	return true;
@@ -90,6 +93,7 @@ void CUserInterface::Update(CLCD& LCD, CSynthBase& Synth, unsigned int nTicks)
 	{
 		m_State = TState::None;
 		m_nStateTime = nTicks;
+		Invalidate();
 	}
 
 	// Spinner update
@@ -101,6 +105,7 @@ void CUserInterface::Update(CLCD& LCD, CSynthBase& Synth, unsigned int nTicks)
 		m_nCurrentSpinnerChar = (m_nCurrentSpinnerChar + 1) % sizeof(SpinnerChars);
 		m_SystemMessageTextBuffer[nCharWidth - 2] = SpinnerChars[m_nCurrentSpinnerChar];
 		m_nStateTime = nTicks;
+		Invalidate(WidgetMessage);
 	}
 
 	// Image display update
@@ -108,6 +113,7 @@ void CUserInterface::Update(CLCD& LCD, CSynthBase& Synth, unsigned int nTicks)
 	{
 		m_State = TState::None;
 		m_nStateTime = nTicks;
+		Invalidate();
 	}
 
 	// SC-55 text timeout
@@ -115,6 +121,7 @@ void CUserInterface::Update(CLCD& LCD, CSynthBase& Synth, unsigned int nTicks)
 	{
 		m_State = TState::None;
 		m_nStateTime = nTicks;
+		Invalidate();
 	}
 
 	// Power saving
@@ -131,13 +138,38 @@ void CUserInterface::Update(CLCD& LCD, CSynthBase& Synth, unsigned int nTicks)
 
 	// Power saving mode: no-op
 	if (m_State == TState::InPowerSavingMode)
+	{
+		m_bIsAnimating = false;
+		return;
+	}
+
+	// Process menu input and refresh its rows
+	if (m_MenuSystem.Update(LCD, nTicks))
+		Invalidate(WidgetMenu);
+
+	// Sample the synth's display state; only counts as damage when the synth UI is visible
+	const bool bMenuOpen = m_MenuSystem.IsOpen();
+	const u8 nSynthDamage = Synth.UpdateLCDState(LCD, nTicks);
+	if (m_State == TState::None && !bMenuOpen)
+		Invalidate(nSynthDamage);
+
+	m_bIsAnimating = m_bIsScrolling || m_State == TState::DisplayingSpinnerMessage || (m_State == TState::None && !bMenuOpen && Synth.IsLCDAnimating());
+
+	// Nothing changed; skip this frame entirely
+	const u8 nDamage = __atomic_exchange_n(&m_nDamage, WidgetNone, __ATOMIC_ACQ_REL);
+	if (nDamage == WidgetNone)
 		return;
 
 	LCD.Clear(false);
 
-	// Draw synth UI if no drawable system state
+	// Draw menu or synth UI if no drawable system state
 	if (!DrawSystemState(LCD))
-		Synth.UpdateLCD(LCD, nTicks);
+	{
+		if (bMenuOpen)
+			m_MenuSystem.Draw(LCD, nDamage != WidgetMenu);
+		else
+			Synth.UpdateLCD(LCD, nTicks);
+	}
 
 	LCD.Flip();
 }
@@ -161,12 +193,14 @@ void CUserInterface::ShowSystemMessage(const char* pMessage, bool bSpinner)
 
 	m_nCurrentScrollOffset = 0;
 	m_nStateTime = nTicks;
+	Invalidate();
 }
 
 void CUserInterface::ClearSpinnerMessage()
 {
 	m_State = TState::None;
 	m_nCurrentSpinnerChar = 0;
+	Invalidate();
 }
 
 void CUserInterface::DisplayImage(TImage Image)
@@ -175,6 +209,7 @@ void CUserInterface::DisplayImage(TImage Image)
 	m_CurrentImage = Image;
 	m_State = TState::DisplayingImage;
 	m_nStateTime = nTicks;
+	Invalidate();
 }
 
 void CUserInterface::ShowSysExText(TSysExDisplayMessage Type, const u8* pMessage, size_t nSize, u8 nOffset)
@@ -191,6 +226,7 @@ void CUserInterface::ShowSysExText(TSysExDisplayMessage Type, const u8* pMessage
 	m_State = TState::DisplayingSysExText;
 	m_nCurrentScrollOffset = 0;
 	m_nStateTime = nTicks;
+	Invalidate();
 }
 
 void CUserInterface::ShowSysExBitmap(TSysExDisplayMessage Type, const u8* pData, size_t nSize)
@@ -207,6 +243,7 @@ void CUserInterface::ShowSysExBitmap(TSysExDisplayMessage Type, const u8* pData,
 	memcpy(m_SysExPixelBuffer, pData, nSize);
 	m_State = TState::DisplayingSysExBitmap;
 	m_nStateTime = nTicks;
+	Invalidate();
 }
 
 void CUserInterface::EnterPowerSavingMode()
@@ -215,11 +252,13 @@ void CUserInterface::EnterPowerSavingMode()
 	snprintf(m_SystemMessageTextBuffer, sizeof(m_SystemMessageTextBuffer), "Power saving mode");
 	m_State = TState::EnteringPowerSavingMode;
 	m_nStateTime = nTicks;
+	Invalidate();
 }
 
 void CUserInterface::ExitPowerSavingMode()
 {
 	m_State = TState::None;
+	Invalidate();
 }
 
 u8 CUserInterface::CenterMessageOffset(CLCD& LCD, const char* pMessage)
@@ -248,6 +287,25 @@ void CUserInterface::DrawChannelLevels(CLCD& LCD, u8 nBarHeight, float* pChannel
 	}
 }
 
+bool CUserInterface::QuantizeChannelLevels(const CLCD& LCD, u8 nBarHeight, const float* pChannelLevels, const float* pPeakLevels, u8 nChannels, u8* pLevelPixels, u8* pPeakPixels)
+{
+	// Match the resolution the bars are drawn at so that only visible changes count as damage
+	const u8 nBarMaxY = LCD.GetType() == CLCD::TType::Character ? nBarHeight * 8 : nBarHeight - 1;
+	bool bChanged = false;
+
+	for (u8 nChannel = 0; nChannel < nChannels; ++nChannel)
+	{
+		const u8 nLevelPixels = pChannelLevels[nChannel] * nBarMaxY;
+		const u8 nPeakPixels = pPeakLevels ? pPeakLevels[nChannel] * nBarMaxY : 0;
+
+		bChanged |= nLevelPixels != pLevelPixels[nChannel] || nPeakPixels != pPeakPixels[nChannel];
+		pLevelPixels[nChannel] = nLevelPixels;
+		pPeakPixels[nChannel] = nPeakPixels;
+	}
+
+	return bChanged;
+}
+
 void CUserInterface::DrawChannelLevelsCharacter(CLCD& LCD, u8 nRows, u8 nBarOffsetX, u8 nBarYOffset, u8 nBarSpacing, const float* pChannelLevels, u8 nChannels, bool bDrawBarBases)
 {
 	const u8 nWidth = LCD.Width();
@@ -430,6 +488,9 @@ void CUserInterface::DrawSysExBitmap(CLCD& LCD, u8 nFirstRow, u8 nRows) const
 		nTailPixels = 2;
 	}
 
+	// Unpack into a 16x16 1bpp bitmap and blit it in one go
+	u8 Bitmap[16 * 2] = {0};
+
 	for (u8 nByte = 0; nByte < sizeof(m_SysExPixelBuffer); ++nByte)
 	{
 		const u8 nPixels = nByte < nHeadLength ? nHeadPixels : nTailPixels;
@@ -444,10 +505,10 @@ void CUserInterface::DrawSysExBitmap(CLCD& LCD, u8 nFirstRow, u8 nRows) const
 			const u8 nPosX = nByte / 16 * nHeadPixels + nPixel;
 			const u8 nPosY = nByte % 16;
 
-			const u8 nScaledX = nOffsetX + nPosX * nScaleX;
-			const u8 nScaledY = nOffsetY + nPosY * nScaleY;
-
-			LCD.DrawFilledRect(nScaledX, nScaledY, nScaledX + nScaleX - 1, nScaledY + nScaleY - 1);
+			if (nPosX < 16)
+				Bitmap[nPosY * 2 + nPosX / 8] |= 0x80 >> (nPosX % 8);
 		}
 	}
+
+	LCD.DrawBitmap(Bitmap, 16, 16, nOffsetX, nOffsetY, nScaleX, nScaleY);
 }
@@ -26,15 +26,39 @@
 
 LOGMODULE("midiparser");
 
+CMIDIParser::TStream::TStream()
+	: State(TState::StatusByte),
+	  MessageBuffer{0},
+	  nMessageLength(0),
+	  bRunningStatus(false),
+	  nErrors(0)
+{
+}
+
 CMIDIParser::CMIDIParser()
-	: m_State(TState::StatusByte),
-	  m_MessageBuffer{0},
-	  m_nMessageLength(0)
+	: m_CurrentSource(TMIDISource::Serial),
+	  m_pStream(&m_DefaultStream),
+	  m_bParsing(false)
 {
 }
 
-void CMIDIParser::ParseMIDIBytes(const u8* pData, size_t nSize, bool bIgnoreNoteOns)
+void CMIDIParser::ParseMIDIBytes(const u8* pData, size_t nSize, TMIDISource Source, bool bIgnoreNoteOns)
 {
+	ParseMIDIBytes(pData, nSize, Source, m_DefaultStream, bIgnoreNoteOns);
+}
+
+void CMIDIParser::ParseMIDIBytes(const u8* pData, size_t nSize, TMIDISource Source, TStream& Stream, bool bIgnoreNoteOns)
+{
+	// A message handler may parse other bytes before returning; put the outer parse's state back afterwards
+	const TMIDISource PreviousSource = m_CurrentSource;
+	TStream* const pPreviousStream = m_pStream;
+	const bool bWasParsing = m_bParsing;
+
+	m_CurrentSource = Source;
+	m_pStream = &Stream;
+	m_bParsing = true;
+	m_MIDIStats.SetSource(Source, nSize);
+
 	// Process MIDI messages
 	// See: https://www.midi.org/specifications/item/table-1-summary-of-midi-message
 	for (size_t i = 0; i < nSize; ++i)
@@ -47,12 +71,15 @@ void CMIDIParser::ParseMIDIBytes(const u8* pData, size_t nSize, bool bIgnoreNote
 		{
 			// Ignore undefined System Real-Time
 			if (nByte != 0xF9 && nByte != 0xFD)
+			{
+				m_MIDIStats.CountShortMessage(nByte, false);
 				OnShortMessage(nByte);
+			}
 
 			continue;
 		}
 
-		switch (m_State)
+		switch (m_pStream->State)
 		{
 			// Expecting a status byte
 			case TState::StatusByte:
@@ -64,13 +91,14 @@ void CMIDIParser::ParseMIDIBytes(const u8* pData, size_t nSize, bool bIgnoreNote
 				// Expected a data byte, but received a status
 				if (nByte & 0x80)
 				{
+					CountError(CMIDIStats::TParserError::UnexpectedStatus);
 					OnUnexpectedStatus();
 					ResetState(true);
 					ParseStatusByte(nByte);
 					break;
 				}
 
-				m_MessageBuffer[m_nMessageLength++] = nByte;
+				m_pStream->MessageBuffer[m_pStream->nMessageLength++] = nByte;
 				CheckCompleteShortMessage(bIgnoreNoteOns);
 				break;
 
@@ -79,6 +107,7 @@ void CMIDIParser::ParseMIDIBytes(const u8* pData, size_t nSize, bool bIgnoreNote
 				// Received a status that wasn't EOX
 				if (nByte & 0x80 && nByte != 0xF7)
 				{
+					CountError(CMIDIStats::TParserError::UnexpectedStatusInSysEx);
 					OnUnexpectedStatus();
 					ResetState(true);
 					ParseStatusByte(nByte);
@@ -86,31 +115,44 @@ void CMIDIParser::ParseMIDIBytes(const u8* pData, size_t nSize, bool bIgnoreNote
 				}
 
 				// Buffer overflow
-				if (m_nMessageLength == sizeof(m_MessageBuffer))
+				if (m_pStream->nMessageLength == sizeof(m_pStream->MessageBuffer))
 				{
+					CountError(CMIDIStats::TParserError::SysExOverflow);
 					OnSysExOverflow();
 					ResetState(true);
 					ParseStatusByte(nByte);
 					break;
 				}
 
-				m_MessageBuffer[m_nMessageLength++] = nByte;
+				m_pStream->MessageBuffer[m_pStream->nMessageLength++] = nByte;
 
 				// End of SysEx
 				if (nByte == 0xF7)
 				{
-					OnSysExMessage(m_MessageBuffer, m_nMessageLength);
+					m_MIDIStats.CountSysEx(m_pStream->nMessageLength);
+					OnSysExMessage(m_pStream->MessageBuffer, m_pStream->nMessageLength);
 					ResetState(true);
 				}
 
 				break;
 		}
 	}
+
+	m_CurrentSource = PreviousSource;
+	m_pStream = pPreviousStream;
+	m_bParsing = bWasParsing;
+	m_MIDIStats.SetSource(PreviousSource, 0);
+}
+
+void CMIDIParser::CountError(CMIDIStats::TParserError Error)
+{
+	m_MIDIStats.CountError(Error);
+	++m_pStream->nErrors;
 }
 
 void CMIDIParser::OnUnexpectedStatus()
 {
-	if (m_State == TState::SysExByte)
+	if (m_pStream->State == TState::SysExByte)
 		LOGWARN("Received illegal status byte during SysEx message; SysEx ignored");
 	else
 		LOGWARN("Received illegal status byte when data expected");
@@ -132,52 +174,56 @@ void CMIDIParser::ParseStatusByte(u8 nByte)
 			case 0xF4:
 			case 0xF5:
 			case 0xF7:
-				m_MessageBuffer[0] = 0;
+				m_pStream->MessageBuffer[0] = 0;
 				return;
 
 			// Start of SysEx message
 			case 0xF0:
-				m_State = TState::SysExByte;
+				m_pStream->State = TState::SysExByte;
 				break;
 
 			// Tune Request - single byte, handle immediately and clear running status
 			case 0xF6:
+				m_MIDIStats.CountShortMessage(nByte, false);
 				OnShortMessage(nByte);
-				m_MessageBuffer[0] = 0;
+				m_pStream->MessageBuffer[0] = 0;
 				break;
 
 			// Channel or System Common message
 			default:
-				m_State = TState::DataByte;
+				m_pStream->State = TState::DataByte;
 				break;
 		}
 
-		m_MessageBuffer[m_nMessageLength++] = nByte;
+		m_pStream->MessageBuffer[m_pStream->nMessageLength++] = nByte;
 	}
 
 	// Data byte, use Running Status if we've stored a status byte
-	else if (m_MessageBuffer[0])
+	else if (m_pStream->MessageBuffer[0])
 	{
-		m_MessageBuffer[1] = nByte;
-		m_nMessageLength = 2;
+		m_pStream->MessageBuffer[1] = nByte;
+		m_pStream->nMessageLength = 2;
+		m_pStream->bRunningStatus = true;
 
 		// We could have a complete 2-byte message, otherwise wait for third byte
 		if (!CheckCompleteShortMessage())
-			m_State = TState::DataByte;
+			m_pStream->State = TState::DataByte;
 	}
 }
 
 bool CMIDIParser::CheckCompleteShortMessage(bool bIgnoreNoteOns)
 {
-	const u8 nStatus = m_MessageBuffer[0];
+	const u8 nStatus = m_pStream->MessageBuffer[0];
 
 	// MIDI message is complete if we receive 3 bytes,
 	// or 2 bytes if it's a Program Change, Channel Pressure/Aftertouch, Time Code Quarter Frame, or Song Select
-	if (m_nMessageLength == 3 ||
-		(m_nMessageLength == 2 && ((nStatus >= 0xC0 && nStatus <= 0xDF) || nStatus == 0xF1 || nStatus == 0xF3)))
+	if (m_pStream->nMessageLength == 3 ||
+		(m_pStream->nMessageLength == 2 && ((nStatus >= 0xC0 && nStatus <= 0xDF) || nStatus == 0xF1 || nStatus == 0xF3)))
 	{
 		const bool bIsNoteOn = (nStatus & 0xF0) == 0x90;
 
+		m_MIDIStats.CountShortMessage(nStatus, m_pStream->bRunningStatus);
+
 		if (!(bIsNoteOn && bIgnoreNoteOns))
 			OnShortMessage(PrepareShortMessage());
 
@@ -191,11 +237,11 @@ bool CMIDIParser::CheckCompleteShortMessage(bool bIgnoreNoteOns)
 
 u32 CMIDIParser::PrepareShortMessage() const
 {
-	assert(m_nMessageLength == 2 || m_nMessageLength == 3);
+	assert(m_pStream->nMessageLength == 2 || m_pStream->nMessageLength == 3);
 
 	u32 nMessage = 0;
-	for (size_t i = 0; i < m_nMessageLength; ++i)
-		nMessage |= m_MessageBuffer[i] << 8 * i;
+	for (size_t i = 0; i < m_pStream->nMessageLength; ++i)
+		nMessage |= m_pStream->MessageBuffer[i] << 8 * i;
 
 	return nMessage;
 }
@@ -203,8 +249,9 @@ u32 CMIDIParser::PrepareShortMessage() const
 void CMIDIParser::ResetState(bool bClearStatusByte)
 {
 	if (bClearStatusByte)
-		m_MessageBuffer[0] = 0;
+		m_pStream->MessageBuffer[0] = 0;
 
-	m_nMessageLength = 0;
-	m_State = TState::StatusByte;
+	m_pStream->nMessageLength = 0;
+	m_pStream->bRunningStatus = false;
+	m_pStream->State = TState::StatusByte;
 }
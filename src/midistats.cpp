@@ -0,0 +1,153 @@
+//
+// midistats.cpp
+//
+// mt32-pi - A baremetal MIDI synthesizer for Raspberry Pi
+// Copyright (C) 2020-2023 Dale Whinham <daleyo@gmail.com>
+//
+// This file is part of mt32-pi.
+//
+// mt32-pi is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// mt32-pi is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// mt32-pi. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <circle/logger.h>
+#include <circle/timer.h>
+
+#include "midistats.h"
+#include "utility.h"
+
+LOGMODULE("midistats");
+
+const char* const SourceNames[] = { "Serial", "USB serial", "USB", "RTP-MIDI", "UDP MIDI", "Generator" };
+const char* const MessageTypeNames[] = { "Note off", "Note on", "Poly AT", "CC", "Prog chg", "Chan AT", "Pitch bend", "Sys common", "Realtime", "SysEx" };
+const char* const ParserErrorNames[] = { "Unexp status", "Unexp in SysEx", "SysEx overflow" };
+const char* const SysExSizeBucketNames[] = { "<=16", "<=64", "<=256", ">256" };
+
+static_assert(Utility::ArraySize(SourceNames) == static_cast<size_t>(TMIDISource::Count), "Source names don't match");
+static_assert(Utility::ArraySize(MessageTypeNames) == static_cast<size_t>(CMIDIStats::TMessageType::Count), "Message type names don't match");
+static_assert(Utility::ArraySize(ParserErrorNames) == static_cast<size_t>(CMIDIStats::TParserError::Count), "Parser error names don't match");
+static_assert(Utility::ArraySize(SysExSizeBucketNames) == CMIDIStats::SysExSizeBucketCount, "SysEx size bucket names don't match");
+
+CMIDIStats::CMIDIStats()
+{
+	Reset();
+}
+
+void CMIDIStats::Reset()
+{
+	m_Source = TMIDISource::Serial;
+
+	for (size_t i = 0; i < SourceCount; ++i)
+	{
+		m_SourceBytes[i] = 0;
+		m_SourceMessages[i] = 0;
+		m_PrevSourceMessages[i] = 0;
+		m_SourceRates[i] = 0;
+	}
+
+	for (size_t i = 0; i < ChannelCount; ++i)
+	{
+		m_ChannelMessages[i] = 0;
+		m_PrevChannelMessages[i] = 0;
+		m_ChannelRates[i] = 0;
+	}
+
+	for (auto& nCount : m_MessageTypes)
+		nCount = 0;
+
+	for (auto& nCount : m_SysExSizes)
+		nCount = 0;
+
+	for (auto& nCount : m_ParserErrors)
+		nCount = 0;
+
+	m_nChannelMessages = 0;
+	m_nRunningStatusMessages = 0;
+	m_nRateWindowStartTime = CTimer::Get()->GetTicks();
+	m_nTotalRate = 0;
+}
+
+void CMIDIStats::Update(unsigned int nTicks)
+{
+	const unsigned int nElapsed = nTicks - m_nRateWindowStartTime;
+	if (nElapsed < HZ)
+		return;
+
+	u32 nTotalRate = 0;
+	for (size_t i = 0; i < SourceCount; ++i)
+	{
+		m_SourceRates[i] = (m_SourceMessages[i] - m_PrevSourceMessages[i]) * HZ / nElapsed;
+		m_PrevSourceMessages[i] = m_SourceMessages[i];
+		nTotalRate += m_SourceRates[i];
+	}
+
+	for (size_t i = 0; i < ChannelCount; ++i)
+	{
+		m_ChannelRates[i] = (m_ChannelMessages[i] - m_PrevChannelMessages[i]) * HZ / nElapsed;
+		m_PrevChannelMessages[i] = m_ChannelMessages[i];
+	}
+
+	m_nTotalRate = nTotalRate;
+	m_nRateWindowStartTime = nTicks;
+}
+
+u8 CMIDIStats::GetRunningStatusPercent() const
+{
+	const u32 nChannelMessages = m_nChannelMessages;
+	return nChannelMessages ? static_cast<u64>(m_nRunningStatusMessages) * 100 / nChannelMessages : 0;
+}
+
+void CMIDIStats::Dump() const
+{
+	LOGNOTE("Total: %d msg/s", m_nTotalRate);
+
+	for (size_t i = 0; i < SourceCount; ++i)
+		LOGNOTE("%s: %d msg/s, %d bytes", SourceNames[i], m_SourceRates[i], m_SourceBytes[i]);
+
+	for (size_t i = 0; i < ChannelCount; ++i)
+	{
+		if (m_ChannelMessages[i])
+			LOGNOTE("Channel %d: %d msg/s, %d total", i + 1, m_ChannelRates[i], m_ChannelMessages[i]);
+	}
+
+	for (size_t i = 0; i < static_cast<size_t>(TMessageType::Count); ++i)
+		LOGNOTE("%s: %d", MessageTypeNames[i], m_MessageTypes[i]);
+
+	LOGNOTE("Running status: %d%%", GetRunningStatusPercent());
+
+	for (size_t i = 0; i < SysExSizeBucketCount; ++i)
+		LOGNOTE("SysEx %s bytes: %d", SysExSizeBucketNames[i], m_SysExSizes[i]);
+
+	for (size_t i = 0; i < static_cast<size_t>(TParserError::Count); ++i)
+		LOGNOTE("%s: %d", ParserErrorNames[i], m_ParserErrors[i]);
+}
+
+const char* CMIDIStats::GetSourceName(TMIDISource Source)
+{
+	return SourceNames[static_cast<size_t>(Source)];
+}
+
+const char* CMIDIStats::GetMessageTypeName(TMessageType Type)
+{
+	return MessageTypeNames[static_cast<size_t>(Type)];
+}
+
+const char* CMIDIStats::GetParserErrorName(TParserError Error)
+{
+	return ParserErrorNames[static_cast<size_t>(Error)];
+}
+
+const char* CMIDIStats::GetSysExSizeBucketName(size_t nBucket)
+{
+	return SysExSizeBucketNames[nBucket];
+}
@@ -0,0 +1,245 @@
+//
+// midistress.cpp
+//
+// mt32-pi - A baremetal MIDI synthesizer for Raspberry Pi
+// Copyright (C) 2020-2023 Dale Whinham <daleyo@gmail.com>
+//
+// This file is part of mt32-pi.
+//
+// mt32-pi is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// mt32-pi is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// mt32-pi. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "midistress.h"
+#include "utility.h"
+
+constexpr u8 StressCCNumbers[] = { 1, 7, 10, 11, 71, 74, 91, 93 };
+
+CMIDIStressGenerator::CMIDIStressGenerator()
+	: m_Pattern(TPattern::Stop),
+	  m_nCount(0),
+	  m_nPeriod(0),
+	  m_nStartTime(0),
+	  m_nDuration(0),
+	  m_nNextBurstTime(0),
+	  m_nBurstIndex(0),
+
+	  m_nClusterChannel(0),
+	  m_nClusterSize(0),
+
+	  m_nReportTime(0),
+	  m_Report{},
+	  m_nTotalLatenessMicros(0)
+{
+}
+
+void CMIDIStressGenerator::Start(TPattern Pattern, u8 nCount, u8 nRate, u8 nDuration, unsigned int nTicks)
+{
+	m_Pattern = Pattern < TPattern::Count ? Pattern : TPattern::Stop;
+	m_nCount = Utility::Max(nCount, static_cast<u8>(1));
+	m_nPeriod = Utility::MillisToTicks(1000u) / Utility::Max(nRate, static_cast<u8>(1));
+	m_nStartTime = nTicks;
+	m_nDuration = Utility::MillisToTicks(nDuration * 1000u);
+	m_nNextBurstTime = nTicks;
+	m_nBurstIndex = 0;
+
+	m_nReportTime = nTicks;
+	m_Report = TReport{};
+	m_nTotalLatenessMicros = 0;
+}
+
+size_t CMIDIStressGenerator::Generate(unsigned int nTicks, u8* pOutBuffer, size_t nSize)
+{
+	if (IsRunning() && m_nDuration && (nTicks - m_nStartTime) >= m_nDuration)
+		Stop();
+
+	// Release notes held by the last cluster once stopped or switched to another pattern
+	if (m_nClusterSize && m_Pattern != TPattern::NoteClusters)
+		return ReleaseNoteCluster(pOutBuffer, nSize);
+
+	if (!IsRunning())
+		return 0;
+
+	// Not due yet
+	if (static_cast<int>(nTicks - m_nNextBurstTime) < 0)
+		return 0;
+
+	const unsigned int nLatenessMicros = nTicks - m_nNextBurstTime;
+	m_nNextBurstTime += m_nPeriod;
+
+	// Don't try to catch up after a stall; the lateness has already been recorded
+	if (static_cast<int>(nTicks - m_nNextBurstTime) >= 0)
+		m_nNextBurstTime = nTicks + m_nPeriod;
+
+	size_t nBytes;
+	switch (m_Pattern)
+	{
+		case TPattern::NoteClusters:
+			nBytes = GenerateNoteCluster(pOutBuffer, nSize);
+			break;
+
+		case TPattern::CCStorm:
+			nBytes = GenerateCCStorm(pOutBuffer, nSize);
+			break;
+
+		case TPattern::RunningStatusFlood:
+			nBytes = GenerateRunningStatusFlood(pOutBuffer, nSize);
+			break;
+
+		case TPattern::MT32TimbreSysEx:
+			nBytes = GenerateTimbreSysEx(pOutBuffer, nSize);
+			break;
+
+		default:
+			nBytes = 0;
+			break;
+	}
+
+	++m_nBurstIndex;
+
+	++m_Report.nBursts;
+	m_Report.nBytes += nBytes;
+	m_Report.nMaxLatenessMicros = Utility::Max(m_Report.nMaxLatenessMicros, static_cast<u32>(nLatenessMicros));
+	m_nTotalLatenessMicros += nLatenessMicros;
+
+	return nBytes;
+}
+
+void CMIDIStressGenerator::AddDispatchTime(unsigned int nMicros)
+{
+	m_Report.nMaxDispatchMicros = Utility::Max(m_Report.nMaxDispatchMicros, static_cast<u32>(nMicros));
+}
+
+bool CMIDIStressGenerator::TakeReport(unsigned int nTicks, TReport& OutReport)
+{
+	// Nothing to report; the final period is still reported after stopping
+	if (!IsRunning() && !m_Report.nBursts)
+		return false;
+
+	if ((nTicks - m_nReportTime) < Utility::MillisToTicks(ReportPeriodMillis))
+		return false;
+
+	m_Report.nAvgLatenessMicros = m_Report.nBursts ? m_nTotalLatenessMicros / m_Report.nBursts : 0;
+	OutReport = m_Report;
+
+	m_nReportTime = nTicks;
+	m_Report = TReport{};
+	m_nTotalLatenessMicros = 0;
+
+	return true;
+}
+
+size_t CMIDIStressGenerator::GenerateNoteCluster(u8* pOutBuffer, size_t nSize)
+{
+	size_t nBytes = ReleaseNoteCluster(pOutBuffer, nSize);
+
+	m_nClusterChannel = m_nBurstIndex % 16;
+	for (u8 i = 0; i < m_nCount && nBytes + 3 <= nSize; ++i)
+	{
+		pOutBuffer[nBytes++] = 0x90 | m_nClusterChannel;
+		pOutBuffer[nBytes++] = GetClusterNote(i);
+		pOutBuffer[nBytes++] = 100;
+		++m_nClusterSize;
+	}
+
+	return nBytes;
+}
+
+size_t CMIDIStressGenerator::ReleaseNoteCluster(u8* pOutBuffer, size_t nSize)
+{
+	size_t nBytes = 0;
+
+	for (u8 i = 0; i < m_nClusterSize && nBytes + 3 <= nSize; ++i)
+	{
+		pOutBuffer[nBytes++] = 0x80 | m_nClusterChannel;
+		pOutBuffer[nBytes++] = GetClusterNote(i);
+		pOutBuffer[nBytes++] = 0;
+	}
+
+	m_nClusterSize = 0;
+	return nBytes;
+}
+
+size_t CMIDIStressGenerator::GenerateCCStorm(u8* pOutBuffer, size_t nSize)
+{
+	size_t nBytes = 0;
+
+	for (u8 i = 0; i < m_nCount && nBytes + 3 <= nSize; ++i)
+	{
+		pOutBuffer[nBytes++] = 0xB0 | ((m_nBurstIndex + i) % 16);
+		pOutBuffer[nBytes++] = StressCCNumbers[i % Utility::ArraySize(StressCCNumbers)];
+		pOutBuffer[nBytes++] = (m_nBurstIndex * 8 + i) & 0x7F;
+	}
+
+	return nBytes;
+}
+
+size_t CMIDIStressGenerator::GenerateRunningStatusFlood(u8* pOutBuffer, size_t nSize)
+{
+	if (nSize < 1)
+		return 0;
+
+	size_t nBytes = 0;
+	pOutBuffer[nBytes++] = 0x90 | (m_nBurstIndex % 16);
+
+	// Each note is switched on and then off with a zero velocity, all under the one status byte
+	for (u8 i = 0; i < m_nCount && nBytes + 4 <= nSize; ++i)
+	{
+		const u8 nNote = 48 + i % 24;
+		pOutBuffer[nBytes++] = nNote;
+		pOutBuffer[nBytes++] = 64;
+		pOutBuffer[nBytes++] = nNote;
+		pOutBuffer[nBytes++] = 0;
+	}
+
+	return nBytes;
+}
+
+size_t CMIDIStressGenerator::GenerateTimbreSysEx(u8* pOutBuffer, size_t nSize)
+{
+	size_t nBytes = 0;
+
+	for (u8 i = 0; i < m_nCount && nBytes + TimbreSysExSize <= nSize; ++i)
+	{
+		u8* pMessage = pOutBuffer + nBytes;
+		const u8 nTimbre = (m_nBurstIndex + i) % 64;
+
+		// Roland DT1 to MT-32 timbre memory (08 00 00 + timbre * 02 00)
+		const u8 Header[] = { 0xF0, 0x41, 0x10, 0x16, 0x12, 0x08, static_cast<u8>(nTimbre * 2), 0x00 };
+		for (size_t j = 0; j < sizeof(Header); ++j)
+			pMessage[j] = Header[j];
+
+		u8* pTimbre = pMessage + sizeof(Header);
+		const size_t nTimbreSize = TimbreSysExSize - sizeof(Header) - 2;
+		for (size_t j = 0; j < nTimbreSize; ++j)
+			pTimbre[j] = 0;
+
+		// Common parameters: name, then leave all partials unmuted
+		const char Name[] = "Stress    ";
+		for (size_t j = 0; j < 10; ++j)
+			pTimbre[j] = Name[j];
+		pTimbre[12] = 0x0F;
+
+		// Checksum covers address and data
+		u8 nSum = 0;
+		for (size_t j = 5; j < sizeof(Header) + nTimbreSize; ++j)
+			nSum += pMessage[j];
+
+		pMessage[TimbreSysExSize - 2] = (128 - (nSum & 0x7F)) & 0x7F;
+		pMessage[TimbreSysExSize - 1] = 0xF7;
+
+		nBytes += TimbreSysExSize;
+	}
+
+	return nBytes;
+}
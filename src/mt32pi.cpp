@@ -20,6 +20,7 @@
 // mt32-pi. If not, see <http://www.gnu.org/licenses/>.
 //
 
+#include <circle/alloc.h>
 #include <circle/memory.h>
 #include <circle/serial.h>
 #include <circle/sound/hdmisoundbasedevice.h>
@@ -27,11 +28,14 @@
 #include <circle/sound/pwmsoundbasedevice.h>
 
 #include <cstdarg>
+#include <cstring>
 
+#include "gcovwriter.h"
 #include "lcd/drivers/hd44780.h"
 #include "lcd/drivers/ssd1306.h"
 #include "lcd/ui.h"
 #include "mt32pi.h"
+#include "zoneallocator.h"
 
 #define MT32_PI_NAME "mt32-pi"
 LOGMODULE(MT32_PI_NAME);
@@ -39,14 +43,53 @@ const char MT32PiFullName[] = MT32_PI_NAME " " MT32_PI_VERSION;
 
 const char WLANFirmwarePath[] = "SD:firmware/";
 const char WLANConfigFile[]   = "SD:wpa_supplicant.conf";
+const char ProfilesFile[]     = "SD:profiles.cfg";
+const char ConfigFile[]       = "SD:mt32-pi.cfg";
+const char ProfileDataDir[]   = "SD:pgo";
 
 constexpr u32 LCDUpdatePeriodMillis                = 16;
+constexpr u32 LCDIdleUpdatePeriodMillis            = 50;
 constexpr u32 MisterUpdatePeriodMillis             = 50;
 constexpr u32 LEDTimeoutMillis                     = 50;
 constexpr u32 ActiveSenseTimeoutMillis             = 330;
 
 constexpr float Sample24BitMax = (1 << 24 - 1) - 1;
 
+// Sample conversion is split in two so that a render helper core can take half of it
+constexpr size_t ConvertJobCount = 2;
+
+struct TConvertJob
+{
+	const float* pIn;
+	s8* pOut;
+	size_t nBegin;
+	size_t nEnd;
+	u8 nBytesPerSample;
+	bool bReversedStereo;
+};
+
+static void ConvertSamplesJob(void* pParam)
+{
+	const TConvertJob& Job = *static_cast<const TConvertJob*>(pParam);
+	if (Job.nBegin == Job.nEnd)
+		return;
+
+	// Flipping the lowest bit of the index swaps left and right
+	const size_t nSwap = Job.bReversedStereo ? 1 : 0;
+	const size_t nLast = Job.nEnd - 1;
+
+	// Convert to signed 24-bit integers; the extra byte of each 32-bit write is overwritten by the next sample
+	for (size_t i = Job.nBegin; i < nLast; ++i)
+	{
+		s32* const pSample = reinterpret_cast<s32*>(Job.pOut + i * Job.nBytesPerSample);
+		*pSample = Job.pIn[i ^ nSwap] * Sample24BitMax;
+	}
+
+	// The last sample may border another job's output, so only write its own bytes
+	const s32 nSample = Job.pIn[nLast ^ nSwap] * Sample24BitMax;
+	memcpy(Job.pOut + nLast * Job.nBytesPerSample, &nSample, Job.nBytesPerSample);
+}
+
 enum class TCustomSysExCommand : u8
 {
 	Reboot                = 0x00,
@@ -54,6 +97,41 @@ enum class TCustomSysExCommand : u8
 	SwitchSoundFont       = 0x02,
 	SwitchSynth           = 0x03,
 	SetMT32ReversedStereo = 0x04,
+	MIDIStats             = 0x05,
+	MIDIStressTest        = 0x06,
+	FileTransfer          = 0x07,
+	VoiceStats            = 0x08,
+	ApplyProfile          = 0x09,
+	SystemStats           = 0x0A,
+	SoftRestart           = 0x0B,
+	Benchmark             = 0x0C,
+};
+
+struct TBenchmarkStep
+{
+	TSynth Synth;
+	CMIDIStressGenerator::TPattern Pattern;
+	u8 nCount;
+	u8 nRate;
+};
+
+// Standard workload; identical across builds so that render times can be compared
+constexpr u8 BenchmarkStepSeconds = 10;
+constexpr TBenchmarkStep BenchmarkSteps[] =
+{
+	{ TSynth::MT32,      CMIDIStressGenerator::TPattern::NoteClusters,       8,  20 },
+	{ TSynth::MT32,      CMIDIStressGenerator::TPattern::CCStorm,            16, 50 },
+	{ TSynth::MT32,      CMIDIStressGenerator::TPattern::RunningStatusFlood, 32, 50 },
+	{ TSynth::MT32,      CMIDIStressGenerator::TPattern::MT32TimbreSysEx,    1,  10 },
+	{ TSynth::SoundFont, CMIDIStressGenerator::TPattern::NoteClusters,       8,  20 },
+	{ TSynth::SoundFont, CMIDIStressGenerator::TPattern::CCStorm,            16, 50 },
+	{ TSynth::SoundFont, CMIDIStressGenerator::TPattern::RunningStatusFlood, 32, 50 },
+};
+
+enum class TCoreMessageType : u32
+{
+	RenderChunk,
+	Shutdown,
 };
 
 CMT32Pi* CMT32Pi::s_pThis = nullptr;
@@ -87,21 +165,33 @@ CMT32Pi::CMT32Pi(CI2CMaster* pI2CMaster, CSPIMaster* pSPIMaster, CInterruptSyste
 
 	  m_pLCD(nullptr),
 	  m_nLCDUpdateTime(0),
-#ifdef MONITOR_TEMPERATURE
-	  m_nTempUpdateTime(0),
-#endif
+	  m_pMainMenu(nullptr),
 
 	  m_pControl(nullptr),
 	  m_MisterControl(pI2CMaster, m_EventQueue),
 	  m_nMisterUpdateTime(0),
 
+	  m_bSoftRestartFlag(false),
+
+	  m_bBenchmarkRunning(false),
+	  m_nBenchmarkStep(0),
+	  m_pBenchmarkPreviousSynth(nullptr),
+	  m_nBenchmarkSynthRenderMicros{0},
+	  m_nBenchmarkSynthFrames{0},
+	  m_nBenchmarkSynthVoiceFrames{0},
+
+	  m_bDeferredMIDIPurgeFlag(false),
+	  m_bDeferredROMRescanFlag(false),
+	  m_bDeferredSoundFontRescanFlag(false),
+
 	  m_bDeferredSoundFontSwitchFlag(false),
 	  m_nDeferredSoundFontSwitchIndex(0),
 	  m_nDeferredSoundFontSwitchTime(0),
 
 	  m_bSerialMIDIAvailable(false),
 	  m_bSerialMIDIEnabled(false),
-	  m_pUSBMIDIDevice(nullptr),
+	  m_USBMIDIPorts{},
+	  m_pUSBMIDIReplyPort(nullptr),
 	  m_pUSBSerialDevice(nullptr),
 	  m_pUSBMassStorageDevice(nullptr),
 
@@ -110,16 +200,27 @@ CMT32Pi::CMT32Pi(CI2CMaster* pI2CMaster, CSPIMaster* pSPIMaster, CInterruptSyste
 
 	  m_bRunning(true),
 	  m_bUITaskDone(false),
+	  m_nUICore(1),
+	  m_nAudioCore(2),
+	  m_nRenderHelperCore(0),
 	  m_bLEDOn(false),
 	  m_nLEDOnTime(0),
 
 	  m_pSound(nullptr),
+	  m_nRenderLoadPeak(0),
+	  m_nBenchmarkRenderMicros(0),
+	  m_nBenchmarkFrames(0),
+	  m_nBenchmarkVoiceFrames(0),
 	  m_pPisound(nullptr),
 
 	  m_nMasterVolume(100),
 	  m_pCurrentSynth(nullptr),
 	  m_pMT32Synth(nullptr),
-	  m_pSoundFontSynth(nullptr)
+	  m_pSoundFontSynth(nullptr),
+
+	  m_nFileTransferPercent(0),
+
+	  m_pFirmwareStatus(nullptr)
 {
 	s_pThis = this;
 }
@@ -297,13 +398,30 @@ bool CMT32Pi::Initialize(bool bSerialMIDIAvailable)
 		}
 	}
 
+	m_ProfileManager.LoadProfiles(ProfilesFile);
+
+	// Build menu tree
+	m_pMainMenu = new CMainMenu(m_EventQueue, m_MIDIStats, m_ProfileManager);
+	UpdateMainMenuSynths();
+	m_pMainMenu->SetCurrentSynth(m_pCurrentSynth == m_pMT32Synth ? TSynth::MT32 : TSynth::SoundFont);
+	m_pMainMenu->SetMasterVolume(m_nMasterVolume);
+	m_UserInterface.SetRootMenu(m_pMainMenu);
+
 	if (m_pPisound)
 		LOGNOTE("Using Pisound MIDI interface");
 	else if (m_bSerialMIDIEnabled)
 		LOGNOTE("Using serial MIDI interface");
 
 	CCPUThrottle::Get()->DumpStatus();
+	ReportMemoryMap();
+
+	// Start polling firmware status in the background
+	m_pFirmwareStatus = new CFirmwareStatus();
+	m_pFirmwareStatus->Initialize();
+
+	InitCoreMap();
 	SetPowerSaveTimeout(m_pConfig->SystemPowerSaveTimeout);
+	m_Telemetry.SetLogEnabled(m_pConfig->SystemTelemetryLog);
 
 	// Clear LCD
 	if (m_pLCD)
@@ -396,6 +514,9 @@ bool CMT32Pi::InitSoundFontSynth()
 {
 	assert(m_pSoundFontSynth == nullptr);
 
+	if (!m_SoundFontRegistry.Initialize(m_pConfig->AudioSampleRate))
+		LOGWARN("Couldn't create SoundFont registry; SoundFonts will not be shared");
+
 	m_pSoundFontSynth = new CSoundFontSynth(m_pConfig->AudioSampleRate);
 	if (!m_pSoundFontSynth->Initialize())
 	{
@@ -410,28 +531,158 @@ bool CMT32Pi::InitSoundFontSynth()
 	return true;
 }
 
+void CMT32Pi::RescanROMs()
+{
+	LCDLog(TLCDLogType::Spinner, "MT-32 ROM rescan");
+	if (m_pMT32Synth)
+		m_pMT32Synth->GetROMManager().ScanROMs();
+	else
+		InitMT32Synth();
+
+	UpdateMainMenuSynths();
+}
+
+void CMT32Pi::RescanSoundFonts()
+{
+	LCDLog(TLCDLogType::Spinner, "SoundFont rescan");
+	if (m_pSoundFontSynth)
+		m_pSoundFontSynth->RescanSoundFonts();
+	else
+		InitSoundFontSynth();
+
+	UpdateMainMenuSynths();
+	if (m_pSoundFontSynth)
+		LCDLog(TLCDLogType::Notice, "%d SoundFonts avail", m_pSoundFontSynth->GetSoundFontManager().GetSoundFontCount());
+}
+
+void CMT32Pi::UpdateMainMenuSynths()
+{
+	if (!m_pMainMenu)
+		return;
+
+	// The UI core only ever sees fully initialized synths and its own copy of the SoundFont names
+	m_pMainMenu->SetSynths(m_pMT32Synth, m_pSoundFontSynth);
+	if (m_pSoundFontSynth)
+		m_pMainMenu->SetSoundFontNames(m_pSoundFontSynth->GetSoundFontManager());
+}
+
+void CMT32Pi::ReportMemoryMap() const
+{
+	const CMemorySystem* const pMemorySystem = CMemorySystem::Get();
+	const CZoneAllocator* const pZoneAllocator = CZoneAllocator::Get();
+
+	size_t nLargestZoneBlock;
+	const size_t nZoneFree = pZoneAllocator->GetFreeSpace(&nLargestZoneBlock);
+
+	LOGNOTE("Memory map:");
+	LOGNOTE("RAM: %d MB", pMemorySystem->GetMemSize() / MEGABYTE);
+	LOGNOTE("SoundFont heap: %d MB, %d MB free (largest block %d MB)", pZoneAllocator->GetHeapSize() / MEGABYTE, nZoneFree / MEGABYTE, nLargestZoneBlock / MEGABYTE);
+	LOGNOTE("malloc() heap: %d KB free", pMemorySystem->GetHeapFreeSpace(HEAP_ANY) / 1024);
+
+	if (m_pMT32Synth)
+		LOGNOTE("MT-32 ROMs: %d KB resident", m_pMT32Synth->GetROMManager().GetResidentSize() / 1024);
+
+	if (m_pSoundFontSynth)
+		LOGNOTE("SoundFonts: %d of %d list entries used", m_pSoundFontSynth->GetSoundFontManager().GetSoundFontCount(), CSoundFontManager::MaxSoundFonts);
+}
+
+void CMT32Pi::InitCoreMap()
+{
+	// Nothing for a UI task to do
+	if (!(m_pLCD || m_pConfig->ControlMister))
+		m_bUITaskDone = true;
+
+	if (m_pConfig->CoresUI >= 0 && m_pConfig->CoresUI < CORES)
+		m_nUICore = m_pConfig->CoresUI;
+	else
+		LOGWARN("Invalid UI core %d; using core %d", m_pConfig->CoresUI, m_nUICore);
+
+	// The main task never yields to anything but scheduler tasks, so audio can't share its core
+	if (m_pConfig->CoresAudio >= 1 && m_pConfig->CoresAudio < CORES)
+		m_nAudioCore = m_pConfig->CoresAudio;
+	else
+		LOGWARN("Invalid audio core %d; using core %d", m_pConfig->CoresAudio, m_nAudioCore);
+
+	// Optional; 0 means no helper
+	const int nRenderHelperCore = m_pConfig->CoresRenderHelper;
+	if (nRenderHelperCore > 0 && nRenderHelperCore < CORES && static_cast<unsigned>(nRenderHelperCore) != m_nAudioCore && (static_cast<unsigned>(nRenderHelperCore) != m_nUICore || m_bUITaskDone))
+	{
+		m_nRenderHelperCore = nRenderHelperCore;
+		m_RenderScheduler.SetWorkerCount(2);
+		m_RenderScheduler.SetWakeHandler(RenderHelperWakeHandler, this);
+	}
+	else if (nRenderHelperCore)
+		LOGWARN("Render helper core %d is invalid or already in use; not using a helper", nRenderHelperCore);
+
+	ReportCoreMap(false);
+}
+
+void CMT32Pi::ReportCoreMap(bool bShowLoad) const
+{
+	LOGNOTE("Core map:");
+
+	for (unsigned nCore = 0; nCore < CORES; ++nCore)
+	{
+		CString Roles;
+
+		if (nCore == 0)
+			Roles = "MIDI, network, storage";
+
+		if (nCore == m_nUICore && !m_bUITaskDone)
+			Roles.Append(Roles.GetLength() ? ", UI" : "UI");
+
+		if (nCore == m_nAudioCore)
+			Roles.Append(Roles.GetLength() ? ", audio" : "audio");
+
+		if (m_nRenderHelperCore && nCore == m_nRenderHelperCore)
+			Roles = "render helper";
+
+		if (!Roles.GetLength())
+			Roles = "idle";
+
+		if (bShowLoad)
+			LOGNOTE("Core %d: %s; load %d%% (peak %d%%)", nCore, static_cast<const char*>(Roles), m_CoreLoad.GetLoad(nCore), m_CoreLoad.GetPeakLoad(nCore));
+		else
+			LOGNOTE("Core %d: %s", nCore, static_cast<const char*>(Roles));
+	}
+}
+
 void CMT32Pi::MainTask()
 {
 	CScheduler* const pScheduler = CScheduler::Get();
+	const bool bRunUI = m_nUICore == 0 && !m_bUITaskDone;
 
 	LOGNOTE("Main task on Core 0 starting up");
 
 	Awaken();
 
+	if (bRunUI)
+		m_pCurrentSynth->ReportStatus();
+
 	while (m_bRunning)
 	{
-		// Process MIDI data
-		UpdateMIDI();
+		{
+			CCoreLoad::CScope LoadScope(m_CoreLoad, 0);
 
-		// Process network packets
-		UpdateNetwork();
+			// Process MIDI data
+			UpdateMIDI();
+			UpdateMIDIStressGenerator();
+			if (m_bBenchmarkRunning)
+				UpdateBenchmark();
 
-		// Update controls
-		if (m_pControl)
-			m_pControl->Update();
+			// Process network packets
+			UpdateNetwork();
 
-		// Process events
-		ProcessEventQueue();
+			// Update controls
+			if (m_pControl)
+				m_pControl->Update();
+
+			// Process events
+			ProcessEventQueue();
+		}
+
+		if (bRunUI)
+			UpdateUI(0);
 
 		const unsigned int nTicks = m_pTimer->GetTicks();
 
@@ -450,21 +701,44 @@ void CMT32Pi::MainTask()
 			LOGNOTE("Active sense timeout - turning notes off");
 		}
 
+		// Update MIDI traffic rates
+		m_MIDIStats.Update(nTicks);
+
+		// Check stack usage
+		m_StackMonitor.Update(nTicks);
+
+		// Update per-core load figures
+		m_CoreLoad.Update(nTicks);
+
 		// Update power management
 		if (m_pCurrentSynth->IsActive())
 			Awaken();
 
-#ifdef MONITOR_TEMPERATURE
-		if (nTicks - m_nTempUpdateTime >= MSEC2HZ(5000))
+		// Sample temperature/clock/throttling and write out any underrun captures
+		m_Telemetry.Update(nTicks);
+
+		CPower::Update();
+
+		if (m_bSoftRestartFlag)
 		{
-			const unsigned int nTemp = CCPUThrottle::Get()->GetTemperature();
-			LOGDBG("Temperature: %dC", nTemp);
-			LCDLog(TLCDLogType::Notice, "Temp: %dC", nTemp);
-			m_nTempUpdateTime = nTicks;
+			SoftRestart();
+			m_bSoftRestartFlag = false;
+			Awaken();
 		}
-#endif
 
-		CPower::Update();
+		// Check for files received via SysEx
+		if (m_bDeferredROMRescanFlag)
+		{
+			RescanROMs();
+			LCDLog(TLCDLogType::Notice, "File received");
+			m_bDeferredROMRescanFlag = false;
+		}
+
+		if (m_bDeferredSoundFontRescanFlag)
+		{
+			RescanSoundFonts();
+			m_bDeferredSoundFontRescanFlag = false;
+		}
 
 		// Check for deferred SoundFont switch
 		if (m_bDeferredSoundFontSwitchFlag)
@@ -485,10 +759,19 @@ void CMT32Pi::MainTask()
 		// Check for USB PnP events
 		UpdateUSB();
 
-		// Allow other tasks to run
-		pScheduler->Yield();
+		// Allow other tasks to run; network tasks do their work here
+		{
+			CCoreLoad::CScope LoadScope(m_CoreLoad, 0);
+			pScheduler->Yield();
+		}
 	}
 
+	if (bRunUI)
+		StopUI();
+
+	// Wake the render helper so that it can exit
+	if (m_nRenderHelperCore)
+		m_CoreMailbox.Send(0, m_nRenderHelperCore, TCoreMessage{static_cast<u32>(TCoreMessageType::Shutdown), 0});
 
 	// Stop audio
 	m_pSound->Cancel();
@@ -498,54 +781,61 @@ void CMT32Pi::MainTask()
 		;
 }
 
-void CMT32Pi::UITask()
+void CMT32Pi::UITask(unsigned nCore)
 {
-	LOGNOTE("UI task on Core 1 starting up");
-
-	const bool bMisterEnabled = m_pConfig->ControlMister;
+	LOGNOTE("UI task on Core %d starting up", nCore);
 
 	// Nothing for this core to do; bail out
-	if (!(m_pLCD || bMisterEnabled))
-	{
-		m_bUITaskDone = true;
+	if (m_bUITaskDone)
 		return;
-	}
 
 	// Display current MT-32 ROM version/SoundFont
 	m_pCurrentSynth->ReportStatus();
 
 	while (m_bRunning)
-	{
-		const unsigned int nTicks = CTimer::GetClockTicks();
+		UpdateUI(nCore);
 
-		// Update LCD
-		if (m_pLCD && (nTicks - m_nLCDUpdateTime) >= Utility::MillisToTicks(LCDUpdatePeriodMillis))
-		{
-			m_UserInterface.Update(*m_pLCD, *m_pCurrentSynth, nTicks);
-			m_nLCDUpdateTime = nTicks;
-		}
+	StopUI();
+}
 
-		// Poll MiSTer interface
-		if (bMisterEnabled && (nTicks - m_nMisterUpdateTime) >= Utility::MillisToTicks(MisterUpdatePeriodMillis))
-		{
-			TMisterStatus Status{TMisterSynth::Unknown, 0xFF, 0xFF};
+void CMT32Pi::UpdateUI(unsigned nCore)
+{
+	const unsigned int nTicks = CTimer::GetClockTicks();
 
-			if (m_pCurrentSynth == m_pMT32Synth)
-				Status.Synth = TMisterSynth::MT32;
-			else if (m_pCurrentSynth == m_pSoundFontSynth)
-				Status.Synth = TMisterSynth::SoundFont;
+	// Update LCD; run at full frame rate only while animating or when a redraw has been requested
+	const bool bLCDFastUpdate = m_UserInterface.IsAnimating() || m_UserInterface.IsDamaged();
+	const u32 nLCDUpdatePeriodMillis = bLCDFastUpdate ? LCDUpdatePeriodMillis : LCDIdleUpdatePeriodMillis;
+	if (m_pLCD && (nTicks - m_nLCDUpdateTime) >= Utility::MillisToTicks(nLCDUpdatePeriodMillis))
+	{
+		CCoreLoad::CScope LoadScope(m_CoreLoad, nCore);
+		m_UserInterface.Update(*m_pLCD, *m_pCurrentSynth, nTicks);
+		m_nLCDUpdateTime = nTicks;
+	}
 
-			if (m_pMT32Synth)
-				Status.MT32ROMSet = static_cast<u8>(m_pMT32Synth->GetROMSet());
+	// Poll MiSTer interface
+	if (m_pConfig->ControlMister && (nTicks - m_nMisterUpdateTime) >= Utility::MillisToTicks(MisterUpdatePeriodMillis))
+	{
+		CCoreLoad::CScope LoadScope(m_CoreLoad, nCore);
+		TMisterStatus Status{TMisterSynth::Unknown, 0xFF, 0xFF};
 
-			if (m_pSoundFontSynth)
-				Status.SoundFontIndex = m_pSoundFontSynth->GetSoundFontIndex();
+		if (m_pCurrentSynth == m_pMT32Synth)
+			Status.Synth = TMisterSynth::MT32;
+		else if (m_pCurrentSynth == m_pSoundFontSynth)
+			Status.Synth = TMisterSynth::SoundFont;
 
-			m_MisterControl.Update(Status);
-			m_nMisterUpdateTime = nTicks;
-		}
+		if (m_pMT32Synth)
+			Status.MT32ROMSet = static_cast<u8>(m_pMT32Synth->GetROMSet());
+
+		if (m_pSoundFontSynth)
+			Status.SoundFontIndex = m_pSoundFontSynth->GetSoundFontIndex();
+
+		m_MisterControl.Update(Status);
+		m_nMisterUpdateTime = nTicks;
 	}
+}
 
+void CMT32Pi::StopUI()
+{
 	// Clear screen
 	if (m_pLCD)
 		m_pLCD->Clear();
@@ -553,9 +843,11 @@ void CMT32Pi::UITask()
 	m_bUITaskDone = true;
 }
 
-void CMT32Pi::AudioTask()
+void CMT32Pi::AudioTask(unsigned nCore)
 {
-	LOGNOTE("Audio task on Core 2 starting up");
+	LOGNOTE("Audio task on Core %d starting up", nCore);
+
+	const bool bRunUI = m_nUICore == nCore && !m_bUITaskDone;
 
 	constexpr u8 nChannels = 2;
 
@@ -566,64 +858,144 @@ void CMT32Pi::AudioTask()
 	const u8 nBytesPerFrame = 2 * nBytesPerSample;
 
 	const size_t nQueueSizeFrames = m_pSound->GetQueueSizeFrames();
+	const unsigned nSampleRate = m_pConfig->AudioSampleRate;
 
 	// Extra byte so that we can write to the 24-bit buffer with overlapping 32-bit writes (efficiency)
 	float FloatBuffer[nQueueSizeFrames * nChannels];
 	s8 IntBuffer[nQueueSizeFrames * nBytesPerFrame + bI2S ? 0 : 1];
 
+	TConvertJob ConvertJobs[ConvertJobCount];
+	size_t ConvertJobIDs[ConvertJobCount];
+	const char* const ConvertJobNames[ConvertJobCount] = { "Convert (first half)", "Convert (second half)" };
+	for (size_t i = 0; i < ConvertJobCount; ++i)
+	{
+		ConvertJobs[i] = TConvertJob{FloatBuffer, IntBuffer, 0, 0, nBytesPerSample, bReversedStereo};
+		ConvertJobIDs[i] = m_RenderScheduler.AddJob(ConvertJobNames[i], ConvertSamplesJob, &ConvertJobs[i]);
+	}
+
+	if (bRunUI)
+		m_pCurrentSynth->ReportStatus();
+
+	// Used to tell an underrun apart from the queue starting out empty
+	bool bQueueFilled = false;
+
 	while (m_bRunning)
 	{
+		if (bRunUI)
+			UpdateUI(nCore);
+
+		// Output is stopped in power saving mode, and restarts empty
+		if (!m_pSound->IsActive())
+			bQueueFilled = false;
+
 		const size_t nFrames = nQueueSizeFrames - m_pSound->GetQueueFramesAvail();
+		if (!nFrames)
+			continue;
+
+		// The queue ran dry before we got back to it
+		if (nFrames == nQueueSizeFrames && bQueueFilled)
+			m_Telemetry.OnUnderrun();
+		bQueueFilled = true;
+
+		CCoreLoad::CScope LoadScope(m_CoreLoad, nCore);
 		const size_t nWriteBytes = nFrames * nBytesPerFrame;
 
+		const unsigned nRenderStartTime = CTimer::GetClockTicks();
 		m_pCurrentSynth->Render(FloatBuffer, nFrames);
 
-		if (bReversedStereo)
+		// Track the peak render time as a percentage of the time the rendered frames will take to play
+		const unsigned nRenderTime = CTimer::GetClockTicks() - nRenderStartTime;
+		const u32 nLoad = static_cast<u64>(nRenderTime) * nSampleRate * 100 / (Utility::MillisToTicks(1000u) * nFrames);
+		if (nLoad > m_nRenderLoadPeak)
+			m_nRenderLoadPeak = nLoad;
+		m_Telemetry.OnRender(nLoad);
+
+		if (m_bBenchmarkRunning)
 		{
-			// Convert to signed 24-bit integers with channel swap
-			for (size_t i = 0; i < nFrames * nChannels; i += nChannels)
-			{
-				s32* const pLeftSample = reinterpret_cast<s32*>(IntBuffer + i * nBytesPerSample);
-				s32* const pRightSample = reinterpret_cast<s32*>(IntBuffer + (i + 1) * nBytesPerSample);
-				*pLeftSample = FloatBuffer[i + 1] * Sample24BitMax;
-				*pRightSample = FloatBuffer[i] * Sample24BitMax;
-			}
+			__atomic_add_fetch(&m_nBenchmarkRenderMicros, nRenderTime, __ATOMIC_RELAXED);
+			__atomic_add_fetch(&m_nBenchmarkFrames, nFrames, __ATOMIC_RELAXED);
+			__atomic_add_fetch(&m_nBenchmarkVoiceFrames, nFrames * m_pCurrentSynth->GetStatus().nActiveVoices, __ATOMIC_RELAXED);
+		}
+
+		if (m_nRenderHelperCore)
+		{
+			// Split on a frame boundary
+			const size_t nSplit = nFrames / 2 * nChannels;
+			ConvertJobs[0].nEnd   = nSplit;
+			ConvertJobs[1].nBegin = nSplit;
+			ConvertJobs[1].nEnd   = nFrames * nChannels;
+
+			for (size_t nJob : ConvertJobIDs)
+				m_RenderScheduler.Submit(nJob);
+
+			// Whatever the synth left of the chunk's playback time
+			const unsigned nChunkTime = static_cast<u64>(Utility::MillisToTicks(1000u)) * nFrames / nSampleRate;
+			m_RenderScheduler.Run(nRenderTime < nChunkTime ? nChunkTime - nRenderTime : 0);
 		}
 		else
 		{
-			// Convert to signed 24-bit integers
-			for (size_t i = 0; i < nFrames * nChannels; ++i)
-			{
-				s32* const pSample = reinterpret_cast<s32*>(IntBuffer + i * nBytesPerSample);
-				*pSample = FloatBuffer[i] * Sample24BitMax;
-			}
+			// No helper to share with; skip the scheduler's bookkeeping entirely
+			ConvertJobs[0].nEnd = nFrames * nChannels;
+			ConvertSamplesJob(&ConvertJobs[0]);
 		}
 
 		const int nResult = m_pSound->Write(IntBuffer, nWriteBytes);
 		if (nResult != static_cast<int>(nWriteBytes))
 			LOGERR("Sound data dropped");
 	}
+
+	if (bRunUI)
+		StopUI();
 }
 
 void CMT32Pi::Run(unsigned nCore)
 {
-	// Assign tasks to different CPU cores
-	switch (nCore)
-	{
-		case 0:
-			return MainTask();
+	m_StackMonitor.PaintCoreStack(nCore);
 
-		case 1:
-			return UITask();
+	// Assign tasks to different CPU cores; the UI shares the main or audio core if assigned to it
+	if (nCore == 0)
+		return MainTask();
 
-		case 2:
-			return AudioTask();
+	if (nCore == m_nAudioCore)
+		return AudioTask(nCore);
 
-		default:
-			break;
+	if (nCore == m_nRenderHelperCore)
+		return RenderHelperTask(nCore);
+
+	if (nCore == m_nUICore)
+		return UITask(nCore);
+}
+
+void CMT32Pi::RenderHelperTask(unsigned nCore)
+{
+	LOGNOTE("Render helper task on Core %d starting up", nCore);
+
+	while (m_bRunning)
+	{
+		// Sleep until the audio core publishes a chunk
+		m_CoreMailbox.Wait(nCore);
+
+		TCoreMessage Message;
+		while (m_CoreMailbox.Receive(nCore, Message))
+		{
+			if (Message.nType != static_cast<u32>(TCoreMessageType::RenderChunk))
+				continue;
+
+			const unsigned nBusyTime = m_RenderScheduler.Poll(1);
+			if (nBusyTime)
+				m_CoreLoad.AddBusyTime(nCore, nBusyTime);
+		}
 	}
 }
 
+void CMT32Pi::IPIHandler(unsigned nCore, unsigned nIPI)
+{
+	if (nIPI == CCoreMailbox::DoorbellIPI)
+		m_CoreMailbox.OnDoorbell(nCore);
+	else
+		CMultiCoreSupport::IPIHandler(nCore, nIPI);
+}
+
 void CMT32Pi::OnEnterPowerSavingMode()
 {
 	CPower::OnEnterPowerSavingMode();
@@ -730,6 +1102,46 @@ bool CMT32Pi::ParseCustomSysEx(const u8* pData, size_t nSize)
 		return true;
 	}
 
+	// Soft restart (F0 7D 0B F7); handled from the main loop
+	if (nSize == 4 && Command == TCustomSysExCommand::SoftRestart)
+	{
+		LOGNOTE("Soft restart command received");
+		m_bSoftRestartFlag = true;
+		return true;
+	}
+
+	// Run the benchmark workload (F0 7D 0C F7)
+	if (nSize == 4 && Command == TCustomSysExCommand::Benchmark)
+	{
+		StartBenchmark();
+		return true;
+	}
+
+	// File transfer (F0 7D 07 ... F7)
+	if (Command == TCustomSysExCommand::FileTransfer)
+	{
+		HandleFileTransfer(pData, nSize);
+		return true;
+	}
+
+	// Start MIDI stress test (F0 7D 06 pattern count rate duration F7); pattern 0 stops
+	if (nSize == 8 && Command == TCustomSysExCommand::MIDIStressTest)
+	{
+		const auto Pattern = static_cast<CMIDIStressGenerator::TPattern>(pData[3]);
+		if (Pattern == CMIDIStressGenerator::TPattern::Stop)
+		{
+			LOGNOTE("Stopping MIDI stress test");
+			m_MIDIStressGenerator.Stop();
+		}
+		else
+		{
+			LOGNOTE("Starting MIDI stress test: pattern %d, %d messages, %d/s, %ds", pData[3], pData[4], pData[5], pData[6]);
+			m_nRenderLoadPeak = 0;
+			m_MIDIStressGenerator.Start(Pattern, pData[4], pData[5], pData[6], CTimer::GetClockTicks());
+		}
+		return true;
+	}
+
 	if (nSize != 5)
 		return false;
 
@@ -765,11 +1177,161 @@ bool CMT32Pi::ParseCustomSysEx(const u8* pData, size_t nSize)
 			return true;
 		}
 
+		// Log (00) or reset (01) FluidSynth voice, interpolation, effects and controller statistics (F0 7D 08 xx F7)
+		case TCustomSysExCommand::VoiceStats:
+		{
+			if (!m_pSoundFontSynth)
+				return true;
+
+			if (nParameter == 0)
+			{
+				m_pSoundFontSynth->DumpVoiceStats();
+				m_pSoundFontSynth->DumpInterpolationStats();
+				m_pSoundFontSynth->DumpEffectsStats();
+				m_pSoundFontSynth->DumpControllerStats();
+			}
+			else if (nParameter == 1)
+			{
+				m_pSoundFontSynth->ResetVoiceStats();
+				m_pSoundFontSynth->ResetInterpolationStats();
+				m_pSoundFontSynth->ResetEffectsStats();
+				m_pSoundFontSynth->ResetControllerStats();
+			}
+			return true;
+		}
+
+		// Apply game profile (F0 7D 09 xx F7)
+		case TCustomSysExCommand::ApplyProfile:
+			ApplyProfile(nParameter);
+			return true;
+
+		// Log stack usage (00), core load (01), render job timing (03), core mailbox latency (04) or recent telemetry (05), or reset load statistics (02) (F0 7D 0A xx F7)
+		case TCustomSysExCommand::SystemStats:
+		{
+			if (nParameter == 0)
+				m_StackMonitor.Dump();
+			else if (nParameter == 1)
+				ReportCoreMap(true);
+			else if (nParameter == 2)
+			{
+				m_CoreLoad.ResetPeaks();
+				m_RenderScheduler.ResetStats();
+				m_CoreMailbox.ResetStats();
+			}
+			else if (nParameter == 3)
+				m_RenderScheduler.Dump();
+			else if (nParameter == 4)
+				m_CoreMailbox.Dump();
+			else if (nParameter == 5)
+				m_Telemetry.Dump();
+			return true;
+		}
+
+		// Log (00) or reset (01) MIDI traffic statistics (F0 7D 05 xx F7)
+		case TCustomSysExCommand::MIDIStats:
+		{
+			if (nParameter == 0)
+			{
+				m_MIDIStats.Dump();
+				DumpUSBMIDIStats();
+				m_NetMIDIAdmission.Dump();
+			}
+			else if (nParameter == 1)
+			{
+				m_MIDIStats.Reset();
+				ResetUSBMIDIStats();
+				m_NetMIDIAdmission.ResetStats();
+			}
+			return true;
+		}
+
 		default:
 			return false;
 	}
 }
 
+void CMT32Pi::HandleFileTransfer(const u8* pData, size_t nSize)
+{
+	u8 Reply[CSysExFileTransfer::MaxReplySize];
+	size_t nReplySize;
+
+	const CSysExFileTransfer::TResult Result = m_SysExFileTransfer.HandleMessage(pData, nSize, Reply, nReplySize);
+
+	// The host waits for this before sending the next block
+	if (nReplySize)
+		SendMIDIReply(GetCurrentSource(), Reply, nReplySize);
+
+	switch (Result)
+	{
+		case CSysExFileTransfer::TResult::Started:
+			m_nFileTransferPercent = 0;
+			LCDLog(TLCDLogType::Spinner, "Receiving file");
+			break;
+
+		case CSysExFileTransfer::TResult::Progress:
+		{
+			const u8 nPercent = m_SysExFileTransfer.GetProgressPercent();
+			if (nPercent != m_nFileTransferPercent)
+			{
+				m_nFileTransferPercent = nPercent;
+				LCDLog(TLCDLogType::Spinner, "Receiving %d%%", nPercent);
+			}
+			break;
+		}
+
+		case CSysExFileTransfer::TResult::Completed:
+		{
+			LCDLog(TLCDLogType::Notice, "File received");
+
+			// Pick up new ROMs or SoundFonts from the main loop; we're inside the MIDI parser here
+			const char* pPath = strchr(m_SysExFileTransfer.GetPath(), ':') + 1;
+			if (!strncasecmp(pPath, "roms/", 5))
+				m_bDeferredROMRescanFlag = true;
+			else if (!strncasecmp(pPath, "soundfonts/", 11))
+				m_bDeferredSoundFontRescanFlag = true;
+			break;
+		}
+
+		case CSysExFileTransfer::TResult::Aborted:
+			LCDLog(TLCDLogType::Notice, "Transfer cancelled");
+			break;
+
+		case CSysExFileTransfer::TResult::Failed:
+			// Bad blocks are retried by the host; only report transfers that have been given up
+			if (!m_SysExFileTransfer.IsActive())
+				LCDLog(TLCDLogType::Error, "File transfer failed!");
+			break;
+
+		default:
+			break;
+	}
+}
+
+void CMT32Pi::SendMIDIReply(TMIDISource Source, const u8* pData, size_t nSize)
+{
+	switch (Source)
+	{
+		case TMIDISource::Serial:
+			m_pSerial->Write(pData, nSize);
+			break;
+
+		case TMIDISource::USBSerial:
+			if (m_pUSBSerialDevice)
+				m_pUSBSerialDevice->Write(pData, nSize);
+			break;
+
+		// Reply to the USB MIDI device the request came from
+		case TMIDISource::USB:
+			if (m_pUSBMIDIReplyPort && m_pUSBMIDIReplyPort->pDevice)
+				m_pUSBMIDIReplyPort->pDevice->SendPlainMIDI(0, pData, nSize);
+			break;
+
+		// No return path
+		default:
+			break;
+	}
+}
+
 void CMT32Pi::UpdateUSB(bool bStartup)
 {
 	if (!m_bUSBAvailable || !m_pUSBHCI->UpdatePlugAndPlay())
@@ -790,20 +1352,8 @@ void CMT32Pi::UpdateUSB(bool bStartup)
 		{
 			if (!bStartup)
 			{
-				LCDLog(TLCDLogType::Spinner, "MT-32 ROM rescan");
-				if (m_pMT32Synth)
-					m_pMT32Synth->GetROMManager().ScanROMs();
-				else
-					InitMT32Synth();
-
-				LCDLog(TLCDLogType::Spinner, "SoundFont rescan");
-				if (m_pSoundFontSynth)
-					m_pSoundFontSynth->GetSoundFontManager().ScanSoundFonts();
-				else
-					InitSoundFontSynth();
-
-				if (m_pSoundFontSynth)
-					LCDLog(TLCDLogType::Notice, "%d SoundFonts avail", m_pSoundFontSynth->GetSoundFontManager().GetSoundFontCount());
+				RescanROMs();
+				RescanSoundFonts();
 			}
 		}
 	}
@@ -816,19 +1366,57 @@ void CMT32Pi::UpdateUSB(bool bStartup)
 
 		// Only need to rescan SoundFonts on storage removal; MT-32 ROMs are kept in memory
 		if (m_pSoundFontSynth)
-		{
-			LCDLog(TLCDLogType::Spinner, "SoundFont rescan");
-			m_pSoundFontSynth->GetSoundFontManager().ScanSoundFonts();
-			LCDLog(TLCDLogType::Notice, "%d SoundFonts avail", m_pSoundFontSynth->GetSoundFontManager().GetSoundFontCount());
-		}
+			RescanSoundFonts();
 	}
 	m_pUSBMassStorageDevice = pUSBMassStorageDevice;
 
-	if (!m_pUSBMIDIDevice && (m_pUSBMIDIDevice = static_cast<CUSBMIDIDevice*>(CDeviceNameService::Get()->GetDevice("umidi1", FALSE))))
+	// Track every attached USB MIDI device; numbers are reused after unplugging, so match on the device itself
+	for (unsigned nDeviceNumber = 1; nDeviceNumber <= MaxUSBMIDIDeviceNumber; ++nDeviceNumber)
 	{
-		m_pUSBMIDIDevice->RegisterRemovedHandler(USBMIDIDeviceRemovedHandler, &m_pUSBMIDIDevice);
-		m_pUSBMIDIDevice->RegisterPacketHandler(USBMIDIPacketHandler);
-		LOGNOTE("Using USB MIDI interface");
+		CUSBMIDIDevice* pDevice = static_cast<CUSBMIDIDevice*>(CDeviceNameService::Get()->GetDevice("umidi", nDeviceNumber, FALSE));
+		if (!pDevice)
+			continue;
+
+		TUSBMIDIPort* pFreePort = nullptr;
+		bool bTracked = false;
+		for (TUSBMIDIPort& Port : m_USBMIDIPorts)
+		{
+			if (Port.pDevice == pDevice)
+			{
+				bTracked = true;
+				break;
+			}
+
+			if (!Port.pDevice && !pFreePort)
+				pFreePort = &Port;
+		}
+
+		if (bTracked)
+			continue;
+
+		if (!pFreePort)
+		{
+			LOGWARN("Too many USB MIDI devices; umidi%d ignored", nDeviceNumber);
+			continue;
+		}
+
+		const size_t nPort = pFreePort - m_USBMIDIPorts;
+
+		// Drop anything left over from the previous device in this slot
+		u8 Buffer[MIDIRxBufferSize];
+		while (pFreePort->RxBuffer.Dequeue(Buffer, sizeof(Buffer)))
+			;
+
+		pFreePort->ParserStream = CMIDIParser::TStream();
+		pFreePort->nDeviceNumber = nDeviceNumber;
+		pFreePort->nBytes = 0;
+		pFreePort->nPackets = 0;
+		pFreePort->nOverruns = 0;
+		pFreePort->pDevice = pDevice;
+
+		pDevice->RegisterRemovedHandler(USBMIDIDeviceRemovedHandler, &pFreePort->pDevice);
+		pDevice->RegisterPacketHandler(USBMIDIPacketHandlers[nPort]);
+		LOGNOTE("Using USB MIDI interface umidi%d", nDeviceNumber);
 		m_bSerialMIDIEnabled = false;
 	}
 
@@ -862,9 +1450,12 @@ void CMT32Pi::UpdateNetwork()
 		LOGNOTE("Network up and running at: %s", static_cast<const char *>(IPString));
 		LCDLog(TLCDLogType::Notice, "%s: %s", GetNetworkDeviceShortName(), static_cast<const char*>(IPString));
 
+		if ((m_pConfig->NetworkRTPMIDI && !m_pAppleMIDIParticipant) || (m_pConfig->NetworkUDPMIDI && !m_pUDPMIDIReceiver))
+			m_NetMIDIAdmission.Configure(m_pConfig->NetworkMIDIAllowlist, Utility::Clamp(m_pConfig->NetworkMIDIRateLimit, 0, 1048576));
+
 		if (m_pConfig->NetworkRTPMIDI && !m_pAppleMIDIParticipant)
 		{
-			m_pAppleMIDIParticipant = new CAppleMIDIParticipant(&m_Random, this);
+			m_pAppleMIDIParticipant = new CAppleMIDIParticipant(&m_Random, this, &m_NetMIDIAdmission);
 			if (!m_pAppleMIDIParticipant->Initialize())
 			{
 				LOGERR("Failed to init AppleMIDI receiver");
@@ -877,7 +1468,7 @@ void CMT32Pi::UpdateNetwork()
 
 		if (m_pConfig->NetworkUDPMIDI && !m_pUDPMIDIReceiver)
 		{
-			m_pUDPMIDIReceiver = new CUDPMIDIReceiver(this);
+			m_pUDPMIDIReceiver = new CUDPMIDIReceiver(this, &m_NetMIDIAdmission);
 			if (!m_pUDPMIDIReceiver->Initialize())
 			{
 				LOGERR("Failed to init UDP MIDI receiver");
@@ -915,41 +1506,265 @@ void CMT32Pi::UpdateMIDI()
 	size_t nBytes;
 	u8 Buffer[MIDIRxBufferSize];
 
-	// Read MIDI messages from serial device or ring buffer
+	if (m_bDeferredMIDIPurgeFlag)
+	{
+		m_bDeferredMIDIPurgeFlag = false;
+		PurgeMIDIBuffers();
+	}
+
+	// Read MIDI messages from serial device or ring buffers
 	if (m_bSerialMIDIEnabled)
+	{
 		nBytes = ReceiveSerialMIDI(Buffer, sizeof(Buffer));
+		if (nBytes)
+			ParseMIDIBytes(Buffer, nBytes, TMIDISource::Serial);
+	}
 	else if (m_pUSBSerialDevice)
 	{
 		const int nResult = m_pUSBSerialDevice->Read(Buffer, sizeof(Buffer));
 		nBytes = nResult > 0 ? static_cast<size_t>(nResult) : 0;
+		if (nBytes)
+			ParseMIDIBytes(Buffer, nBytes, TMIDISource::USBSerial);
 	}
 	else
-		nBytes = m_MIDIRxBuffer.Dequeue(Buffer, sizeof(Buffer));
+		nBytes = ReceiveUSBMIDI(false);
 
 	if (nBytes == 0)
 		return;
 
-	// Process MIDI messages
-	ParseMIDIBytes(Buffer, nBytes);
-
 	// Reset the Active Sense timer
 	s_pThis->m_nActiveSenseTime = s_pThis->m_pTimer->GetTicks();
 }
 
+void CMT32Pi::UpdateMIDIStressGenerator()
+{
+	const unsigned int nTicks = CTimer::GetClockTicks();
+	const size_t nBytes = m_MIDIStressGenerator.Generate(nTicks, m_MIDIStressBuffer, sizeof(m_MIDIStressBuffer));
+
+	if (nBytes)
+	{
+		// Own parser state, so that generated bursts can't interleave with a message half-received on serial
+		ParseMIDIBytes(m_MIDIStressBuffer, nBytes, TMIDISource::Generator, m_MIDIStressStream);
+		m_MIDIStressGenerator.AddDispatchTime(CTimer::GetClockTicks() - nTicks);
+	}
+
+	CMIDIStressGenerator::TReport Report;
+	if (!m_MIDIStressGenerator.TakeReport(nTicks, Report))
+		return;
+
+	const u32 nRenderLoad = __atomic_exchange_n(&m_nRenderLoadPeak, 0, __ATOMIC_RELAXED);
+	size_t nRxQueue = m_MIDIRxBuffer.GetCount();
+	for (const TUSBMIDIPort& Port : m_USBMIDIPorts)
+		nRxQueue += Port.RxBuffer.GetCount();
+
+	LOGNOTE("Stress: %d bursts, %d bytes, lateness avg %dus max %dus, dispatch max %dus, render load %d%%, RX queue %d, event queue %d",
+		Report.nBursts, Report.nBytes, Report.nAvgLatenessMicros, Report.nMaxLatenessMicros, Report.nMaxDispatchMicros,
+		nRenderLoad, nRxQueue, m_EventQueue.GetCount());
+	LCDLog(TLCDLogType::Notice, "Ld%d%% Lat%dus", nRenderLoad, Report.nMaxLatenessMicros + Report.nMaxDispatchMicros);
+
+	if (!m_MIDIStressGenerator.IsRunning())
+		LOGNOTE("MIDI stress test finished");
+}
+
+void CMT32Pi::StartBenchmark()
+{
+	if (m_bBenchmarkRunning)
+		return;
+
+	LOGNOTE("Starting benchmark: %d steps of %ds", Utility::ArraySize(BenchmarkSteps), BenchmarkStepSeconds);
+	LCDLog(TLCDLogType::Notice, "Benchmarking...");
+
+	m_bBenchmarkRunning = true;
+	m_nBenchmarkStep = 0;
+	if (m_pMT32Synth)
+		m_pMT32Synth->SetPartialCounting(true);
+	m_pBenchmarkPreviousSynth = m_pCurrentSynth;
+	for (size_t i = 0; i < Utility::ArraySize(m_nBenchmarkSynthFrames); ++i)
+	{
+		m_nBenchmarkSynthRenderMicros[i] = 0;
+		m_nBenchmarkSynthFrames[i] = 0;
+		m_nBenchmarkSynthVoiceFrames[i] = 0;
+	}
+
+	StartBenchmarkStep();
+}
+
+void CMT32Pi::StartBenchmarkStep()
+{
+	// Skip steps for synths that failed to initialize
+	while (m_nBenchmarkStep < Utility::ArraySize(BenchmarkSteps))
+	{
+		const TBenchmarkStep& Step = BenchmarkSteps[m_nBenchmarkStep];
+		CSynthBase* const pSynth = Step.Synth == TSynth::MT32 ? static_cast<CSynthBase*>(m_pMT32Synth) : m_pSoundFontSynth;
+		if (!pSynth)
+		{
+			++m_nBenchmarkStep;
+			continue;
+		}
+
+		if (pSynth != m_pCurrentSynth)
+			SwitchSynth(Step.Synth);
+		else
+			m_pCurrentSynth->AllSoundOff();
+
+		__atomic_store_n(&m_nBenchmarkRenderMicros, 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&m_nBenchmarkFrames, 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&m_nBenchmarkVoiceFrames, 0, __ATOMIC_RELAXED);
+		m_MIDIStressGenerator.Start(Step.Pattern, Step.nCount, Step.nRate, BenchmarkStepSeconds, CTimer::GetClockTicks());
+		return;
+	}
+
+	FinishBenchmark();
+}
+
+void CMT32Pi::UpdateBenchmark()
+{
+	if (m_MIDIStressGenerator.IsRunning())
+		return;
+
+	const u32 nRenderMicros = __atomic_exchange_n(&m_nBenchmarkRenderMicros, 0, __ATOMIC_RELAXED);
+	const u32 nFrames = __atomic_exchange_n(&m_nBenchmarkFrames, 0, __ATOMIC_RELAXED);
+	const u32 nVoiceFrames = __atomic_exchange_n(&m_nBenchmarkVoiceFrames, 0, __ATOMIC_RELAXED);
+	const TBenchmarkStep& Step = BenchmarkSteps[m_nBenchmarkStep];
+	const size_t nSynth = static_cast<size_t>(Step.Synth);
+
+	m_nBenchmarkSynthRenderMicros[nSynth] += nRenderMicros;
+	m_nBenchmarkSynthFrames[nSynth] += nFrames;
+	m_nBenchmarkSynthVoiceFrames[nSynth] += nVoiceFrames;
+
+	// Render time per second of audio output, in total and per sounding voice (MT-32 partial)
+	const u32 nMicrosPerSecond = nFrames ? static_cast<u64>(nRenderMicros) * m_pConfig->AudioSampleRate / nFrames : 0;
+	const u32 nMicrosPerVoiceSecond = nVoiceFrames ? static_cast<u64>(nRenderMicros) * m_pConfig->AudioSampleRate / nVoiceFrames : 0;
+	const u32 nAverageVoices = nFrames ? static_cast<u64>(nVoiceFrames) * 10 / nFrames : 0;
+	LOGNOTE("Benchmark step %d (%s, pattern %d): %dus/s, %d.%d voices, %dus/s per voice", m_nBenchmarkStep + 1,
+		Step.Synth == TSynth::MT32 ? "MT-32" : "SoundFont", static_cast<u8>(Step.Pattern), nMicrosPerSecond,
+		nAverageVoices / 10, nAverageVoices % 10, nMicrosPerVoiceSecond);
+
+	++m_nBenchmarkStep;
+	StartBenchmarkStep();
+}
+
+void CMT32Pi::FinishBenchmark()
+{
+	m_bBenchmarkRunning = false;
+	if (m_pMT32Synth)
+		m_pMT32Synth->SetPartialCounting(false);
+
+	for (size_t i = 0; i < Utility::ArraySize(m_nBenchmarkSynthFrames); ++i)
+	{
+		if (!m_nBenchmarkSynthFrames[i])
+			continue;
+
+		const u64 nRenderMicros = m_nBenchmarkSynthRenderMicros[i] * m_pConfig->AudioSampleRate;
+		const u32 nMicrosPerSecond = nRenderMicros / m_nBenchmarkSynthFrames[i];
+		const u32 nMicrosPerVoiceSecond = m_nBenchmarkSynthVoiceFrames[i] ? nRenderMicros / m_nBenchmarkSynthVoiceFrames[i] : 0;
+		LOGNOTE("Benchmark result for %s: %dus/s render time (%d.%02d%% load), %dus/s per voice", i == static_cast<size_t>(TSynth::MT32) ? "MT-32" : "SoundFont",
+			nMicrosPerSecond, nMicrosPerSecond / 10000, nMicrosPerSecond / 100 % 100, nMicrosPerVoiceSecond);
+	}
+
+	if (m_pBenchmarkPreviousSynth && m_pBenchmarkPreviousSynth != m_pCurrentSynth)
+		SwitchSynth(m_pBenchmarkPreviousSynth == m_pMT32Synth ? TSynth::MT32 : TSynth::SoundFont);
+	else
+		m_pCurrentSynth->AllSoundOff();
+
+#ifdef PGO_GENERATE
+	// Instrumented build; the workload doubles as the training run
+	if (CGcovWriter::Write(ProfileDataDir))
+		LCDLog(TLCDLogType::Notice, "Profile data saved");
+	else
+		LCDLog(TLCDLogType::Error, "Profile save failed");
+#else
+	LCDLog(TLCDLogType::Notice, "Benchmark done");
+#endif
+}
+
 void CMT32Pi::PurgeMIDIBuffers()
 {
+	// Parsing again from inside a SysEx handler would clobber the stream and USB reply port still in use by it
+	if (IsParsing())
+	{
+		m_bDeferredMIDIPurgeFlag = true;
+		return;
+	}
+
 	size_t nBytes;
 	u8 Buffer[MIDIRxBufferSize];
 
 	// Process MIDI messages from all devices/ring buffers, but ignore note-ons
 	while (m_bSerialMIDIEnabled && (nBytes = ReceiveSerialMIDI(Buffer, sizeof(Buffer))) > 0)
-		ParseMIDIBytes(Buffer, nBytes, true);
+		ParseMIDIBytes(Buffer, nBytes, TMIDISource::Serial, true);
 
 	while (m_pUSBSerialDevice && (nBytes = m_pUSBSerialDevice->Read(Buffer, sizeof(Buffer))) > 0)
-		ParseMIDIBytes(Buffer, nBytes, true);
+		ParseMIDIBytes(Buffer, nBytes, TMIDISource::USBSerial, true);
 
-	while ((nBytes = m_MIDIRxBuffer.Dequeue(Buffer, sizeof(Buffer))) > 0)
-		ParseMIDIBytes(Buffer, nBytes, true);
+	while (ReceiveUSBMIDI(true) > 0)
+		;
+}
+
+size_t CMT32Pi::ReceiveUSBMIDI(bool bIgnoreNoteOns)
+{
+	u8 Buffer[MIDIRxBufferSize];
+	size_t nTotalBytes = 0;
+	TUSBMIDIPort* const pPreviousReplyPort = m_pUSBMIDIReplyPort;
+
+	size_t nBytes = m_MIDIRxBuffer.Dequeue(Buffer, sizeof(Buffer));
+	if (nBytes)
+	{
+		m_pUSBMIDIReplyPort = nullptr;
+		ParseMIDIBytes(Buffer, nBytes, TMIDISource::USB, bIgnoreNoteOns);
+		nTotalBytes += nBytes;
+	}
+
+	// Each device keeps its own parser state; messages are merged into the synth input in the order they are drained
+	for (TUSBMIDIPort& Port : m_USBMIDIPorts)
+	{
+		nBytes = Port.RxBuffer.Dequeue(Buffer, sizeof(Buffer));
+		if (!nBytes)
+			continue;
+
+		m_pUSBMIDIReplyPort = &Port;
+		ParseMIDIBytes(Buffer, nBytes, TMIDISource::USB, Port.ParserStream, bIgnoreNoteOns);
+		Port.nBytes += nBytes;
+		nTotalBytes += nBytes;
+	}
+
+	m_pUSBMIDIReplyPort = pPreviousReplyPort;
+
+	return nTotalBytes;
+}
+
+bool CMT32Pi::IsUSBMIDIConnected() const
+{
+	for (const TUSBMIDIPort& Port : m_USBMIDIPorts)
+	{
+		if (Port.pDevice)
+			return true;
+	}
+
+	return false;
+}
+
+void CMT32Pi::DumpUSBMIDIStats() const
+{
+	for (const TUSBMIDIPort& Port : m_USBMIDIPorts)
+	{
+		if (!Port.pDevice && !Port.nBytes)
+			continue;
+
+		LOGNOTE("umidi%d%s: %d packets, %d bytes, %d overruns, %d parser errors",
+			Port.nDeviceNumber, Port.pDevice ? "" : " (removed)", Port.nPackets, Port.nBytes, Port.nOverruns, Port.ParserStream.nErrors);
+	}
+}
+
+void CMT32Pi::ResetUSBMIDIStats()
+{
+	for (TUSBMIDIPort& Port : m_USBMIDIPorts)
+	{
+		Port.nBytes = 0;
+		Port.nPackets = 0;
+		Port.nOverruns = 0;
+		Port.ParserStream.nErrors = 0;
+	}
 }
 
 size_t CMT32Pi::ReceiveSerialMIDI(u8* pOutData, size_t nSize)
@@ -1050,7 +1865,22 @@ void CMT32Pi::ProcessEventQueue()
 				break;
 
 			case TEventType::Encoder:
-				SetMasterVolume(m_nMasterVolume + Event.Encoder.nDelta);
+				if (m_UserInterface.IsMenuOpen())
+				{
+					const TMenuInput Input = Event.Encoder.nDelta < 0 ? TMenuInput::Up : TMenuInput::Down;
+					for (int nStep = 0; nStep < Utility::Abs<int>(Event.Encoder.nDelta); ++nStep)
+						m_UserInterface.QueueMenuInput(Input);
+				}
+				else
+					SetMasterVolume(m_nMasterVolume + Event.Encoder.nDelta);
+				break;
+
+			case TEventType::MasterVolume:
+				SetMasterVolume(Event.MasterVolume.nVolume);
+				break;
+
+			case TEventType::ApplyProfile:
+				ApplyProfile(Event.ApplyProfile.Index);
 				break;
 		}
 	}
@@ -1058,14 +1888,30 @@ void CMT32Pi::ProcessEventQueue()
 
 void CMT32Pi::ProcessButtonEvent(const TButtonEvent& Event)
 {
+	if (!Event.bPressed)
+		return;
+
+	// Encoder button opens the menu and selects items; the UI core does the rest
 	if (Event.Button == TButton::EncoderButton)
 	{
-		LCDLog(TLCDLogType::Notice, "Enc. button %s", Event.bPressed ? "PRESSED" : "RELEASED");
+		if (!Event.bRepeat)
+			m_UserInterface.QueueMenuInput(TMenuInput::Select);
 		return;
 	}
 
-	if (!Event.bPressed)
+	// Buttons navigate while the menu is open
+	if (m_UserInterface.IsMenuOpen())
+	{
+		if (Event.Button == TButton::Button1 && !Event.bRepeat)
+			m_UserInterface.QueueMenuInput(TMenuInput::Back);
+		else if (Event.Button == TButton::Button2 && !Event.bRepeat)
+			m_UserInterface.QueueMenuInput(TMenuInput::Select);
+		else if (Event.Button == TButton::Button3)
+			m_UserInterface.QueueMenuInput(TMenuInput::Up);
+		else if (Event.Button == TButton::Button4)
+			m_UserInterface.QueueMenuInput(TMenuInput::Down);
 		return;
+	}
 
 	if (Event.Button == TButton::Button1 && !Event.bRepeat)
 	{
@@ -1138,6 +1984,8 @@ void CMT32Pi::SwitchSynth(TSynth NewSynth)
 
 	m_pCurrentSynth->AllSoundOff();
 	m_pCurrentSynth = pNewSynth;
+	if (m_pMainMenu)
+		m_pMainMenu->SetCurrentSynth(NewSynth);
 	const char* pMode = NewSynth == TSynth::MT32 ? "MT-32 mode" : "SoundFont mode";
 	LOGNOTE("Switching to %s", pMode);
 	LCDLog(TLCDLogType::Notice, pMode);
@@ -1200,11 +2048,150 @@ void CMT32Pi::SetMasterVolume(s32 nVolume)
 		m_pMT32Synth->SetMasterVolume(m_nMasterVolume);
 	if (m_pSoundFontSynth)
 		m_pSoundFontSynth->SetMasterVolume(m_nMasterVolume);
+	if (m_pMainMenu)
+		m_pMainMenu->SetMasterVolume(m_nMasterVolume);
 
-	if (m_pCurrentSynth == m_pSoundFontSynth)
+	// Menu displays the volume itself
+	if (m_pCurrentSynth == m_pSoundFontSynth && !m_UserInterface.IsMenuOpen())
 		LCDLog(TLCDLogType::Notice, "Volume: %d", m_nMasterVolume);
 }
 
+void CMT32Pi::ApplyProfile(size_t nIndex)
+{
+	const TProfile* pProfile = m_ProfileManager.GetProfile(nIndex);
+	if (!pProfile)
+	{
+		LCDLog(TLCDLogType::Warning, "Profile not avail!");
+		return;
+	}
+
+	const char* pName = pProfile->Name;
+	LOGNOTE("Loading profile \"%s\"", pName);
+	LCDLog(TLCDLogType::Spinner, "Loading %s", pName);
+
+	// Load everything the profile needs while the current synth keeps playing
+	bool bMT32Ready = false;
+	if (m_pMT32Synth && pProfile->MT32ROMSet && *pProfile->MT32ROMSet != m_pMT32Synth->GetROMSet())
+	{
+		bMT32Ready = m_pMT32Synth->PrepareROMSet(*pProfile->MT32ROMSet);
+		if (!bMT32Ready)
+			LOGWARN("ROM set %d not available", static_cast<u8>(*pProfile->MT32ROMSet));
+	}
+
+	bool bSoundFontReady = false;
+	size_t nSoundFont = 0;
+	if (m_pSoundFontSynth)
+	{
+		nSoundFont = pProfile->nSoundFont ? *pProfile->nSoundFont : m_pSoundFontSynth->GetSoundFontIndex();
+		bSoundFontReady = m_pSoundFontSynth->PrepareSoundFont(nSoundFont, &pProfile->FXProfile);
+		if (!bSoundFontReady)
+			LOGWARN("Couldn't preload SoundFont %d; switching directly", nSoundFont);
+	}
+
+	// Swap everything in with no MIDI processed in between
+	if (bMT32Ready)
+		m_pMT32Synth->CommitROMSet();
+
+	if (bSoundFontReady)
+		m_pSoundFontSynth->CommitSoundFont();
+	else if (m_pSoundFontSynth)
+		m_pSoundFontSynth->SwitchSoundFont(nSoundFont, &pProfile->FXProfile);
+
+	if (m_pMT32Synth)
+	{
+		// A freshly opened synth starts with the ROM's default channel assignment
+		if (pProfile->MT32MIDIChannels || bMT32Ready)
+			m_pMT32Synth->SetMIDIChannels(pProfile->MT32MIDIChannels.ValueOr(m_pConfig->MT32EmuMIDIChannels));
+
+		if (pProfile->bMT32ReversedStereo)
+			m_pMT32Synth->SetReversedStereo(*pProfile->bMT32ReversedStereo);
+	}
+
+	if (pProfile->Synth)
+	{
+		const TSynth Synth = *pProfile->Synth == CConfig::TSystemDefaultSynth::MT32 ? TSynth::MT32 : TSynth::SoundFont;
+		const CSynthBase* pSynth = Synth == TSynth::MT32 ? static_cast<CSynthBase*>(m_pMT32Synth) : m_pSoundFontSynth;
+		if (pSynth != m_pCurrentSynth)
+			SwitchSynth(Synth);
+	}
+
+	if (pProfile->nVolume)
+		SetMasterVolume(*pProfile->nVolume);
+	else if (bMT32Ready)
+		m_pMT32Synth->SetMasterVolume(m_nMasterVolume);
+
+	// Supersedes any pending SoundFont switch
+	m_bDeferredSoundFontSwitchFlag = false;
+
+	// Handle any MIDI data that has been queued up while busy
+	PurgeMIDIBuffers();
+
+	LCDLog(TLCDLogType::Notice, "Profile: %s", pName);
+}
+
+void CMT32Pi::SoftRestart()
+{
+	const unsigned int nStartTime = m_pTimer->GetClockTicks();
+
+	LOGNOTE("Soft restart");
+	LCDLog(TLCDLogType::Spinner, "Restarting");
+
+	m_MIDIStressGenerator.Stop();
+	m_bBenchmarkRunning            = false;
+	m_bActiveSenseFlag             = false;
+	m_bDeferredSoundFontSwitchFlag = false;
+
+	if (m_pMT32Synth)
+		m_pMT32Synth->SetPartialCounting(false);
+
+	// Hardware, cores and network stay up, so only runtime options are re-read
+	if (!m_pConfig->Reload(ConfigFile))
+		LOGWARN("Couldn't reload config; keeping current settings");
+
+	if (m_pMT32Synth)
+	{
+		const TMT32ROMSet ROMSet = m_pConfig->MT32EmuROMSet;
+		if (ROMSet != m_pMT32Synth->GetROMSet() && m_pMT32Synth->PrepareROMSet(ROMSet))
+			m_pMT32Synth->CommitROMSet();
+		else
+			m_pMT32Synth->Reset();
+
+		m_pMT32Synth->SetMIDIChannels(m_pConfig->MT32EmuMIDIChannels);
+		m_pMT32Synth->SetReversedStereo(m_pConfig->MT32EmuReversedStereo);
+	}
+
+	if (m_pSoundFontSynth)
+	{
+		// Same SoundFont only re-applies the effects; its samples stay loaded
+		const size_t nSoundFont = m_pConfig->FluidSynthSoundFont;
+		m_pSoundFontSynth->Reset();
+		if (m_pSoundFontSynth->PrepareSoundFont(nSoundFont))
+			m_pSoundFontSynth->CommitSoundFont();
+		else
+			m_pSoundFontSynth->SwitchSoundFont(nSoundFont);
+	}
+
+	CSynthBase* pDefaultSynth = nullptr;
+	if (m_pConfig->SystemDefaultSynth == CConfig::TSystemDefaultSynth::MT32)
+		pDefaultSynth = m_pMT32Synth;
+	else if (m_pConfig->SystemDefaultSynth == CConfig::TSystemDefaultSynth::SoundFont)
+		pDefaultSynth = m_pSoundFontSynth;
+
+	if (pDefaultSynth && pDefaultSynth != m_pCurrentSynth)
+		SwitchSynth(pDefaultSynth == m_pMT32Synth ? TSynth::MT32 : TSynth::SoundFont);
+
+	SetMasterVolume(100);
+	SetPowerSaveTimeout(m_pConfig->SystemPowerSaveTimeout);
+	m_Telemetry.SetLogEnabled(m_pConfig->SystemTelemetryLog);
+	m_MIDIStats.Reset();
+
+	// Handle any MIDI data that has been queued up while busy
+	PurgeMIDIBuffers();
+
+	LOGNOTE("Soft restart took %d ms", (m_pTimer->GetClockTicks() - nStartTime) / 1000);
+	LCDLog(TLCDLogType::Notice, "Restarted");
+}
+
 void CMT32Pi::LEDOn()
 {
 	m_pActLED->On();
@@ -1265,7 +2252,7 @@ void CMT32Pi::USBMIDIDeviceRemovedHandler(CDevice* pDevice, void* pContext)
 	*pDevicePointer = nullptr;
 
 	// Re-enable serial MIDI if not in-use by logger and no other MIDI devices available
-	if (s_pThis->m_bSerialMIDIAvailable && !(s_pThis->m_pUSBMIDIDevice || s_pThis->m_pUSBSerialDevice || s_pThis->m_pPisound))
+	if (s_pThis->m_bSerialMIDIAvailable && !(s_pThis->IsUSBMIDIConnected() || s_pThis->m_pUSBSerialDevice || s_pThis->m_pPisound))
 	{
 		LOGNOTE("Using serial MIDI interface");
 		s_pThis->m_bSerialMIDIEnabled = true;
@@ -1273,11 +2260,32 @@ void CMT32Pi::USBMIDIDeviceRemovedHandler(CDevice* pDevice, void* pContext)
 }
 
 // The following handlers are called from interrupt context, enqueue into ring buffer for main thread
+// Circle's packet handlers take no context, so each device slot gets its own instance
+template <size_t nPort>
 void CMT32Pi::USBMIDIPacketHandler(unsigned nCable, u8* pPacket, unsigned nLength)
 {
-	IRQMIDIReceiveHandler(pPacket, nLength);
+	assert(s_pThis != nullptr);
+
+	TUSBMIDIPort& Port = s_pThis->m_USBMIDIPorts[nPort];
+	++Port.nPackets;
+
+	if (Port.RxBuffer.Enqueue(pPacket, nLength) != nLength)
+	{
+		++Port.nOverruns;
+		static const char* pErrorString = "MIDI overrun error!";
+		LOGWARN(pErrorString);
+		s_pThis->LCDLog(TLCDLogType::Error, pErrorString);
+	}
 }
 
+TMIDIPacketHandler* const CMT32Pi::USBMIDIPacketHandlers[MaxUSBMIDIDevices] =
+{
+	USBMIDIPacketHandler<0>,
+	USBMIDIPacketHandler<1>,
+	USBMIDIPacketHandler<2>,
+	USBMIDIPacketHandler<3>,
+};
+
 void CMT32Pi::IRQMIDIReceiveHandler(const u8* pData, size_t nSize)
 {
 	assert(s_pThis != nullptr);
@@ -1291,14 +2299,20 @@ void CMT32Pi::IRQMIDIReceiveHandler(const u8* pData, size_t nSize)
 	}
 }
 
+void CMT32Pi::RenderHelperWakeHandler(void* pParam)
+{
+	CMT32Pi* const pThis = static_cast<CMT32Pi*>(pParam);
+	pThis->m_CoreMailbox.Send(pThis->m_nAudioCore, pThis->m_nRenderHelperCore, TCoreMessage{static_cast<u32>(TCoreMessageType::RenderChunk), 0});
+}
+
 void CMT32Pi::PanicHandler()
 {
 	if (!s_pThis || !s_pThis->m_pLCD)
 		return;
 
-	// Kill UI task
+	// Kill UI task, unless it was running on this core
 	s_pThis->m_bRunning = false;
-	while (!s_pThis->m_bUITaskDone)
+	while (!s_pThis->m_bUITaskDone && ThisCore() != s_pThis->m_nUICore)
 		;
 
 	const char* pGuru = "Guru Meditation:";
@@ -30,6 +30,7 @@
 
 #include "net/applemidi.h"
 #include "net/byteorder.h"
+#include "stackmonitor.h"
 
 // #define APPLEMIDI_DEBUG
 
@@ -120,6 +121,11 @@ u64 GetSyncClock()
 	return (nMicrosSinceEpoch - nStartTime ) / 100;
 }
 
+bool IsAppleMIDICommandPacket(const u8* pBuffer, size_t nSize)
+{
+	return nSize >= sizeof(u16) && ntohs(*reinterpret_cast<const u16*>(pBuffer)) == AppleMIDISignature;
+}
+
 bool ParseInvitationPacket(const u8* pBuffer, size_t nSize, TAppleMIDISession* pOutPacket)
 {
 	const TAppleMIDISession* const pInPacket = reinterpret_cast<const TAppleMIDISession*>(pBuffer);
@@ -457,7 +463,7 @@ bool ParseMIDIPacket(const u8* pBuffer, size_t nSize, TRTPMIDI* pOutPacket, CApp
 	return ParseMIDICommandSection(pMIDICommandSection, nRemaining, pHandler);
 }
 
-CAppleMIDIParticipant::CAppleMIDIParticipant(CBcmRandomNumberGenerator* pRandom, CAppleMIDIHandler* pHandler)
+CAppleMIDIParticipant::CAppleMIDIParticipant(CBcmRandomNumberGenerator* pRandom, CAppleMIDIHandler* pHandler, CNetMIDIAdmission* pAdmission)
 	: CTask(TASK_STACK_SIZE, true),
 
 	  m_pRandom(pRandom),
@@ -476,6 +482,7 @@ CAppleMIDIParticipant::CAppleMIDIParticipant(CBcmRandomNumberGenerator* pRandom,
 	  m_nMIDIResult(0),
 
 	  m_pHandler(pHandler),
+	  m_pAdmission(pAdmission),
 
 	  m_State(TState::ControlInvitation),
 
@@ -535,6 +542,8 @@ bool CAppleMIDIParticipant::Initialize()
 
 void CAppleMIDIParticipant::Run()
 {
+	CStackMonitor::CTaskScope StackScope("applemidi", this);
+
 	assert(m_pControlSocket != nullptr);
 	assert(m_pMIDISocket != nullptr);
 
@@ -585,6 +594,14 @@ void CAppleMIDIParticipant::ControlInvitationState()
 	LOGNOTE("<-- Control invitation");
 #endif
 
+	// Reject peers outside the allowlist; ignore invitation floods
+	if (!m_pAdmission->Admit(m_ForeignControlIPAddress, m_nControlResult))
+	{
+		if (!m_pAdmission->IsAllowed(m_ForeignControlIPAddress))
+			SendRejectInvitationPacket(m_pControlSocket, &m_ForeignControlIPAddress, m_nForeignControlPort, SessionPacket.nInitiatorToken);
+		return;
+	}
+
 	// Store initiator details
 	m_InitiatorIPAddress.Set(m_ForeignControlIPAddress);
 	m_nInitiatorControlPort = m_nForeignControlPort;
@@ -702,8 +719,12 @@ void CAppleMIDIParticipant::ConnectedState()
 	{
 		if (m_ForeignMIDIIPAddress != m_InitiatorIPAddress || m_nForeignMIDIPort != m_nInitiatorMIDIPort)
 			LOGERR("Unexpected packet");
-		else if (ParseMIDIPacket(m_MIDIBuffer, m_nMIDIResult, &MIDIPacket, m_pHandler))
-			m_nSequence = MIDIPacket.nSequence;
+		else if (!IsAppleMIDICommandPacket(m_MIDIBuffer, m_nMIDIResult))
+		{
+			// Only MIDI data is rate limited so that sync packets keep the session alive
+			if (m_pAdmission->Admit(m_ForeignMIDIIPAddress, m_nMIDIResult) && ParseMIDIPacket(m_MIDIBuffer, m_nMIDIResult, &MIDIPacket, m_pHandler))
+				m_nSequence = MIDIPacket.nSequence;
+		}
 		else if (ParseSyncPacket(m_MIDIBuffer, m_nMIDIResult, &SyncPacket))
 		{
 #ifdef APPLEMIDI_DEBUG
@@ -28,6 +28,7 @@
 
 #include "net/ftpdaemon.h"
 #include "net/ftpworker.h"
+#include "stackmonitor.h"
 
 LOGMODULE("ftpd");
 
@@ -75,6 +76,8 @@ bool CFTPDaemon::Initialize()
 
 void CFTPDaemon::Run()
 {
+	CStackMonitor::CTaskScope StackScope("ftpdaemon", this);
+
 	assert(m_pListenSocket != nullptr);
 
 	LOGNOTE("Listener task spawned");
@@ -32,6 +32,7 @@
 #include <cstdio>
 
 #include "net/ftpworker.h"
+#include "stackmonitor.h"
 #include "utility.h"
 
 // Use a per-instance name for the log macros
@@ -161,6 +162,8 @@ CFTPWorker::~CFTPWorker()
 
 void CFTPWorker::Run()
 {
+	CStackMonitor::CTaskScope StackScope("ftpworker", this);
+
 	assert(m_pControlSocket != nullptr);
 
 	const size_t nWorkerNumber = s_nInstanceCount;
@@ -0,0 +1,270 @@
+//
+// midiadmission.cpp
+//
+// mt32-pi - A baremetal MIDI synthesizer for Raspberry Pi
+// Copyright (C) 2020-2023 Dale Whinham <daleyo@gmail.com>
+//
+// This file is part of mt32-pi.
+//
+// mt32-pi is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// mt32-pi is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// mt32-pi. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <circle/logger.h>
+#include <circle/net/socket.h>
+#include <circle/string.h>
+#include <circle/timer.h>
+#include <circle/util.h>
+
+#include <cstdlib>
+
+#include "net/midiadmission.h"
+#include "utility.h"
+
+LOGMODULE("midiadmission");
+
+// Bursts of up to a quarter of a second of traffic are let through, but always at least one full frame
+constexpr unsigned int BurstMillis = 250;
+constexpr u64 TokenScale = 1000000;
+
+CNetMIDIAdmission::CNetMIDIAdmission()
+	: m_AllowEntries{},
+	  m_nAllowEntries(0),
+	  m_nRefillPerMicro(0),
+	  m_nBucketSize(0),
+	  m_Peers{},
+	  m_nPeers(0),
+	  m_nDeniedPackets(0),
+	  m_nLastDeniedAddress(0)
+{
+}
+
+void CNetMIDIAdmission::Configure(const char* pAllowlist, unsigned int nRateLimit)
+{
+	m_nAllowEntries = 0;
+
+	const char* pString = pAllowlist;
+	while (*pString)
+	{
+		// Skip separators
+		if (*pString == ',' || *pString == ' ' || *pString == '\t')
+		{
+			++pString;
+			continue;
+		}
+
+		u32 nAddress = 0;
+		bool bValid = true;
+		for (size_t i = 0; i < 4; ++i)
+		{
+			char* pEnd;
+			const unsigned long nOctet = strtoul(pString, &pEnd, 10);
+			if (pEnd == pString || nOctet > 255 || (i < 3 && *pEnd != '.'))
+			{
+				bValid = false;
+				break;
+			}
+
+			nAddress = nAddress << 8 | nOctet;
+			pString = i < 3 ? pEnd + 1 : pEnd;
+		}
+
+		unsigned long nPrefixLength = 32;
+		if (bValid && *pString == '/')
+		{
+			char* pEnd;
+			nPrefixLength = strtoul(pString + 1, &pEnd, 10);
+			bValid = pEnd != pString + 1 && nPrefixLength <= 32;
+			pString = pEnd;
+		}
+
+		if (!bValid || (*pString && *pString != ',' && *pString != ' ' && *pString != '\t'))
+		{
+			LOGERR("Invalid MIDI allowlist entry");
+
+			// Skip to the next entry
+			while (*pString && *pString != ',')
+				++pString;
+			continue;
+		}
+
+		if (m_nAllowEntries == MaxAllowEntries)
+		{
+			LOGWARN("Too many MIDI allowlist entries; only the first %d are used", MaxAllowEntries);
+			break;
+		}
+
+		const u32 nMask = nPrefixLength ? 0xFFFFFFFF << (32 - nPrefixLength) : 0;
+		m_AllowEntries[m_nAllowEntries++] = TAllowEntry{nAddress & nMask, nMask};
+	}
+
+	m_nRefillPerMicro = nRateLimit;
+	m_nBucketSize = Utility::Max(static_cast<u64>(nRateLimit) * BurstMillis / 1000, static_cast<u64>(FRAME_BUFFER_SIZE)) * TokenScale;
+
+	if (m_nAllowEntries)
+		LOGNOTE("Network MIDI accepted from %d allowlist entries", m_nAllowEntries);
+	if (nRateLimit)
+		LOGNOTE("Network MIDI limited to %d bytes/s per peer", nRateLimit);
+}
+
+bool CNetMIDIAdmission::IsAllowed(const CIPAddress& Address) const
+{
+	return IsAllowed(ToHostOrder(Address));
+}
+
+bool CNetMIDIAdmission::Admit(const CIPAddress& Address, size_t nBytes)
+{
+	const u32 nAddress = ToHostOrder(Address);
+
+	// Denied peers don't get a slot; a flood of them would otherwise evict allowed peers and refill their buckets
+	if (!IsAllowed(nAddress))
+	{
+		if (nAddress != m_nLastDeniedAddress)
+		{
+			CString AddressString;
+			FormatAddress(nAddress, AddressString);
+			LOGWARN("Rejecting MIDI from %s (not in allowlist)", static_cast<const char*>(AddressString));
+			m_nLastDeniedAddress = nAddress;
+		}
+
+		++m_nDeniedPackets;
+		return false;
+	}
+
+	TPeer& Peer = GetPeer(nAddress, CTimer::GetClockTicks());
+
+	if (m_nRefillPerMicro)
+	{
+		const u64 nCost = nBytes * TokenScale;
+		if (Peer.nTokens < nCost)
+		{
+			if (!Peer.bThrottled)
+			{
+				CString AddressString;
+				FormatAddress(nAddress, AddressString);
+				LOGWARN("Rate limiting MIDI from %s", static_cast<const char*>(AddressString));
+				Peer.bThrottled = true;
+			}
+
+			++Peer.nDroppedPackets;
+			Peer.nDroppedBytes += nBytes;
+			return false;
+		}
+
+		Peer.nTokens -= nCost;
+		Peer.bThrottled = false;
+	}
+
+	++Peer.nAcceptedPackets;
+	Peer.nAcceptedBytes += nBytes;
+	return true;
+}
+
+void CNetMIDIAdmission::Dump() const
+{
+	for (size_t i = 0; i < m_nPeers; ++i)
+	{
+		const TPeer& Peer = m_Peers[i];
+		CString AddressString;
+		FormatAddress(Peer.nAddress, AddressString);
+
+		LOGNOTE("%s: %d packets/%d bytes accepted, %d packets/%d bytes rate limited",
+			static_cast<const char*>(AddressString), Peer.nAcceptedPackets, Peer.nAcceptedBytes,
+			Peer.nDroppedPackets, Peer.nDroppedBytes);
+	}
+
+	if (m_nAllowEntries)
+		LOGNOTE("%d packets denied from peers outside the allowlist", m_nDeniedPackets);
+}
+
+void CNetMIDIAdmission::ResetStats()
+{
+	for (size_t i = 0; i < m_nPeers; ++i)
+	{
+		TPeer& Peer = m_Peers[i];
+		Peer.nAcceptedPackets = 0;
+		Peer.nAcceptedBytes = 0;
+		Peer.nDroppedPackets = 0;
+		Peer.nDroppedBytes = 0;
+	}
+
+	m_nDeniedPackets = 0;
+}
+
+u32 CNetMIDIAdmission::ToHostOrder(const CIPAddress& Address)
+{
+	const u8* pAddress = Address.Get();
+	return pAddress[0] << 24 | pAddress[1] << 16 | pAddress[2] << 8 | pAddress[3];
+}
+
+void CNetMIDIAdmission::FormatAddress(u32 nAddress, CString& OutString)
+{
+	OutString.Format("%d.%d.%d.%d", nAddress >> 24, (nAddress >> 16) & 0xFF, (nAddress >> 8) & 0xFF, nAddress & 0xFF);
+}
+
+bool CNetMIDIAdmission::IsAllowed(u32 nAddress) const
+{
+	if (!m_nAllowEntries)
+		return true;
+
+	for (size_t i = 0; i < m_nAllowEntries; ++i)
+	{
+		if ((nAddress & m_AllowEntries[i].nMask) == m_AllowEntries[i].nAddress)
+			return true;
+	}
+
+	return false;
+}
+
+CNetMIDIAdmission::TPeer& CNetMIDIAdmission::GetPeer(u32 nAddress, unsigned int nTicks)
+{
+	TPeer* pPeer = nullptr;
+
+	for (size_t i = 0; i < m_nPeers; ++i)
+	{
+		if (m_Peers[i].nAddress == nAddress)
+		{
+			pPeer = &m_Peers[i];
+			break;
+		}
+	}
+
+	if (pPeer)
+	{
+		// Refill for the time since the last packet
+		const u64 nRefill = static_cast<u64>(nTicks - pPeer->nLastSeen) * m_nRefillPerMicro;
+		pPeer->nTokens = Utility::Min(pPeer->nTokens + nRefill, m_nBucketSize);
+	}
+	else
+	{
+		// New peer; replace the one heard from least recently if the table is full
+		if (m_nPeers < MaxPeers)
+			pPeer = &m_Peers[m_nPeers++];
+		else
+		{
+			pPeer = &m_Peers[0];
+			for (size_t i = 1; i < MaxPeers; ++i)
+			{
+				if (nTicks - m_Peers[i].nLastSeen > nTicks - pPeer->nLastSeen)
+					pPeer = &m_Peers[i];
+			}
+		}
+
+		*pPeer = TPeer{};
+		pPeer->nAddress = nAddress;
+		pPeer->nTokens = m_nBucketSize;
+	}
+
+	pPeer->nLastSeen = nTicks;
+	return *pPeer;
+}
@@ -26,16 +26,19 @@
 #include <circle/sched/scheduler.h>
 
 #include "net/udpmidi.h"
+#include "stackmonitor.h"
 
 LOGMODULE("udpmidi");
 
 constexpr u16 MIDIPort = 1999;
 
-CUDPMIDIReceiver::CUDPMIDIReceiver(CUDPMIDIHandler* pHandler)
+CUDPMIDIReceiver::CUDPMIDIReceiver(CUDPMIDIHandler* pHandler, CNetMIDIAdmission* pAdmission)
 	: CTask(TASK_STACK_SIZE, true),
 	  m_pMIDISocket(nullptr),
 	  m_MIDIBuffer{0},
-	  m_pHandler(pHandler)
+	  m_nForeignPort(0),
+	  m_pHandler(pHandler),
+	  m_pAdmission(pAdmission)
 {
 }
 
@@ -68,19 +71,22 @@ bool CUDPMIDIReceiver::Initialize()
 
 void CUDPMIDIReceiver::Run()
 {
+	CStackMonitor::CTaskScope StackScope("udpmidi", this);
+
 	assert(m_pHandler != nullptr);
 	assert(m_pMIDISocket != nullptr);
+	assert(m_pAdmission != nullptr);
 
 	CScheduler* const pScheduler = CScheduler::Get();
 
 	while (true)
 	{
 		// Blocking call
-		const int nMIDIResult = m_pMIDISocket->Receive(m_MIDIBuffer, sizeof(m_MIDIBuffer), 0);
+		const int nMIDIResult = m_pMIDISocket->ReceiveFrom(m_MIDIBuffer, sizeof(m_MIDIBuffer), 0, &m_ForeignIPAddress, &m_nForeignPort);
 
 		if (nMIDIResult < 0)
 			LOGERR("MIDI socket receive error: %d", nMIDIResult);
-		else if (nMIDIResult > 0)
+		else if (nMIDIResult > 0 && m_pAdmission->Admit(m_ForeignIPAddress, nMIDIResult))
 			m_pHandler->OnUDPMIDIDataReceived(m_MIDIBuffer, nMIDIResult);
 
 		// Allow other tasks to run
@@ -20,11 +20,11 @@
 // mt32-pi. If not, see <http://www.gnu.org/licenses/>.
 //
 
-#include <circle/bcmpropertytags.h>
 #include <circle/cputhrottle.h>
 #include <circle/logger.h>
 #include <circle/timer.h>
 
+#include "firmwarestatus.h"
 #include "power.h"
 
 LOGMODULE("power");
@@ -92,22 +92,24 @@ void CPower::OnUnderVoltageDetected()
 
 void CPower::UpdateThrottledStatus()
 {
-	// Get throttled status from the firmware and clear status bits
-	TPropertyTagSimple ThrottledStatus;
-	ThrottledStatus.nValue = 0xFFFF;
-	m_Tags.GetTag(PROPTAG_GET_THROTTLED, &ThrottledStatus, sizeof(ThrottledStatus), sizeof(ThrottledStatus.nValue));
+	// Throttled status is polled in the background
+	const CFirmwareStatus* const pFirmwareStatus = CFirmwareStatus::Get();
+	if (!pFirmwareStatus)
+		return;
+
+	const u32 nThrottledStatus = pFirmwareStatus->GetThrottledStatus();
 
-	bool bNewVal = ThrottledStatus.nValue & ThrottlingOccurredBit;
+	bool bNewVal = nThrottledStatus & ThrottlingOccurredBit;
 	bool bOldVal = m_LastThrottledStatus & ThrottlingOccurredBit;
 
 	if (bNewVal && bOldVal != bNewVal)
 		OnThrottleDetected();
 
-	bNewVal = ThrottledStatus.nValue & UnderVoltageOccurredBit;
+	bNewVal = nThrottledStatus & UnderVoltageOccurredBit;
 	bOldVal = m_LastThrottledStatus & UnderVoltageOccurredBit;
 
 	if (bNewVal && bOldVal != bNewVal)
 		OnUnderVoltageDetected();
 
-	m_LastThrottledStatus = ThrottledStatus.nValue;
+	m_LastThrottledStatus = nThrottledStatus;
 }
@@ -0,0 +1,129 @@
+//
+// profilemanager.cpp
+//
+// mt32-pi - A baremetal MIDI synthesizer for Raspberry Pi
+// Copyright (C) 2020-2023 Dale Whinham <daleyo@gmail.com>
+//
+// This file is part of mt32-pi.
+//
+// mt32-pi is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// mt32-pi is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// mt32-pi. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <circle/logger.h>
+#include <circle/util.h>
+#include <fatfs/ff.h>
+
+#include <ini.h>
+
+#include "profilemanager.h"
+#include "soundfontmanager.h"
+
+LOGMODULE("profilemanager");
+
+CProfileManager::CProfileManager()
+	: m_nProfiles(0)
+{
+}
+
+bool CProfileManager::LoadProfiles(const char* pPath)
+{
+	m_nProfiles = 0;
+
+	FIL File;
+	if (f_open(&File, pPath, FA_READ) != FR_OK)
+		return false;
+
+	// +1 byte for null terminator
+	const UINT nSize = f_size(&File);
+	char Buffer[nSize + 1];
+	UINT nRead;
+
+	if (f_read(&File, Buffer, nSize, &nRead) != FR_OK)
+	{
+		LOGERR("Error reading profiles");
+		f_close(&File);
+		return false;
+	}
+
+	f_close(&File);
+
+	// Ensure null-terminated
+	Buffer[nRead] = '\0';
+
+	const int nResult = ini_parse_string(Buffer, INIHandler, this);
+	if (nResult > 0)
+		LOGWARN("Profile parse error on line %d", nResult);
+
+	LOGNOTE("%d profiles loaded", m_nProfiles);
+	return m_nProfiles > 0;
+}
+
+const TProfile* CProfileManager::GetProfile(size_t nIndex) const
+{
+	return nIndex < m_nProfiles ? &m_Profiles[nIndex] : nullptr;
+}
+
+const char* CProfileManager::GetProfileName(size_t nIndex) const
+{
+	return nIndex < m_nProfiles ? static_cast<const char*>(m_Profiles[nIndex].Name) : nullptr;
+}
+
+int CProfileManager::INIHandler(void* pUser, const char* pSection, const char* pName, const char* pValue)
+{
+	CProfileManager* const pProfileManager = static_cast<CProfileManager*>(pUser);
+
+	// Each section is a profile
+	if (!*pSection)
+		return 0;
+
+	size_t& nProfiles = pProfileManager->m_nProfiles;
+	if (nProfiles == 0 || strcmp(pProfileManager->m_Profiles[nProfiles - 1].Name, pSection))
+	{
+		if (nProfiles == MaxProfiles)
+		{
+			LOGWARN("Too many profiles; ignoring \"%s\"", pSection);
+			return 0;
+		}
+
+		pProfileManager->m_Profiles[nProfiles++].Name = pSection;
+	}
+
+	TProfile* const pProfile = &pProfileManager->m_Profiles[nProfiles - 1];
+
+	#define MATCH(NAME, STRUCT_MEMBER)                                \
+		if (!strcmp(NAME, pName))                                 \
+		{                                                         \
+			auto Temp = decltype(*pProfile->STRUCT_MEMBER){}; \
+			if (CConfig::ParseOption(pValue, &Temp))          \
+			{                                                 \
+				pProfile->STRUCT_MEMBER = Temp;           \
+				return 1;                                 \
+			}                                                 \
+			return 0;                                         \
+		}
+
+	MATCH("synth", Synth);
+	MATCH("volume", nVolume);
+
+	MATCH("mt32_rom_set", MT32ROMSet);
+	MATCH("mt32_midi_channels", MT32MIDIChannels);
+	MATCH("mt32_reversed_stereo", bMT32ReversedStereo);
+
+	MATCH("soundfont", nSoundFont);
+
+	#undef MATCH
+
+	// Effects settings use the same keys as SoundFont effects profiles
+	return CSoundFontManager::INIHandler(&pProfile->FXProfile, pSection, pName, pValue);
+}
@@ -0,0 +1,316 @@
+//
+// renderscheduler.cpp
+//
+// mt32-pi - A baremetal MIDI synthesizer for Raspberry Pi
+// Copyright (C) 2020-2023 Dale Whinham <daleyo@gmail.com>
+//
+// This file is part of mt32-pi.
+//
+// mt32-pi is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// mt32-pi is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// mt32-pi. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <circle/logger.h>
+#include <circle/timer.h>
+
+#include "renderscheduler.h"
+
+LOGMODULE("renderscheduler");
+
+CRenderScheduler::CRenderScheduler()
+	: m_Jobs{},
+	  m_nJobs(0),
+	  m_nWorkers(1),
+	  m_pWakeHandler(nullptr),
+	  m_pWakeParam(nullptr),
+
+	  m_Deques{},
+	  m_nNextWorker(0),
+	  m_nGeneration(0),
+	  m_bChunkOpen(false),
+
+	  m_nChunk(0),
+	  m_nPendingJobs(0),
+	  m_nSeenChunk{},
+	  m_nWorkerBusyTime{},
+
+	  m_nChunks(0),
+	  m_nSteals(0),
+	  m_nDeadlineMisses(0),
+	  m_nPeakChunkTime(0),
+	  m_nImbalance(0),
+	  m_nPeakImbalance(0),
+	  m_nImbalanceTotal(0),
+	  m_nImbalanceChunks(0)
+{
+}
+
+size_t CRenderScheduler::AddJob(const char* pName, TJobFunction pFunction, void* pParam)
+{
+	if (m_nJobs == MaxJobs)
+	{
+		LOGERR("Too many render jobs; \"%s\" not added", pName);
+		return InvalidJob;
+	}
+
+	TJob& Job     = m_Jobs[m_nJobs];
+	Job.pName     = pName;
+	Job.pFunction = pFunction;
+	Job.pParam    = pParam;
+
+	return m_nJobs++;
+}
+
+void CRenderScheduler::SetWorkerCount(size_t nWorkers)
+{
+	assert(nWorkers >= 1 && nWorkers <= MaxWorkers);
+	m_nWorkers = nWorkers;
+}
+
+void CRenderScheduler::SetWakeHandler(TWakeHandler pHandler, void* pParam)
+{
+	m_pWakeHandler = pHandler;
+	m_pWakeParam   = pParam;
+}
+
+void CRenderScheduler::Submit(size_t nJob)
+{
+	assert(nJob < m_nJobs);
+
+	if (!m_bChunkOpen)
+		BeginChunk();
+
+	// Spread jobs evenly; stealing evens out the rest
+	TDeque& Deque = m_Deques[m_nNextWorker];
+	m_nNextWorker = (m_nNextWorker + 1) % m_nWorkers;
+
+	// A helper may already be running an earlier job from this chunk
+	__atomic_add_fetch(&m_nPendingJobs, 1, __ATOMIC_RELAXED);
+
+	// Only the audio core pushes, but a helper still finishing a Pop() can move the tail under us, so push with a CAS.
+	// Slots at or above the tail are never read, so the job can be written before it is published.
+	u32 nState = __atomic_load_n(&Deque.nState, __ATOMIC_ACQUIRE);
+	while (true)
+	{
+		const u8 nTail = nState & 0xFF;
+		assert(nTail < MaxJobs);
+		Deque.Jobs[nTail] = nJob;
+
+		// Release makes the job's parameters visible to whoever takes it
+		const u32 nNewState = (nState & ~0xFFu) | (nTail + 1);
+		if (__atomic_compare_exchange_n(&Deque.nState, &nState, nNewState, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+			break;
+	}
+}
+
+bool CRenderScheduler::Run(unsigned nDeadlineClockTicks)
+{
+	if (!m_bChunkOpen)
+		return true;
+
+	const unsigned nStartTime = CTimer::GetClockTicks();
+
+	// Wake the helpers
+	__atomic_store_n(&m_nChunk, m_nChunk + 1, __ATOMIC_RELEASE);
+	if (m_pWakeHandler)
+		m_pWakeHandler(m_pWakeParam);
+
+	WorkUntilEmpty(0);
+
+	// Wait for jobs still running on other cores; their output is needed even when late
+	while (__atomic_load_n(&m_nPendingJobs, __ATOMIC_ACQUIRE))
+		;
+
+	const unsigned nChunkTime = CTimer::GetClockTicks() - nStartTime;
+	const bool bMissed = nChunkTime > nDeadlineClockTicks;
+
+	m_bChunkOpen = false;
+	++m_nChunks;
+
+	if (bMissed)
+		++m_nDeadlineMisses;
+
+	if (nChunkTime > m_nPeakChunkTime)
+		m_nPeakChunkTime = nChunkTime;
+
+	// Imbalance is the idle time of the least busy worker relative to the busiest one
+	if (m_nWorkers > 1)
+	{
+		unsigned nMin = m_nWorkerBusyTime[0];
+		unsigned nMax = m_nWorkerBusyTime[0];
+		for (size_t i = 1; i < m_nWorkers; ++i)
+		{
+			const unsigned nBusyTime = __atomic_load_n(&m_nWorkerBusyTime[i], __ATOMIC_RELAXED);
+			if (nBusyTime < nMin)
+				nMin = nBusyTime;
+			if (nBusyTime > nMax)
+				nMax = nBusyTime;
+		}
+
+		m_nImbalance = nMax ? (nMax - nMin) * 100 / nMax : 0;
+		if (m_nImbalance > m_nPeakImbalance)
+			m_nPeakImbalance = m_nImbalance;
+
+		m_nImbalanceTotal += m_nImbalance;
+		++m_nImbalanceChunks;
+	}
+
+	return !bMissed;
+}
+
+unsigned CRenderScheduler::Poll(size_t nWorker)
+{
+	assert(nWorker > 0 && nWorker < MaxWorkers);
+
+	const u32 nChunk = __atomic_load_n(&m_nChunk, __ATOMIC_ACQUIRE);
+	if (nChunk == m_nSeenChunk[nWorker])
+		return 0;
+
+	m_nSeenChunk[nWorker] = nChunk;
+
+	const unsigned nStartTime = CTimer::GetClockTicks();
+	WorkUntilEmpty(nWorker);
+
+	return CTimer::GetClockTicks() - nStartTime;
+}
+
+void CRenderScheduler::Dump() const
+{
+	const u32 nAverageImbalance = m_nImbalanceChunks ? m_nImbalanceTotal / m_nImbalanceChunks : 0;
+
+	LOGNOTE("Render jobs: %d workers, %d chunks, %d steals, %d deadline misses, peak chunk time %d us", m_nWorkers, m_nChunks, m_nSteals, m_nDeadlineMisses, m_nPeakChunkTime);
+	LOGNOTE("Imbalance: %d%% last, %d%% average, %d%% peak", m_nImbalance, nAverageImbalance, m_nPeakImbalance);
+
+	for (size_t i = 0; i < m_nJobs; ++i)
+	{
+		const TJob& Job = m_Jobs[i];
+		const u32 nAverageTime = Job.nRuns ? Job.nTotalTime / Job.nRuns : 0;
+		LOGNOTE("%s: last %d us, average %d us, peak %d us; last ran on worker %d", Job.pName, Job.nLastTime, nAverageTime, Job.nPeakTime, Job.nLastWorker);
+	}
+}
+
+void CRenderScheduler::ResetStats()
+{
+	for (TJob& Job : m_Jobs)
+	{
+		Job.nLastTime  = 0;
+		Job.nPeakTime  = 0;
+		Job.nTotalTime = 0;
+		Job.nRuns      = 0;
+	}
+
+	m_nChunks          = 0;
+	m_nSteals          = 0;
+	m_nDeadlineMisses  = 0;
+	m_nPeakChunkTime   = 0;
+	m_nImbalance       = 0;
+	m_nPeakImbalance   = 0;
+	m_nImbalanceTotal  = 0;
+	m_nImbalanceChunks = 0;
+}
+
+void CRenderScheduler::BeginChunk()
+{
+	// All deques are empty after the last chunk; a new generation invalidates any steal still in flight
+	++m_nGeneration;
+	for (size_t i = 0; i < m_nWorkers; ++i)
+	{
+		__atomic_store_n(&m_Deques[i].nState, static_cast<u32>(m_nGeneration) << 16, __ATOMIC_RELAXED);
+		__atomic_store_n(&m_nWorkerBusyTime[i], 0u, __ATOMIC_RELAXED);
+	}
+
+	m_nNextWorker = 0;
+	m_bChunkOpen  = true;
+}
+
+size_t CRenderScheduler::Pop(size_t nWorker)
+{
+	TDeque& Deque = m_Deques[nWorker];
+	u32 nState = __atomic_load_n(&Deque.nState, __ATOMIC_ACQUIRE);
+
+	while (true)
+	{
+		const u8 nHead = (nState >> 8) & 0xFF;
+		const u8 nTail = nState & 0xFF;
+		if (nHead == nTail)
+			return InvalidJob;
+
+		// Read the slot before giving it up; once the tail is lowered, the next Submit() may reuse it
+		const size_t nJob = Deque.Jobs[nTail - 1];
+		const u32 nNewState = (nState & ~0xFFu) | (nTail - 1);
+		if (__atomic_compare_exchange_n(&Deque.nState, &nState, nNewState, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+			return nJob;
+	}
+}
+
+size_t CRenderScheduler::Steal(size_t nThief)
+{
+	for (size_t i = 1; i < m_nWorkers; ++i)
+	{
+		TDeque& Deque = m_Deques[(nThief + i) % m_nWorkers];
+		u32 nState = __atomic_load_n(&Deque.nState, __ATOMIC_ACQUIRE);
+
+		while (true)
+		{
+			const u8 nHead = (nState >> 8) & 0xFF;
+			const u8 nTail = nState & 0xFF;
+			if (nHead == nTail)
+				break;
+
+			const size_t nJob = Deque.Jobs[nHead];
+			const u32 nNewState = (nState & ~0xFF00u) | ((nHead + 1) << 8);
+			if (__atomic_compare_exchange_n(&Deque.nState, &nState, nNewState, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+			{
+				__atomic_add_fetch(&m_nSteals, 1, __ATOMIC_RELAXED);
+				return nJob;
+			}
+		}
+	}
+
+	return InvalidJob;
+}
+
+void CRenderScheduler::Execute(size_t nWorker, size_t nJob)
+{
+	TJob& Job = m_Jobs[nJob];
+
+	const unsigned nStartTime = CTimer::GetClockTicks();
+	Job.pFunction(Job.pParam);
+	const unsigned nTime = CTimer::GetClockTicks() - nStartTime;
+
+	Job.nLastTime = nTime;
+	if (nTime > Job.nPeakTime)
+		Job.nPeakTime = nTime;
+	Job.nTotalTime += nTime;
+	++Job.nRuns;
+	Job.nLastWorker = nWorker;
+
+	__atomic_store_n(&m_nWorkerBusyTime[nWorker], m_nWorkerBusyTime[nWorker] + nTime, __ATOMIC_RELAXED);
+
+	// Release publishes the job's output and statistics to the audio core
+	__atomic_sub_fetch(&m_nPendingJobs, 1, __ATOMIC_RELEASE);
+}
+
+void CRenderScheduler::WorkUntilEmpty(size_t nWorker)
+{
+	while (true)
+	{
+		size_t nJob = Pop(nWorker);
+		if (nJob == InvalidJob)
+			nJob = Steal(nWorker);
+		if (nJob == InvalidJob)
+			return;
+
+		Execute(nWorker, nJob);
+	}
+}
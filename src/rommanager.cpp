@@ -29,6 +29,13 @@ LOGMODULE("rommanager");
 const char* const Disks[] = { "SD", "USB" };
 const char ROMDirectory[] = "roms";
 
+#ifdef LOW_MEMORY
+// PCM ROMs are only kept in memory while a synth is being opened; mt32emu keeps its own copy of the samples
+constexpr bool LazyPCMROMs = true;
+#else
+constexpr bool LazyPCMROMs = false;
+#endif
+
 // Custom File class for mt32emu
 class CROMFile : public MT32Emu::AbstractFile
 {
@@ -92,14 +99,7 @@ CROMManager::~CROMManager()
 {
 	const MT32Emu::ROMImage** const ROMs[] = { &m_pMT32OldControl, &m_pMT32NewControl, &m_pCM32LControl, &m_pMT32PCM, &m_pCM32LPCM };
 	for (const MT32Emu::ROMImage** pROMImagePtr : ROMs)
-	{
-		if (*pROMImagePtr)
-		{
-			if (MT32Emu::File* File = (*pROMImagePtr)->getFile())
-				delete File;
-			MT32Emu::ROMImage::freeROMImage(*pROMImagePtr);
-		}
-	}
+		FreeROM(*pROMImagePtr);
 }
 
 bool CROMManager::ScanROMs()
@@ -150,25 +150,25 @@ bool CROMManager::HaveROMSet(TMT32ROMSet ROMSet) const
 	switch (ROMSet)
 	{
 		case TMT32ROMSet::Any:
-			return ((m_pMT32OldControl || m_pMT32NewControl) && m_pMT32PCM) || (m_pCM32LControl && m_pCM32LPCM);
+			return ((m_pMT32OldControl || m_pMT32NewControl) && HaveMT32PCM()) || (m_pCM32LControl && HaveCM32LPCM());
 
 		case TMT32ROMSet::All:
-			return m_pMT32OldControl && m_pMT32NewControl && m_pCM32LControl && m_pMT32PCM && m_pCM32LPCM;
+			return m_pMT32OldControl && m_pMT32NewControl && m_pCM32LControl && HaveMT32PCM() && HaveCM32LPCM();
 
 		case TMT32ROMSet::MT32Old:
-			return m_pMT32OldControl && m_pMT32PCM;
+			return m_pMT32OldControl && HaveMT32PCM();
 
 		case TMT32ROMSet::MT32New:
-			return m_pMT32NewControl && m_pMT32PCM;
+			return m_pMT32NewControl && HaveMT32PCM();
 
 		case TMT32ROMSet::CM32L:
-			return m_pCM32LControl && m_pCM32LPCM;
+			return m_pCM32LControl && HaveCM32LPCM();
 	}
 
 	return false;
 }
 
-bool CROMManager::GetROMSet(TMT32ROMSet ROMSet, TMT32ROMSet& pOutROMSet, const MT32Emu::ROMImage*& pOutControl, const MT32Emu::ROMImage*& pOutPCM) const
+bool CROMManager::GetROMSet(TMT32ROMSet ROMSet, TMT32ROMSet& pOutROMSet, const MT32Emu::ROMImage*& pOutControl, const MT32Emu::ROMImage*& pOutPCM)
 {
 	if (!HaveROMSet(ROMSet))
 		return false;
@@ -191,29 +191,20 @@ bool CROMManager::GetROMSet(TMT32ROMSet ROMSet, TMT32ROMSet& pOutROMSet, const M
 				pOutControl = m_pCM32LControl;
 				pOutROMSet  = TMT32ROMSet::CM32L;
 			}
-
-			if (pOutControl == m_pCM32LControl)
-				pOutPCM = m_pCM32LPCM;
-			else
-				pOutPCM = m_pMT32PCM;
-
 			break;
 
 		case TMT32ROMSet::MT32Old:
 			pOutControl = m_pMT32OldControl;
-			pOutPCM     = m_pMT32PCM;
 			pOutROMSet  = TMT32ROMSet::MT32Old;
 			break;
 
 		case TMT32ROMSet::MT32New:
 			pOutControl = m_pMT32NewControl;
-			pOutPCM     = m_pMT32PCM;
 			pOutROMSet  = TMT32ROMSet::MT32New;
 			break;
 
 		case TMT32ROMSet::CM32L:
 			pOutControl = m_pCM32LControl;
-			pOutPCM     = m_pCM32LPCM;
 			pOutROMSet  = TMT32ROMSet::CM32L;
 			break;
 
@@ -221,35 +212,87 @@ bool CROMManager::GetROMSet(TMT32ROMSet ROMSet, TMT32ROMSet& pOutROMSet, const M
 			return false;
 	}
 
-	return true;
+	// Reload only the PCM ROM this set needs if it was released after the last synth was opened
+	const bool bCM32L = pOutROMSet == TMT32ROMSet::CM32L;
+	const MT32Emu::ROMImage*& pPCM = bCM32L ? m_pCM32LPCM : m_pMT32PCM;
+	if (!pPCM)
+		pPCM = LoadROM(bCM32L ? m_CM32LPCMPath : m_MT32PCMPath);
+
+	pOutPCM = pPCM;
+	return pOutPCM != nullptr;
 }
 
-bool CROMManager::CheckROM(const char* pPath)
+void CROMManager::ReleasePCMROMs()
+{
+	if (!LazyPCMROMs)
+		return;
+
+	FreeROM(m_pMT32PCM);
+	FreeROM(m_pCM32LPCM);
+}
+
+size_t CROMManager::GetResidentSize() const
+{
+	const MT32Emu::ROMImage* const ROMs[] = { m_pMT32OldControl, m_pMT32NewControl, m_pCM32LControl, m_pMT32PCM, m_pCM32LPCM };
+	size_t nSize = 0;
+
+	for (const MT32Emu::ROMImage* pROMImage : ROMs)
+	{
+		if (pROMImage)
+			nSize += pROMImage->getFile()->getSize();
+	}
+
+	return nSize;
+}
+
+const MT32Emu::ROMImage* CROMManager::LoadROM(const char* pPath)
 {
 	CROMFile* pFile = new CROMFile();
 	if (!pFile->open(pPath))
 	{
 		LOGERR("Couldn't open '%s' for reading", pPath);
 		delete pFile;
-		return false;
+		return nullptr;
 	}
 
+	return MT32Emu::ROMImage::makeROMImage(pFile);
+}
+
+void CROMManager::FreeROM(const MT32Emu::ROMImage*& pROMImage)
+{
+	if (!pROMImage)
+		return;
+
+	if (MT32Emu::File* File = pROMImage->getFile())
+		delete File;
+	MT32Emu::ROMImage::freeROMImage(pROMImage);
+	pROMImage = nullptr;
+}
+
+bool CROMManager::CheckROM(const char* pPath)
+{
 	// Check ROM and store if valid
-	const MT32Emu::ROMImage* pROM = MT32Emu::ROMImage::makeROMImage(pFile);
-	if (!StoreROM(*pROM))
+	const MT32Emu::ROMImage* pROM = LoadROM(pPath);
+	if (!pROM)
+		return false;
+
+	if (!StoreROM(*pROM, pPath))
 	{
-		MT32Emu::ROMImage::freeROMImage(pROM);
-		delete pFile;
+		FreeROM(pROM);
 		return false;
 	}
 
+	// Only needed to identify the ROM
+	ReleasePCMROMs();
+
 	return true;
 }
 
-bool CROMManager::StoreROM(const MT32Emu::ROMImage& ROMImage)
+bool CROMManager::StoreROM(const MT32Emu::ROMImage& ROMImage, const char* pPath)
 {
 	const MT32Emu::ROMInfo* pROMInfo = ROMImage.getROMInfo();
 	const MT32Emu::ROMImage** pROMImagePtr = nullptr;
+	CString* pPCMPath = nullptr;
 
 	// Not a valid ROM file
 	if (!pROMInfo)
@@ -273,17 +316,28 @@ bool CROMManager::StoreROM(const MT32Emu::ROMImage& ROMImage)
 	{
 		// Is an MT-32 PCM ROM
 		if (pROMInfo->shortName[4] == 'm')
+		{
 			pROMImagePtr = &m_pMT32PCM;
+			pPCMPath     = &m_MT32PCMPath;
+		}
 
 		// Is a CM-32L PCM ROM
 		else
+		{
 			pROMImagePtr = &m_pCM32LPCM;
+			pPCMPath     = &m_CM32LPCMPath;
+		}
 	}
 
 	// Ensure we don't already have this ROM
-	if (!pROMImagePtr || *pROMImagePtr)
+	if (!pROMImagePtr || *pROMImagePtr || (pPCMPath && pPCMPath->GetLength()))
 		return false;
 
 	*pROMImagePtr = &ROMImage;
+
+	// Remember where PCM ROMs came from so they can be reloaded
+	if (pPCMPath)
+		*pPCMPath = pPath;
+
 	return true;
 }
@@ -41,8 +41,11 @@ constexpr u32 FourCC(const char pFourCC[4])
 }
 
 constexpr u32 FourCCINAM = FourCC("INAM");
+constexpr u32 FourCCIMOD = FourCC("imod");
 constexpr u32 FourCCINFO = FourCC("INFO");
 constexpr u32 FourCCLIST = FourCC("LIST");
+constexpr u32 FourCCPDTA = FourCC("pdta");
+constexpr u32 FourCCPMOD = FourCC("pmod");
 constexpr u32 FourCCRIFF = FourCC("RIFF");
 constexpr u32 FourCCSFBK = FourCC("sfbk");
 
@@ -53,6 +56,20 @@ struct TSoundFontChunk
 }
 PACKED;
 
+// Modulator record from the pmod/imod chunks
+struct TSoundFontModulator
+{
+	u16 SrcOper;
+	u16 DestOper;
+	s16 Amount;
+	u16 AmtSrcOper;
+	u16 TransOper;
+}
+PACKED;
+
+// Bit 7 of a modulator source selects a MIDI controller; bits 0-6 are its number
+constexpr u16 ModulatorSourceCC = 1 << 7;
+
 CSoundFontManager::CSoundFontManager()
 	: m_nSoundFonts(0)
 {
@@ -180,6 +197,95 @@ const char* CSoundFontManager::GetFirstValidSoundFontPath() const
 	return m_nSoundFonts > 0 ? static_cast<const char*>(m_SoundFontList[0].Path) : nullptr;
 }
 
+bool CSoundFontManager::GetModulatorControllers(const char* pPath, u32 OutControllerMask[4], size_t& nOutModulators)
+{
+	FIL File;
+	UINT nBytesRead;
+	TSoundFontChunk Chunk;
+	u32 nFourCC;
+
+	memset(OutControllerMask, 0, sizeof(u32) * 4);
+	nOutModulators = 0;
+
+	if (f_open(&File, pPath, FA_READ) != FR_OK)
+		return false;
+
+	if (f_read(&File, &Chunk, sizeof(Chunk), &nBytesRead) != FR_OK || Chunk.FourCC != FourCCRIFF ||
+	    f_read(&File, &nFourCC, sizeof(nFourCC), &nBytesRead) != FR_OK || nFourCC != FourCCSFBK)
+	{
+		f_close(&File);
+		return false;
+	}
+
+	// Skip the INFO and sample data lists to reach the preset data list
+	bool bFoundPresetData = false;
+	while (!bFoundPresetData && f_read(&File, &Chunk, sizeof(Chunk), &nBytesRead) == FR_OK && nBytesRead == sizeof(Chunk))
+	{
+		const FSIZE_t nNextChunk = f_tell(&File) + Chunk.Size;
+
+		if (Chunk.FourCC == FourCCLIST && f_read(&File, &nFourCC, sizeof(nFourCC), &nBytesRead) == FR_OK && nFourCC == FourCCPDTA)
+			bFoundPresetData = true;
+		else
+			f_lseek(&File, nNextChunk);
+	}
+
+	if (!bFoundPresetData)
+	{
+		f_close(&File);
+		return false;
+	}
+
+	const FSIZE_t nPresetDataEnd = f_tell(&File) - sizeof(nFourCC) + Chunk.Size;
+	bool bFoundModulators = false;
+
+	while (f_tell(&File) < nPresetDataEnd && f_read(&File, &Chunk, sizeof(Chunk), &nBytesRead) == FR_OK && nBytesRead == sizeof(Chunk))
+	{
+		const FSIZE_t nNextChunk = f_tell(&File) + Chunk.Size;
+
+		if (Chunk.FourCC == FourCCPMOD || Chunk.FourCC == FourCCIMOD)
+		{
+			TSoundFontModulator Modulators[64];
+			size_t nRemaining = Chunk.Size / sizeof(TSoundFontModulator);
+
+			// Each list ends with a terminal record
+			if (nRemaining)
+				nOutModulators += nRemaining - 1;
+
+			while (nRemaining)
+			{
+				const size_t nCount = Utility::Min(nRemaining, Utility::ArraySize(Modulators));
+				if (f_read(&File, Modulators, nCount * sizeof(TSoundFontModulator), &nBytesRead) != FR_OK || nBytesRead != nCount * sizeof(TSoundFontModulator))
+				{
+					f_close(&File);
+					return false;
+				}
+
+				for (size_t i = 0; i < nCount; ++i)
+				{
+					const u16 Sources[] = { Modulators[i].SrcOper, Modulators[i].AmtSrcOper };
+					for (const u16 nSource : Sources)
+					{
+						if (nSource & ModulatorSourceCC)
+						{
+							const u8 nController = nSource & 0x7F;
+							OutControllerMask[nController / 32] |= 1u << (nController % 32);
+						}
+					}
+				}
+
+				nRemaining -= nCount;
+			}
+
+			bFoundModulators = true;
+		}
+
+		f_lseek(&File, nNextChunk);
+	}
+
+	f_close(&File);
+	return bFoundModulators;
+}
+
 void CSoundFontManager::CheckSoundFont(const char* pFullPath, const char* pFileName)
 {
 	FIL File;
@@ -279,12 +385,14 @@ int CSoundFontManager::INIHandler(void* pUser, const char* pSection, const char*
 	MATCH("gain", float, nGain);
 
 	MATCH("reverb", bool, bReverbActive);
+	MATCH("reverb_engine", TReverbEngine, ReverbEngine);
 	MATCH("reverb_damping", float, nReverbDamping);
 	MATCH("reverb_level", float, nReverbLevel);
 	MATCH("reverb_room_size", float, nReverbRoomSize);
 	MATCH("reverb_width", float, nReverbWidth);
 
 	MATCH("chorus", bool, bChorusActive);
+	MATCH("chorus_engine", TChorusEngine, ChorusEngine);
 	MATCH("chorus_depth", float, nChorusDepth);
 	MATCH("chorus_level", float, nChorusLevel);
 	MATCH("chorus_voices", int, nChorusVoices);
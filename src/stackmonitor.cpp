@@ -0,0 +1,196 @@
+//
+// stackmonitor.cpp
+//
+// mt32-pi - A baremetal MIDI synthesizer for Raspberry Pi
+// Copyright (C) 2020-2023 Dale Whinham <daleyo@gmail.com>
+//
+// This file is part of mt32-pi.
+//
+// mt32-pi is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// mt32-pi is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// mt32-pi. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <circle/logger.h>
+#include <circle/memorymap.h>
+#include <circle/sched/task.h>
+#include <circle/synchronize.h>
+#include <circle/sysconfig.h>
+#include <circle/timer.h>
+
+#include "stackmonitor.h"
+#include "utility.h"
+
+LOGMODULE("stackmonitor");
+
+constexpr u32 StackPaintPattern = 0x5354434B;
+
+// Space left unpainted below the current stack pointer for the painting code itself
+constexpr size_t PaintMargin = 512;
+
+constexpr u8 WarnPercentages[] = { 75, 90 };
+
+const char* const CoreStackNames[] = { "Core 0", "Core 1", "Core 2", "Core 3" };
+static_assert(Utility::ArraySize(CoreStackNames) >= CORES, "Missing core stack names");
+
+CStackMonitor* CStackMonitor::s_pThis = nullptr;
+
+CStackMonitor::CTaskScope::CTaskScope(const char* pName, const CTask* pTask)
+	: m_nIndex(s_pThis ? s_pThis->AddTask(pName, pTask) : RegionCount)
+{
+}
+
+CStackMonitor::CTaskScope::~CTaskScope()
+{
+	if (s_pThis && m_nIndex < RegionCount)
+		s_pThis->RemoveTask(m_nIndex);
+}
+
+CStackMonitor::CStackMonitor()
+	: m_Regions{},
+	  m_nLastUpdateTime(0)
+{
+	s_pThis = this;
+}
+
+void CStackMonitor::PaintCoreStack(unsigned nCore)
+{
+	assert(nCore < CORES);
+
+	const uintptr nStackPointer = reinterpret_cast<uintptr>(__builtin_frame_address(0));
+	const uintptr nTop          = MEM_KERNEL_STACK + nCore * KERNEL_STACK_SIZE;
+	const uintptr nBottom       = nTop - KERNEL_STACK_SIZE;
+
+	// Don't touch memory we aren't sure is ours
+	if (nStackPointer <= nBottom + PaintMargin || nStackPointer > nTop)
+	{
+		LOGWARN("Core %d stack pointer %p outside expected range; not monitored", nCore, nStackPointer);
+		return;
+	}
+
+	// Interrupt handlers run on this stack too
+	EnterCritical(FIQ_LEVEL);
+	Paint(nBottom, nStackPointer - PaintMargin);
+	LeaveCritical();
+
+	TStackRegion& Region = m_Regions[nCore];
+	Region.nBottom       = nBottom;
+	Region.nSize         = KERNEL_STACK_SIZE;
+	Region.nPaintedSize  = nStackPointer - PaintMargin - nBottom;
+
+	// Published last; the main core only measures named regions
+	__atomic_store_n(&Region.pName, CoreStackNames[nCore], __ATOMIC_RELEASE);
+}
+
+void CStackMonitor::Update(unsigned int nTicks)
+{
+	if (nTicks - m_nLastUpdateTime < HZ)
+		return;
+
+	m_nLastUpdateTime = nTicks;
+
+	for (TStackRegion& Region : m_Regions)
+	{
+		if (!__atomic_load_n(&Region.pName, __ATOMIC_ACQUIRE))
+			continue;
+
+		Region.nPeak = Measure(Region);
+
+		const u8 nPercent = Region.nPeak * 100 / Region.nSize;
+		for (u8 nWarnPercent : WarnPercentages)
+		{
+			if (nPercent >= nWarnPercent && Region.nWarnedPercent < nWarnPercent)
+			{
+				LOGWARN("%s stack is %d%% full (%d of %d bytes)", Region.pName, nPercent, Region.nPeak, Region.nSize);
+				Region.nWarnedPercent = nWarnPercent;
+			}
+		}
+	}
+}
+
+void CStackMonitor::Dump() const
+{
+	LOGNOTE("Stack high-water marks:");
+
+	for (const TStackRegion& Region : m_Regions)
+	{
+		if (Region.pName)
+			LOGNOTE("%s: %d of %d bytes (%d%%)", Region.pName, Region.nPeak, Region.nSize, Region.nPeak * 100 / Region.nSize);
+	}
+}
+
+size_t CStackMonitor::AddTask(const char* pName, const CTask* pTask)
+{
+	// Scheduler tasks are cooperative and all run on the main core, so nothing else touches the task regions meanwhile
+	size_t nIndex = CORES;
+	while (nIndex < RegionCount && m_Regions[nIndex].pName)
+		++nIndex;
+
+	if (nIndex == RegionCount)
+	{
+		LOGWARN("Too many tasks; \"%s\" stack not monitored", pName);
+		return RegionCount;
+	}
+
+	// The whole allocation is measured; everything below the current frame is still unused
+	const uintptr nStackPointer = reinterpret_cast<uintptr>(__builtin_frame_address(0));
+	const uintptr nBottom       = reinterpret_cast<uintptr>(pTask->GetStackBase());
+	const uintptr nTop          = nBottom + pTask->GetStackSize();
+
+	// Don't touch memory we aren't sure is ours
+	if (!nBottom || nStackPointer <= nBottom + PaintMargin || nStackPointer > nTop)
+	{
+		LOGWARN("\"%s\" stack pointer %p outside its stack; not monitored", pName, nStackPointer);
+		return RegionCount;
+	}
+
+	EnterCritical(FIQ_LEVEL);
+	Paint(nBottom, nStackPointer - PaintMargin);
+	LeaveCritical();
+
+	TStackRegion& Region = m_Regions[nIndex];
+	Region.nBottom        = nBottom;
+	Region.nSize          = nTop - nBottom;
+	Region.nPaintedSize   = nStackPointer - PaintMargin - nBottom;
+	Region.nPeak          = 0;
+	Region.nWarnedPercent = 0;
+	Region.pName          = pName;
+
+	return nIndex;
+}
+
+void CStackMonitor::RemoveTask(size_t nIndex)
+{
+	// Stack memory is freed with the task
+	m_Regions[nIndex].pName = nullptr;
+}
+
+void CStackMonitor::Paint(uintptr nStart, uintptr nEnd)
+{
+	u32* pWord = reinterpret_cast<u32*>((nStart + 3) & ~static_cast<uintptr>(3));
+	u32* const pEnd = reinterpret_cast<u32*>(nEnd & ~static_cast<uintptr>(3));
+
+	while (pWord < pEnd)
+		*pWord++ = StackPaintPattern;
+}
+
+size_t CStackMonitor::Measure(const TStackRegion& Region)
+{
+	// Stacks grow downwards; count untouched words from the bottom
+	const volatile u32* pWord = reinterpret_cast<const volatile u32*>((Region.nBottom + 3) & ~static_cast<uintptr>(3));
+	const volatile u32* const pEnd = reinterpret_cast<const volatile u32*>(Region.nBottom + Region.nPaintedSize);
+
+	while (pWord < pEnd && *pWord == StackPaintPattern)
+		++pWord;
+
+	return Region.nSize - (reinterpret_cast<uintptr>(pWord) - Region.nBottom);
+}
@@ -0,0 +1,201 @@
+//
+// lightreverb.cpp
+//
+// mt32-pi - A baremetal MIDI synthesizer for Raspberry Pi
+// Copyright (C) 2020-2023 Dale Whinham <daleyo@gmail.com>
+//
+// This file is part of mt32-pi.
+//
+// mt32-pi is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// mt32-pi is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// mt32-pi. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <cstring>
+
+#include "synth/lightreverb.h"
+#include "utility.h"
+
+// Freeverb tunings at 44.1kHz; the right channel is offset to decorrelate it from the left
+constexpr u16 CombTunings[]    = { 1116, 1188, 1277, 1356 };
+constexpr u16 AllpassTunings[] = { 556, 441 };
+constexpr u16 StereoSpread     = 23;
+
+constexpr float ScaleRoom      = 0.28f;
+constexpr float OffsetRoom     = 0.7f;
+constexpr float ScaleDamping   = 0.4f;
+constexpr float ScaleWet       = 3.0f;
+constexpr float AllpassFeedback = 0.5f;
+
+// Half as many combs as Freeverb, so twice its fixed input gain
+constexpr float FixedGain      = 0.03f;
+
+// There are no per-channel sends on the final mix; assume the GM default CC 91 value on every channel
+constexpr float DefaultSend    = 40.0f / 127.0f;
+
+namespace
+{
+	inline float ToFloat(float nSample) { return nSample; }
+	inline float ToFloat(s16 nSample) { return nSample / 32768.0f; }
+
+	inline void MixInto(float& nOut, float nValue) { nOut += nValue; }
+	inline void MixInto(s16& nOut, float nValue) { nOut = Utility::Clamp(static_cast<s32>(nOut + nValue * 32768.0f), -32768, 32767); }
+}
+
+CLightReverb::CLightReverb()
+	: m_Parameters{},
+	  m_pMemory(nullptr),
+	  m_Delays{},
+	  m_CombStates{},
+	  m_nFeedback(0),
+	  m_nDamping(0),
+	  m_nInputGain(0),
+	  m_nWet1(0),
+	  m_nWet2(0)
+{
+}
+
+CLightReverb::~CLightReverb()
+{
+	delete[] m_pMemory;
+}
+
+bool CLightReverb::Initialize(unsigned int nSampleRate)
+{
+	size_t nOffset = 0;
+	size_t nDelay = 0;
+
+	for (size_t nChannel = 0; nChannel < 2; ++nChannel)
+	{
+		const size_t nSpread = nChannel ? StereoSpread : 0;
+
+		for (u16 nTuning : CombTunings)
+		{
+			const size_t nLength = static_cast<size_t>(nTuning + nSpread) * nSampleRate / 44100;
+			m_Delays[nDelay++] = TDelay{nOffset, nLength, 0};
+			nOffset += nLength;
+		}
+
+		for (u16 nTuning : AllpassTunings)
+		{
+			const size_t nLength = static_cast<size_t>(nTuning + nSpread) * nSampleRate / 44100;
+			m_Delays[nDelay++] = TDelay{nOffset, nLength, 0};
+			nOffset += nLength;
+		}
+	}
+
+	m_pMemory = new u8[nOffset * sizeof(float)];
+	if (!m_pMemory)
+		return false;
+
+	Clear();
+	return true;
+}
+
+void CLightReverb::SetParameters(const TParameters& Parameters)
+{
+	m_Parameters = Parameters;
+
+	m_nFeedback  = Parameters.nRoomSize * ScaleRoom + OffsetRoom;
+	m_nDamping   = Parameters.nDamping * ScaleDamping;
+	m_nInputGain = FixedGain * DefaultSend;
+
+	const float nWet = Parameters.nLevel * ScaleWet;
+	m_nWet1 = nWet * (Parameters.nWidth / 2.0f + 0.5f);
+	m_nWet2 = nWet * ((1.0f - Parameters.nWidth) / 2.0f);
+}
+
+void CLightReverb::Clear()
+{
+	if (!m_pMemory)
+		return;
+
+	const TDelay& Last = m_Delays[DelayCount - 1];
+	memset(m_pMemory, 0, (Last.nOffset + Last.nLength) * sizeof(float));
+
+	for (TDelay& Delay : m_Delays)
+		Delay.nIndex = 0;
+
+	memset(m_CombStates, 0, sizeof(m_CombStates));
+}
+
+void CLightReverb::Process(float* pBuffer, size_t nFrames)
+{
+	if (!m_Parameters.bEnabled || !m_pMemory)
+		return;
+
+	ProcessSamples(pBuffer, nFrames);
+}
+
+void CLightReverb::Process(s16* pBuffer, size_t nFrames)
+{
+	if (!m_Parameters.bEnabled || !m_pMemory)
+		return;
+
+	ProcessSamples(pBuffer, nFrames);
+}
+
+template <class TSample>
+void CLightReverb::ProcessSamples(TSample* pBuffer, size_t nFrames)
+{
+	float* const pDelayMemory = reinterpret_cast<float*>(m_pMemory);
+	const float nFeedback = m_nFeedback;
+	const float nDamping1 = m_nDamping;
+	const float nDamping2 = 1.0f - m_nDamping;
+
+	for (size_t i = 0; i < nFrames; ++i)
+	{
+		const float nInput = (ToFloat(pBuffer[i * 2]) + ToFloat(pBuffer[i * 2 + 1])) * m_nInputGain;
+		float Outputs[2];
+
+		for (size_t nChannel = 0; nChannel < 2; ++nChannel)
+		{
+			TDelay* const pDelays = m_Delays + nChannel * (CombCount + AllpassCount);
+			float* const pStates = m_CombStates[nChannel];
+			float nOutput = 0.0f;
+
+			// Parallel lowpass-feedback combs
+			for (size_t nComb = 0; nComb < CombCount; ++nComb)
+			{
+				TDelay& Delay = pDelays[nComb];
+				float& nSample = pDelayMemory[Delay.nOffset + Delay.nIndex];
+
+				const float nDelayed = nSample;
+				pStates[nComb] = nDelayed * nDamping2 + pStates[nComb] * nDamping1;
+				nSample = nInput + pStates[nComb] * nFeedback;
+				nOutput += nDelayed;
+
+				if (++Delay.nIndex == Delay.nLength)
+					Delay.nIndex = 0;
+			}
+
+			// Series allpasses
+			for (size_t nAllpass = 0; nAllpass < AllpassCount; ++nAllpass)
+			{
+				TDelay& Delay = pDelays[CombCount + nAllpass];
+				float& nSample = pDelayMemory[Delay.nOffset + Delay.nIndex];
+
+				const float nDelayed = nSample;
+				nSample = nOutput + nDelayed * AllpassFeedback;
+				nOutput = nDelayed - nOutput;
+
+				if (++Delay.nIndex == Delay.nLength)
+					Delay.nIndex = 0;
+			}
+
+			Outputs[nChannel] = nOutput;
+		}
+
+		MixInto(pBuffer[i * 2],     Outputs[0] * m_nWet1 + Outputs[1] * m_nWet2);
+		MixInto(pBuffer[i * 2 + 1], Outputs[1] * m_nWet1 + Outputs[0] * m_nWet2);
+	}
+}
@@ -36,6 +36,7 @@ constexpr size_t ROMOffsetVersionStringNew  = 0x2206;
 constexpr u32 MemoryAddressMIDIChannels     = 0x4000D;
 constexpr u32 MemoryAddressMasterVolume     = 0x40016;
 
+// Upper bound for counting sounding partials; mt32emu defaults to 32
 // SysEx commands for setting MIDI channel assignment (no SysEx framing, just 3-byte address and 9 channel values)
 const u8 CMT32Synth::StandardMIDIChannelsSysEx[] = { 0x10, 0x00, 0x0D, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09 };
 const u8 CMT32Synth::AlternateMIDIChannelsSysEx[] = { 0x10, 0x00, 0x0D, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x09 };
@@ -44,18 +45,29 @@ CMT32Synth::CMT32Synth(unsigned nSampleRate, float nGain, float nReverbGain, TRe
 	: CSynthBase(nSampleRate),
 
 	  m_pSynth(nullptr),
+	  m_pStandbySynth(nullptr),
 
 	  m_nGain(nGain),
 	  m_nReverbGain(nReverbGain),
 
 	  m_ResamplerQuality(ResamplerQuality),
 	  m_pSampleRateConverter(nullptr),
+	  m_pStandbySampleRateConverter(nullptr),
 
 	  m_CurrentROMSet(TMT32ROMSet::Any),
 	  m_pControlROMImage(nullptr),
-	  m_pPCMROMImage(nullptr),
 
-	  m_LCDTextBuffer{'\0'}
+	  m_bStandbyReady(false),
+	  m_StandbyROMSet(TMT32ROMSet::Any),
+	  m_pStandbyControlROMImage(nullptr),
+
+	  m_LCDTextBuffer{'\0'},
+	  m_bNarrowPartStateText(false),
+
+	  m_Status{},
+	  m_bStatusDetailRequested(true),
+	  m_bCountPartials(false),
+	  m_PartialStates{}
 {
 }
 
@@ -66,6 +78,12 @@ CMT32Synth::~CMT32Synth()
 
 	if (m_pSampleRateConverter)
 		delete m_pSampleRateConverter;
+
+	if (m_pStandbySampleRateConverter)
+		delete m_pStandbySampleRateConverter;
+
+	if (m_pStandbySynth)
+		delete m_pStandbySynth;
 }
 
 bool CMT32Synth::Initialize()
@@ -78,46 +96,53 @@ bool CMT32Synth::Initialize()
 	if (!m_ROMManager.HaveROMSet(InitialROMSet))
 		InitialROMSet = TMT32ROMSet::Any;
 
-	if (!m_ROMManager.GetROMSet(InitialROMSet, m_CurrentROMSet, m_pControlROMImage, m_pPCMROMImage))
+	const MT32Emu::ROMImage* pPCMROMImage;
+	if (!m_ROMManager.GetROMSet(InitialROMSet, m_CurrentROMSet, m_pControlROMImage, pPCMROMImage))
 		return false;
 
 	m_pSynth = new MT32Emu::Synth(this);
 
-	if (!m_pSynth->open(*m_pControlROMImage, *m_pPCMROMImage))
+	const bool bOpened = m_pSynth->open(*m_pControlROMImage, *pPCMROMImage);
+	m_ROMManager.ReleasePCMROMs();
+	if (!bOpened)
 		return false;
 
 	m_pSynth->setOutputGain(m_nGain);
 	m_pSynth->setReverbOutputGain(m_nReverbGain);
+	m_pSampleRateConverter = CreateSampleRateConverter(*m_pSynth);
 
-	if (m_ResamplerQuality != TResamplerQuality::None)
+	return true;
+}
+
+MT32Emu::SampleRateConverter* CMT32Synth::CreateSampleRateConverter(MT32Emu::Synth& Synth) const
+{
+	if (m_ResamplerQuality == TResamplerQuality::None)
+		return nullptr;
+
+	auto quality = MT32Emu::SamplerateConversionQuality_GOOD;
+	switch (m_ResamplerQuality)
 	{
-		auto quality = MT32Emu::SamplerateConversionQuality_GOOD;
-		switch (m_ResamplerQuality)
-		{
-			case TResamplerQuality::Fastest:
-				quality = MT32Emu::SamplerateConversionQuality_FASTEST;
-				break;
-
-			case TResamplerQuality::Fast:
-				quality = MT32Emu::SamplerateConversionQuality_FAST;
-				break;
-
-			case TResamplerQuality::Good:
-				quality = MT32Emu::SamplerateConversionQuality_GOOD;
-				break;
-
-			case TResamplerQuality::Best:
-				quality = MT32Emu::SamplerateConversionQuality_BEST;
-				break;
-
-			default:
-				break;
-		}
-
-		m_pSampleRateConverter = new MT32Emu::SampleRateConverter(*m_pSynth, m_nSampleRate, quality);
+		case TResamplerQuality::Fastest:
+			quality = MT32Emu::SamplerateConversionQuality_FASTEST;
+			break;
+
+		case TResamplerQuality::Fast:
+			quality = MT32Emu::SamplerateConversionQuality_FAST;
+			break;
+
+		case TResamplerQuality::Good:
+			quality = MT32Emu::SamplerateConversionQuality_GOOD;
+			break;
+
+		case TResamplerQuality::Best:
+			quality = MT32Emu::SamplerateConversionQuality_BEST;
+			break;
+
+		default:
+			break;
 	}
 
-	return true;
+	return new MT32Emu::SampleRateConverter(Synth, m_nSampleRate, quality);
 }
 
 void CMT32Synth::HandleMIDIShortMessage(u32 nMessage)
@@ -143,6 +168,19 @@ void CMT32Synth::AllSoundOff()
 	CSynthBase::AllSoundOff();
 }
 
+void CMT32Synth::Reset()
+{
+	// A write to the reset address reinitializes all parameters, as on power-up
+	const u8 ResetSysEx[] = { 0x7F, 0x00, 0x00, 0x00 };
+
+	m_Lock.Acquire();
+	m_pSynth->writeSysex(0x10, ResetSysEx, sizeof(ResetSysEx));
+	m_Lock.Release();
+
+	// Reset MIDI monitor
+	CSynthBase::AllSoundOff();
+}
+
 void CMT32Synth::SetMasterVolume(u8 nVolume)
 {
 	const u8 SetVolumeSysEx[] = { 0x10, 0x00, 0x16, nVolume };
@@ -156,6 +194,7 @@ size_t CMT32Synth::Render(s16* pOutBuffer, size_t nFrames)
 		m_pSampleRateConverter->getOutputSamples(pOutBuffer, nFrames);
 	else
 		m_pSynth->render(pOutBuffer, nFrames);
+	PublishStatus();
 	m_Lock.Release();
 
 	return nFrames;
@@ -168,24 +207,59 @@ size_t CMT32Synth::Render(float* pOutBuffer, size_t nFrames)
 		m_pSampleRateConverter->getOutputSamples(pOutBuffer, nFrames);
 	else
 		m_pSynth->render(pOutBuffer, nFrames);
+	PublishStatus();
 	m_Lock.Release();
 
 	return nFrames;
 }
 
+void CMT32Synth::PublishStatus()
+{
+	// Cheap enough for every chunk; the main core polls the active flag
+	m_Status.bActive = m_pSynth->isActive();
+	m_pSynth->readMemory(MemoryAddressMasterVolume, 1, &m_Status.nMasterVolume);
+
+	// Only the UI reads these, at most once per frame
+	if (m_bStatusDetailRequested)
+	{
+		m_bStatusDetailRequested = false;
+
+		m_pSynth->readMemory(MemoryAddressMIDIChannels, MT32ChannelCount, m_Status.MIDIChannelPartMap);
+
+		bool PartStates[MT32ChannelCount];
+		m_pSynth->getPartStates(PartStates);
+		m_Status.nPartStates = 0;
+		for (size_t i = 0; i < MT32ChannelCount; ++i)
+			m_Status.nPartStates |= PartStates[i] << i;
+
+		m_pSynth->getDisplayState(m_Status.DisplayText, m_bNarrowPartStateText);
+	}
+
+	// getPartialStates() fills in one entry per configured partial
+	m_Status.nActiveVoices = 0;
+	const u32 nPartials = m_pSynth->getPartialCount();
+	if (m_bCountPartials && nPartials <= MaxPartials)
+	{
+		m_pSynth->getPartialStates(m_PartialStates);
+		for (u32 i = 0; i < nPartials; ++i)
+			m_Status.nActiveVoices += m_PartialStates[i] != MT32Emu::PartialState_INACTIVE;
+	}
+
+	m_StatusSnapshot.Publish(m_Status);
+}
+
 void CMT32Synth::ReportStatus() const
 {
 	if (m_pUI)
 		m_pUI->ShowSystemMessage(GetControlROMName());
 }
 
-void CMT32Synth::UpdateLCD(CLCD& LCD, unsigned int nTicks)
+void CMT32Synth::GetLCDLayout(const CLCD& LCD, u8& nStatusRow, u8& nBarHeight, bool& bNarrowPartStateText)
 {
-	bool bNarrowPartStateText = false;
-
 	const u8 nWidth = LCD.Width();
 	const u8 nHeight = LCD.Height();
-	u8 nStatusRow, nBarHeight;
+
+	bNarrowPartStateText = false;
 
 	if (LCD.GetType() == CLCD::TType::Character)
 	{
@@ -201,18 +275,49 @@ void CMT32Synth::UpdateLCD(CLCD& LCD, unsigned int nTicks)
 		nStatusRow = nHeight / 16 - 1;
 		nBarHeight = nHeight - 16;
 	}
+}
+
+u8 CMT32Synth::UpdateLCDState(const CLCD& LCD, unsigned int nTicks)
+{
+	u8 nStatusRow, nBarHeight;
+	bool bNarrowPartStateText;
+	GetLCDLayout(LCD, nStatusRow, nBarHeight, bNarrowPartStateText);
+
+	// Picked up by the audio core from the next chunk onwards
+	m_bNarrowPartStateText = bNarrowPartStateText;
+
+	const TSynthStatus Status = GetStatus();
 
-	float PartLevels[9], PartPeaks[9];
-	GetPartLevels(nTicks, PartLevels, PartPeaks);
-	CUserInterface::DrawChannelLevels(LCD, nBarHeight, PartLevels, PartPeaks, 9, false);
+	// Picked up by the audio core with the next chunk, in time for the next frame
+	m_bStatusDetailRequested = true;
 
-	m_pSynth->getDisplayState(m_LCDTextBuffer, bNarrowPartStateText);
+	GetPartLevels(nTicks, Status.MIDIChannelPartMap, m_LCDLevels, m_LCDPeaks);
+	u8 nDamage = UpdateLCDLevels(LCD, nBarHeight, MT32ChannelCount);
+
+	char Buffer[LCDTextBufferSize];
+	memcpy(Buffer, Status.DisplayText, sizeof(Buffer));
 
 	// Remap active part indicator character
-	for (size_t i = 0; i < Utility::ArraySize(m_LCDTextBuffer) - 1; ++i)
-		if (m_LCDTextBuffer[i] == 1)
-			m_LCDTextBuffer[i] = '\xFF';
+	for (size_t i = 0; i < Utility::ArraySize(Buffer) - 1; ++i)
+		if (Buffer[i] == 1)
+			Buffer[i] = '\xFF';
+
+	if (memcmp(Buffer, m_LCDTextBuffer, sizeof(Buffer)) != 0)
+	{
+		memcpy(m_LCDTextBuffer, Buffer, sizeof(Buffer));
+		nDamage |= CUserInterface::WidgetStatusLine;
+	}
+
+	return nDamage;
+}
+
+void CMT32Synth::UpdateLCD(CLCD& LCD, unsigned int nTicks)
+{
+	u8 nStatusRow, nBarHeight;
+	bool bNarrowPartStateText;
+	GetLCDLayout(LCD, nStatusRow, nBarHeight, bNarrowPartStateText);
 
+	CUserInterface::DrawChannelLevels(LCD, nBarHeight, m_LCDLevels, m_LCDPeaks, MT32ChannelCount, false);
 	LCD.Print(m_LCDTextBuffer, 0, nStatusRow, true, false);
 }
 
@@ -226,9 +331,6 @@ void CMT32Synth::SetMIDIChannels(TMIDIChannels Channels)
 
 bool CMT32Synth::SwitchROMSet(TMT32ROMSet ROMSet)
 {
-	const MT32Emu::ROMImage* pControlROMImage;
-	const MT32Emu::ROMImage* pPCMROMImage;
-
 	// Is this ROM set already active?
 	if (ROMSet == m_CurrentROMSet)
 	{
@@ -237,28 +339,96 @@ bool CMT32Synth::SwitchROMSet(TMT32ROMSet ROMSet)
 		return false;
 	}
 
-	// Get ROM set if available
-	if (!m_ROMManager.GetROMSet(ROMSet, m_CurrentROMSet, pControlROMImage, pPCMROMImage))
+	if (!PrepareROMSet(ROMSet))
 	{
 		if (m_pUI)
 			m_pUI->ShowSystemMessage("ROM set not avail!");
 		return false;
 	}
 
-	// Reopen synth with new ROMs
+	return CommitROMSet();
+}
+
+bool CMT32Synth::PrepareROMSet(TMT32ROMSet ROMSet)
+{
+	TMT32ROMSet NewROMSet;
+	const MT32Emu::ROMImage* pControlROMImage;
+	const MT32Emu::ROMImage* pPCMROMImage;
+
+	// Get ROM set if available
+	if (!m_ROMManager.GetROMSet(ROMSet, NewROMSet, pControlROMImage, pPCMROMImage))
+		return false;
+
+	if (m_bStandbyReady && NewROMSet == m_StandbyROMSet)
+	{
+		m_ROMManager.ReleasePCMROMs();
+		return true;
+	}
+
+	DiscardStandby();
+
+	// Open a second synth with the new ROMs while the current one keeps rendering
+	if (!m_pStandbySynth)
+		m_pStandbySynth = new MT32Emu::Synth(this);
+
+	const bool bOpened = m_pStandbySynth->open(*pControlROMImage, *pPCMROMImage);
+	m_ROMManager.ReleasePCMROMs();
+	if (!bOpened)
+	{
+		LOGERR("Failed to open standby synth");
+		return false;
+	}
+
+	m_pStandbySynth->setOutputGain(m_nGain);
+	m_pStandbySynth->setReverbOutputGain(m_nReverbGain);
+	m_pStandbySynth->setReversedStereoEnabled(m_pSynth->isReversedStereoEnabled());
+	m_pStandbySampleRateConverter = CreateSampleRateConverter(*m_pStandbySynth);
+
+	m_StandbyROMSet           = NewROMSet;
+	m_pStandbyControlROMImage = pControlROMImage;
+	m_bStandbyReady           = true;
+
+	return true;
+}
+
+bool CMT32Synth::CommitROMSet()
+{
+	if (!m_bStandbyReady)
+		return false;
+
+	// Swap between rendered chunks
 	m_Lock.Acquire();
-	m_pSynth->close();
-	assert(m_pSynth->open(*pControlROMImage, *pPCMROMImage));
-	m_pSynth->setOutputGain(m_nGain);
-	m_pSynth->setReverbOutputGain(m_nReverbGain);
+	Utility::Swap(m_pSynth, m_pStandbySynth);
+	Utility::Swap(m_pSampleRateConverter, m_pStandbySampleRateConverter);
 	m_Lock.Release();
 
-	m_pControlROMImage = pControlROMImage;
-	m_pPCMROMImage     = pPCMROMImage;
+	m_CurrentROMSet    = m_StandbyROMSet;
+	m_pControlROMImage = m_pStandbyControlROMImage;
+
+	// Old synth becomes the standby; free its memory until it's needed again
+	DiscardStandby();
+
+	// Notes held on the old synth are gone
+	m_MIDIMonitor.AllNotesOff();
+	m_MIDIMonitor.ResetControllers(false);
 
 	return true;
 }
 
+void CMT32Synth::DiscardStandby()
+{
+	if (m_pStandbySampleRateConverter)
+	{
+		delete m_pStandbySampleRateConverter;
+		m_pStandbySampleRateConverter = nullptr;
+	}
+
+	if (m_pStandbySynth)
+		m_pStandbySynth->close();
+
+	m_bStandbyReady = false;
+}
+
 TMT32ROMSet CMT32Synth::GetROMSet() const
 {
 	return m_CurrentROMSet;
@@ -304,20 +474,15 @@ const char* CMT32Synth::GetControlROMName() const
 
 u8 CMT32Synth::GetMasterVolume() const
 {
-	u8 nVolume;
-	m_pSynth->readMemory(MemoryAddressMasterVolume, 1, &nVolume);
-	return nVolume;
+	return GetStatus().nMasterVolume;
 }
 
-void CMT32Synth::GetPartLevels(unsigned int nTicks, float PartLevels[9], float PartPeaks[9])
+void CMT32Synth::GetPartLevels(unsigned int nTicks, const u8 MIDIChannelPartMap[9], float PartLevels[9], float PartPeaks[9])
 {
 	float ChannelLevels[16], ChannelPeaks[16];
-	u8 MIDIChannelPartMap[9];
-	u16 nPercussionMask;
 
-	// Find which MIDI channels each MT-32 part is mapped to and identify percussion channel
-	m_pSynth->readMemory(MemoryAddressMIDIChannels, 9, MIDIChannelPartMap);
-	nPercussionMask = 1 << MIDIChannelPartMap[8];
+	// Identify percussion channel from the MIDI channel each MT-32 part is mapped to
+	const u16 nPercussionMask = 1 << MIDIChannelPartMap[8];
 
 	// Map channel levels to part levels
 	m_MIDIMonitor.GetChannelLevels(nTicks, ChannelLevels, ChannelPeaks, nPercussionMask);
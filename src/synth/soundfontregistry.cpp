@@ -0,0 +1,310 @@
+//
+// soundfontregistry.cpp
+//
+// mt32-pi - A baremetal MIDI synthesizer for Raspberry Pi
+// Copyright (C) 2020-2023 Dale Whinham <daleyo@gmail.com>
+//
+// This file is part of mt32-pi.
+//
+// mt32-pi is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// mt32-pi is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// mt32-pi. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <circle/logger.h>
+#include <fatfs/ff.h>
+
+#include "synth/soundfontregistry.h"
+
+LOGMODULE("soundfontregistry");
+
+// Voice group IDs for notes started through wrapped presets; kept well clear of FluidSynth's own note IDs
+constexpr unsigned int FirstVoiceGroup = 0x80000000;
+
+CSoundFontRegistry* CSoundFontRegistry::s_pThis = nullptr;
+
+CSoundFontRegistry::CSoundFontRegistry()
+	: m_pSettings(nullptr),
+	  m_Entries{},
+	  m_nNextVoiceGroup(FirstVoiceGroup)
+{
+	s_pThis = this;
+}
+
+CSoundFontRegistry::~CSoundFontRegistry()
+{
+	for (TEntry& Entry : m_Entries)
+	{
+		if (Entry.pOwnerSynth)
+			delete_fluid_synth(Entry.pOwnerSynth);
+	}
+
+	if (m_pSettings)
+		delete_fluid_settings(m_pSettings);
+
+	s_pThis = nullptr;
+}
+
+bool CSoundFontRegistry::Initialize(unsigned int nSampleRate)
+{
+	// SoundFont synth init is retried when ROMs or SoundFonts arrive later
+	if (m_pSettings)
+		return true;
+
+	m_pSettings = new_fluid_settings();
+	if (!m_pSettings)
+		return false;
+
+	// Owner synths never play; keep their own allocations as small as possible
+	fluid_settings_setnum(m_pSettings, "synth.sample-rate", static_cast<double>(nSampleRate));
+	fluid_settings_setint(m_pSettings, "synth.polyphony", 1);
+	fluid_settings_setint(m_pSettings, "synth.reverb.active", false);
+	fluid_settings_setint(m_pSettings, "synth.chorus.active", false);
+	fluid_settings_setint(m_pSettings, "synth.threadsafe-api", false);
+
+	return true;
+}
+
+void CSoundFontRegistry::AddLoader(fluid_synth_t* pSynth)
+{
+	if (!m_pSettings)
+		return;
+
+	// Tried before FluidSynth's default loader; if it fails, the default loader makes a private copy
+	fluid_sfloader_t* pLoader = new_fluid_sfloader(LoadCallback, delete_fluid_sfloader);
+	if (!pLoader)
+		return;
+
+	fluid_sfloader_set_data(pLoader, this);
+	fluid_synth_add_sfloader(pSynth, pLoader);
+}
+
+size_t CSoundFontRegistry::GetSharedCount() const
+{
+	size_t nCount = 0;
+	for (const TEntry& Entry : m_Entries)
+	{
+		if (Entry.nRefCount)
+			++nCount;
+	}
+
+	return nCount;
+}
+
+CSoundFontRegistry::TEntry* CSoundFontRegistry::Acquire(const char* pPath)
+{
+	// Size and timestamp catch a file replaced since it was loaded (e.g. uploaded over MIDI)
+	FILINFO FileInfo;
+	if (f_stat(pPath, &FileInfo) != FR_OK)
+		return nullptr;
+
+	const u32 nFileSize = FileInfo.fsize;
+	const u32 nFileTimestamp = FileInfo.fdate << 16 | FileInfo.ftime;
+	TEntry* pFreeEntry = nullptr;
+
+	for (TEntry& Entry : m_Entries)
+	{
+		if (!Entry.nRefCount)
+		{
+			if (!pFreeEntry)
+				pFreeEntry = &Entry;
+			continue;
+		}
+
+		if (Entry.Path.Compare(pPath) == 0 && Entry.nFileSize == nFileSize && Entry.nFileTimestamp == nFileTimestamp)
+		{
+			++Entry.nRefCount;
+			LOGNOTE("Sharing \"%s\" (%d users)", pPath, Entry.nRefCount);
+			return &Entry;
+		}
+	}
+
+	if (!pFreeEntry)
+	{
+		LOGWARN("Registry full; \"%s\" will not be shared", pPath);
+		return nullptr;
+	}
+
+	fluid_synth_t* pOwnerSynth = new_fluid_synth(m_pSettings);
+	if (!pOwnerSynth)
+	{
+		LOGERR("Failed to create owner synth");
+		return nullptr;
+	}
+
+	// Don't select presets on the owner's channels; only wrapper presets are ever selected
+	const int nSoundFontID = fluid_synth_sfload(pOwnerSynth, pPath, false);
+	if (nSoundFontID == FLUID_FAILED)
+	{
+		delete_fluid_synth(pOwnerSynth);
+		return nullptr;
+	}
+
+	fluid_sfont_t* pSoundFont = fluid_synth_get_sfont_by_id(pOwnerSynth, nSoundFontID);
+	size_t nPresetCount = 0;
+	fluid_sfont_iteration_start(pSoundFont);
+	while (fluid_sfont_iteration_next(pSoundFont))
+		++nPresetCount;
+
+	pFreeEntry->pRegistry = this;
+	pFreeEntry->Path = pPath;
+	pFreeEntry->nFileSize = nFileSize;
+	pFreeEntry->nFileTimestamp = nFileTimestamp;
+	pFreeEntry->pOwnerSynth = pOwnerSynth;
+	pFreeEntry->pSoundFont = pSoundFont;
+	pFreeEntry->nPresetCount = nPresetCount;
+	pFreeEntry->nRefCount = 1;
+
+	return pFreeEntry;
+}
+
+void CSoundFontRegistry::Release(TEntry* pEntry)
+{
+	if (!pEntry->nRefCount || --pEntry->nRefCount)
+		return;
+
+	// We can't use fluid_synth_sfunload() as we don't support the lazy SoundFont unload timer, so trash the owner synth;
+	// delete_fluid_synth() frees its SoundFont there and then, and no channel or voice can still refer to it because
+	// the last wrapper is only freed once its synth has let go of its presets and voices
+	delete_fluid_synth(pEntry->pOwnerSynth);
+	LOGNOTE("Unloaded \"%s\"", static_cast<const char*>(pEntry->Path));
+
+	pEntry->Path = "";
+	pEntry->pOwnerSynth = nullptr;
+	pEntry->pSoundFont = nullptr;
+	pEntry->nPresetCount = 0;
+}
+
+fluid_sfont_t* CSoundFontRegistry::LoadCallback(fluid_sfloader_t* pLoader, const char* pPath)
+{
+	CSoundFontRegistry* pThis = static_cast<CSoundFontRegistry*>(fluid_sfloader_get_data(pLoader));
+
+	TEntry* pEntry = pThis->Acquire(pPath);
+	if (!pEntry)
+		return nullptr;
+
+	// Each synth needs its own SoundFont and preset objects for its IDs and reference counts; the
+	// preset tables and samples behind them are the shared ones
+	fluid_sfont_t* pWrapperSoundFont = new_fluid_sfont(GetNameCallback, GetPresetCallback, IterationStartCallback, IterationNextCallback, FreeCallback);
+	if (!pWrapperSoundFont)
+	{
+		pThis->Release(pEntry);
+		return nullptr;
+	}
+
+	TWrapper* pWrapper = new TWrapper{pEntry, new fluid_preset_t*[pEntry->nPresetCount], 0, 0};
+	fluid_sfont_set_data(pWrapperSoundFont, pWrapper);
+
+	fluid_sfont_iteration_start(pEntry->pSoundFont);
+	while (pWrapper->nPresetCount < pEntry->nPresetCount)
+	{
+		fluid_preset_t* pSharedPreset = fluid_sfont_iteration_next(pEntry->pSoundFont);
+		if (!pSharedPreset)
+			break;
+
+		fluid_preset_t* pPreset = new_fluid_preset(pWrapperSoundFont, GetPresetNameCallback, GetPresetBankCallback, GetPresetNumberCallback, PresetNoteOnCallback, delete_fluid_preset);
+		if (!pPreset)
+		{
+			FreeCallback(pWrapperSoundFont);
+			return nullptr;
+		}
+
+		fluid_preset_set_data(pPreset, pSharedPreset);
+		pWrapper->pPresets[pWrapper->nPresetCount++] = pPreset;
+	}
+
+	return pWrapperSoundFont;
+}
+
+const char* CSoundFontRegistry::GetNameCallback(fluid_sfont_t* pSoundFont)
+{
+	const TWrapper* pWrapper = static_cast<const TWrapper*>(fluid_sfont_get_data(pSoundFont));
+	return fluid_sfont_get_name(pWrapper->pEntry->pSoundFont);
+}
+
+fluid_preset_t* CSoundFontRegistry::GetPresetCallback(fluid_sfont_t* pSoundFont, int nBank, int nProgram)
+{
+	const TWrapper* pWrapper = static_cast<const TWrapper*>(fluid_sfont_get_data(pSoundFont));
+	const fluid_preset_t* pSharedPreset = fluid_sfont_get_preset(pWrapper->pEntry->pSoundFont, nBank, nProgram);
+	if (!pSharedPreset)
+		return nullptr;
+
+	// Only called on program/bank changes, so a linear search is fine
+	for (size_t i = 0; i < pWrapper->nPresetCount; ++i)
+	{
+		if (fluid_preset_get_data(pWrapper->pPresets[i]) == pSharedPreset)
+			return pWrapper->pPresets[i];
+	}
+
+	return nullptr;
+}
+
+void CSoundFontRegistry::IterationStartCallback(fluid_sfont_t* pSoundFont)
+{
+	TWrapper* pWrapper = static_cast<TWrapper*>(fluid_sfont_get_data(pSoundFont));
+	pWrapper->nIterationIndex = 0;
+}
+
+fluid_preset_t* CSoundFontRegistry::IterationNextCallback(fluid_sfont_t* pSoundFont)
+{
+	TWrapper* pWrapper = static_cast<TWrapper*>(fluid_sfont_get_data(pSoundFont));
+	if (pWrapper->nIterationIndex >= pWrapper->nPresetCount)
+		return nullptr;
+
+	return pWrapper->pPresets[pWrapper->nIterationIndex++];
+}
+
+int CSoundFontRegistry::FreeCallback(fluid_sfont_t* pSoundFont)
+{
+	TWrapper* pWrapper = static_cast<TWrapper*>(fluid_sfont_get_data(pSoundFont));
+	TEntry* pEntry = pWrapper->pEntry;
+
+	// FluidSynth never frees presets itself; they belong to their SoundFont
+	for (size_t i = 0; i < pWrapper->nPresetCount; ++i)
+		delete_fluid_preset(pWrapper->pPresets[i]);
+
+	delete[] pWrapper->pPresets;
+	delete pWrapper;
+	delete_fluid_sfont(pSoundFont);
+
+	pEntry->pRegistry->Release(pEntry);
+	return 0;
+}
+
+const char* CSoundFontRegistry::GetPresetNameCallback(fluid_preset_t* pPreset)
+{
+	return fluid_preset_get_name(static_cast<fluid_preset_t*>(fluid_preset_get_data(pPreset)));
+}
+
+int CSoundFontRegistry::GetPresetBankCallback(fluid_preset_t* pPreset)
+{
+	return fluid_preset_get_banknum(static_cast<fluid_preset_t*>(fluid_preset_get_data(pPreset)));
+}
+
+int CSoundFontRegistry::GetPresetNumberCallback(fluid_preset_t* pPreset)
+{
+	return fluid_preset_get_num(static_cast<fluid_preset_t*>(fluid_preset_get_data(pPreset)));
+}
+
+int CSoundFontRegistry::PresetNoteOnCallback(fluid_preset_t* pPreset, fluid_synth_t* pSynth, int nChannel, int nKey, int nVelocity)
+{
+	// Starts the shared preset's voices on the calling synth; the voices' channel still has the wrapper selected.
+	// One ID per note-on keeps exclusive class handling from cutting off voices started by the same note.
+	fluid_preset_t* pSharedPreset = static_cast<fluid_preset_t*>(fluid_preset_get_data(pPreset));
+	const TWrapper* pWrapper = static_cast<const TWrapper*>(fluid_sfont_get_data(fluid_preset_get_sfont(pPreset)));
+	CSoundFontRegistry* pThis = pWrapper->pEntry->pRegistry;
+	const unsigned int nVoiceGroup = pThis->m_nNextVoiceGroup++;
+	if (pThis->m_nNextVoiceGroup < FirstVoiceGroup)
+		pThis->m_nNextVoiceGroup = FirstVoiceGroup;
+
+	return fluid_synth_start(pSynth, nVoiceGroup, pSharedPreset, 0, nChannel, nKey, nVelocity);
+}
@@ -28,6 +28,7 @@
 #include "lcd/ui.h"
 #include "synth/gmsysex.h"
 #include "synth/rolandsysex.h"
+#include "synth/soundfontregistry.h"
 #include "synth/soundfontsynth.h"
 #include "synth/yamahasysex.h"
 #include "utility.h"
@@ -36,6 +37,38 @@
 LOGMODULE("soundfontsynth");
 const char SoundFontPath[] = "soundfonts";
 
+// Adaptive interpolation methods for melodic and percussion channels at each quality level
+// The top level matches FluidSynth's default so that adaptive mode never costs more; drums are short and rarely exposed, so they drop first
+constexpr int InterpolationLevels[TInterpolationStats::LevelCount][2] =
+{
+	{ FLUID_INTERP_4THORDER, FLUID_INTERP_4THORDER },
+	{ FLUID_INTERP_4THORDER, FLUID_INTERP_LINEAR   },
+	{ FLUID_INTERP_LINEAR,   FLUID_INTERP_LINEAR   },
+};
+constexpr const char* InterpolationLevelNames[TInterpolationStats::LevelCount] = { "4th order", "4th order/linear", "linear" };
+
+// Render load (percent of chunk playback time) hysteresis band; lowering quality is quick, raising it needs sustained headroom
+constexpr u8 InterpolationDowngradeLoad           = 75;
+constexpr u8 InterpolationUpgradeLoad             = 40;
+constexpr unsigned InterpolationDowngradeHoldMillis = 250;
+constexpr unsigned InterpolationUpgradeHoldMillis   = 2000;
+
+// Controllers FluidSynth acts on directly rather than only through modulators; these are never deferred
+// (bank select, breath, portamento, data entry, pedals, legato, (N)RPN and channel mode messages)
+constexpr u32 DirectControllers[4] = { 0x00000065, 0x00000061, 0x0010003F, 0xFF00003F };
+
+// Controller sources of every default modulator FluidSynth 2.3 adds to each voice (see fluid_synth_init()): modulation
+// wheel, volume, balance, pan, expression, reverb and chorus send. Any other controller that FluidSynth doesn't act on
+// directly can only be heard through a SoundFont modulator.
+constexpr u8 DefaultModulatorControllers[] = { 1, 7, 8, 10, 11, 91, 93 };
+
+constexpr u8 ResetAllControllers = 121;
+
+inline bool IsControllerInMask(const u32 Mask[4], u8 nController)
+{
+	return Mask[nController / 32] & (1u << (nController % 32));
+}
+
 extern "C"
 {
 	// Replacements for fluid_sys.c functions
@@ -134,12 +167,46 @@ CSoundFontSynth::CSoundFontSynth(unsigned nSampleRate)
 
 	  m_pSettings(nullptr),
 	  m_pSynth(nullptr),
+	  m_pStandbySynth(nullptr),
 
 	  m_nVolume(100),
 	  m_nInitialGain(0.2f),
 
 	  m_nPercussionMask(1 << 9),
-	  m_nCurrentSoundFontIndex(0)
+	  m_nCurrentSoundFontIndex(0),
+
+	  m_bStandbyIsCurrent(false),
+	  m_nStandbySoundFontIndex(0),
+	  m_nStandbyInitialGain(0.2f),
+	  m_StandbyReverbParameters{},
+
+	  m_bEffectsStatsResetRequested(false),
+	  m_EffectsStats{},
+
+	  m_pVoiceList(nullptr),
+	  m_pVoiceTable(nullptr),
+	  m_nVoiceTableMask(0),
+	  m_nVoiceStatsChunk(0),
+	  m_nTotalLifetime(0),
+	  m_bVoiceStatsResetRequested(false),
+	  m_VoiceStats{},
+
+	  m_InterpolationMode(TInterpolation::Adaptive),
+	  m_bInterpolationApplied(false),
+	  m_nInterpolationPercussionMask(0),
+	  m_nAppliedInterpolationLevel(0),
+	  m_nInterpolationChangeTime(0),
+	  m_nInterpolationHeadroomTime(0),
+	  m_bInterpolationStatsResetRequested(false),
+	  m_InterpolationStats{},
+
+	  m_bControllerFastPath(true),
+	  m_ModulatedControllers{},
+	  m_StandbyModulatedControllers{},
+	  m_nPendingControllerChannels(0),
+	  m_ChannelControllers{},
+	  m_bControllerStatsResetRequested(false),
+	  m_ControllerStats{}
 {
 }
 
@@ -148,8 +215,14 @@ CSoundFontSynth::~CSoundFontSynth()
 	if (m_pSynth)
 		delete_fluid_synth(m_pSynth);
 
+	if (m_pStandbySynth)
+		delete_fluid_synth(m_pStandbySynth);
+
 	if (m_pSettings)
 		delete_fluid_settings(m_pSettings);
+
+	delete[] m_pVoiceList;
+	delete[] m_pVoiceTable;
 }
 
 void CSoundFontSynth::FluidSynthLogCallback(int nLevel, const char* pMessage, void* pUser)
@@ -180,6 +253,21 @@ bool CSoundFontSynth::Initialize()
 		return false;
 
 	TFXProfile FXProfile = m_SoundFontManager.GetSoundFontFXProfile(m_nCurrentSoundFontIndex);
+	m_InterpolationMode = pConfig->FluidSynthInterpolation;
+	m_bControllerFastPath = pConfig->FluidSynthControllerFastPath;
+
+	if (pConfig->FluidSynthVoiceStats)
+	{
+		// Open-addressed table at most half full, so a free entry is always found
+		size_t nTableSize = 1;
+		while (nTableSize < static_cast<size_t>(pConfig->FluidSynthPolyphony) * 2)
+			nTableSize <<= 1;
+
+		m_pVoiceList = new fluid_voice_t*[pConfig->FluidSynthPolyphony];
+		m_pVoiceTable = new TTrackedVoice[nTableSize];
+		m_nVoiceTableMask = nTableSize - 1;
+		m_VoiceStats.nPolyphony = pConfig->FluidSynthPolyphony;
+	}
 
 	// Install logging handlers
 	fluid_set_log_function(FLUID_PANIC, FluidSynthLogCallback, this);
@@ -200,6 +288,9 @@ bool CSoundFontSynth::Initialize()
 	fluid_settings_setnum(m_pSettings, "synth.sample-rate", static_cast<double>(m_nSampleRate));
 	fluid_settings_setint(m_pSettings, "synth.threadsafe-api", false);
 
+	if (!m_LightReverb.Initialize(m_nSampleRate))
+		LOGWARN("Couldn't allocate light reverb; it will be unavailable");
+
 	return Reinitialize(pSoundFontPath, &FXProfile);
 }
 
@@ -215,14 +306,35 @@ void CSoundFontSynth::HandleMIDIShortMessage(u32 nMessage)
 	{
 		m_Lock.Acquire();
 		fluid_synth_system_reset(m_pSynth);
+		m_bInterpolationApplied = false;
+		ClearControllers();
 		m_Lock.Release();
 		return;
 	}
 
+	const u8 nType = nStatus & 0xF0;
+	const bool bController = nType == 0xB0 || nType == 0xD0 || nType == 0xE0;
+
 	m_Lock.Acquire();
 
+	if (bController)
+		++m_ControllerStats.nReceived;
+
+	if (bController && m_bControllerFastPath && DeferController(nType, nChannel, nData1, nData2))
+	{
+		m_Lock.Release();
+		CSynthBase::HandleMIDIShortMessage(nMessage);
+		return;
+	}
+
+	// Anything else on this channel must see the deferred controller values first
+	if (m_nPendingControllerChannels & (1 << nChannel))
+		FlushControllers(nChannel);
+
+	const unsigned int nStartTime = bController ? CTimer::GetClockTicks() : 0;
+
 	// Handle channel messages
-	switch (nStatus & 0xF0)
+	switch (nType)
 	{
 		// Note off
 		case 0x80:
@@ -260,6 +372,16 @@ void CSoundFontSynth::HandleMIDIShortMessage(u32 nMessage)
 			break;
 	}
 
+	if (bController)
+	{
+		// Values FluidSynth holds are no longer known after a reset
+		if (nType == 0xB0 && nData1 == ResetAllControllers)
+			InvalidateControllers(nChannel);
+
+		++m_ControllerStats.nApplied;
+		m_ControllerStats.nControlMicros += CTimer::GetClockTicks() - nStartTime;
+	}
+
 	m_Lock.Release();
 
 	// Update MIDI monitor
@@ -274,17 +396,13 @@ void CSoundFontSynth::HandleMIDISysExMessage(const u8* pData, size_t nSize)
 
 	// No special handling; forward to FluidSynth SysEx parser, excluding leading 0xF0 and trailing 0xF7
 	m_Lock.Acquire();
+	FlushControllers();
 	fluid_synth_sysex(m_pSynth, reinterpret_cast<const char*>(pData + 1), nSize - 2, nullptr, nullptr, nullptr, false);
-	m_Lock.Release();
-}
 
-bool CSoundFontSynth::IsActive()
-{
-	m_Lock.Acquire();
-	int nVoices = fluid_synth_get_active_voice_count(m_pSynth);
+	// GM/GS/XG resets and part parameters may have changed controller values
+	for (u8 nChannel = 0; nChannel < 16; ++nChannel)
+		InvalidateControllers(nChannel);
 	m_Lock.Release();
-
-	return nVoices > 0;
 }
 
 void CSoundFontSynth::AllSoundOff()
@@ -297,6 +415,19 @@ void CSoundFontSynth::AllSoundOff()
 	CSynthBase::AllSoundOff();
 }
 
+void CSoundFontSynth::Reset()
+{
+	m_Lock.Acquire();
+	fluid_synth_system_reset(m_pSynth);
+	fluid_synth_set_polyphony(m_pSynth, CConfig::Get()->FluidSynthPolyphony);
+	m_InterpolationMode = CConfig::Get()->FluidSynthInterpolation;
+	m_bControllerFastPath = CConfig::Get()->FluidSynthControllerFastPath;
+	ResetMIDIMonitor();
+	ClearVoiceTable();
+	ClearControllers();
+	m_Lock.Release();
+}
+
 void CSoundFontSynth::SetMasterVolume(u8 nVolume)
 {
 	m_nVolume = nVolume;
@@ -308,7 +439,20 @@ void CSoundFontSynth::SetMasterVolume(u8 nVolume)
 size_t CSoundFontSynth::Render(float* pOutBuffer, size_t nFrames)
 {
 	m_Lock.Acquire();
+	FlushControllers();
+	const unsigned int nStartTime = CTimer::GetClockTicks();
 	assert(fluid_synth_write_float(m_pSynth, nFrames, pOutBuffer, 0, 2, pOutBuffer, 1, 2) == FLUID_OK);
+	UpdateInterpolation(CTimer::GetClockTicks() - nStartTime, nFrames);
+	if (m_LightReverb.IsEnabled())
+	{
+		const unsigned int nReverbStartTime = CTimer::GetClockTicks();
+		m_LightReverb.Process(pOutBuffer, nFrames);
+		UpdateEffectsStats(CTimer::GetClockTicks() - nReverbStartTime, nFrames);
+	}
+	if (m_pVoiceTable)
+		UpdateVoiceStats();
+	UpdateControllerStats();
+	PublishStatus();
 	m_Lock.Release();
 	return nFrames;
 }
@@ -316,26 +460,55 @@ size_t CSoundFontSynth::Render(float* pOutBuffer, size_t nFrames)
 size_t CSoundFontSynth::Render(s16* pOutBuffer, size_t nFrames)
 {
 	m_Lock.Acquire();
+	FlushControllers();
+	const unsigned int nStartTime = CTimer::GetClockTicks();
 	assert(fluid_synth_write_s16(m_pSynth, nFrames, pOutBuffer, 0, 2, pOutBuffer, 1, 2) == FLUID_OK);
+	UpdateInterpolation(CTimer::GetClockTicks() - nStartTime, nFrames);
+	if (m_LightReverb.IsEnabled())
+	{
+		const unsigned int nReverbStartTime = CTimer::GetClockTicks();
+		m_LightReverb.Process(pOutBuffer, nFrames);
+		UpdateEffectsStats(CTimer::GetClockTicks() - nReverbStartTime, nFrames);
+	}
+	if (m_pVoiceTable)
+		UpdateVoiceStats();
+	UpdateControllerStats();
+	PublishStatus();
 	m_Lock.Release();
 	return nFrames;
 }
 
+void CSoundFontSynth::PublishStatus()
+{
+	TSynthStatus Status{};
+
+	const int nVoices = fluid_synth_get_active_voice_count(m_pSynth);
+	Status.bActive = nVoices > 0;
+	Status.nActiveVoices = nVoices;
+	Status.nMasterVolume = m_nVolume;
+
+	m_StatusSnapshot.Publish(Status);
+}
+
 void CSoundFontSynth::ReportStatus() const
 {
-	if (m_pUI)
-		m_pUI->ShowSystemMessage(m_SoundFontManager.GetSoundFontName(m_nCurrentSoundFontIndex));
+	const char* pName = m_SoundFontManager.GetSoundFontName(m_nCurrentSoundFontIndex);
+	if (m_pUI && pName)
+		m_pUI->ShowSystemMessage(pName);
+}
+
+u8 CSoundFontSynth::UpdateLCDState(const CLCD& LCD, unsigned int nTicks)
+{
+	m_MIDIMonitor.GetChannelLevels(nTicks, m_LCDLevels, m_LCDPeaks, m_nPercussionMask);
+	return UpdateLCDLevels(LCD, LCD.Height(), 16);
 }
 
 void CSoundFontSynth::UpdateLCD(CLCD& LCD, unsigned int nTicks)
 {
-	const u8 nBarHeight = LCD.Height();
-	float ChannelLevels[16], PeakLevels[16];
-	m_MIDIMonitor.GetChannelLevels(nTicks, ChannelLevels, PeakLevels, m_nPercussionMask);
-	CUserInterface::DrawChannelLevels(LCD, nBarHeight, ChannelLevels, PeakLevels, 16, true);
+	CUserInterface::DrawChannelLevels(LCD, LCD.Height(), m_LCDLevels, m_LCDPeaks, 16, true);
 }
 
-bool CSoundFontSynth::SwitchSoundFont(size_t nIndex)
+bool CSoundFontSynth::SwitchSoundFont(size_t nIndex, const TFXProfile* pFXOverrides)
 {
 	// Is this SoundFont already active?
 	if (m_nCurrentSoundFontIndex == nIndex)
@@ -358,6 +531,8 @@ bool CSoundFontSynth::SwitchSoundFont(size_t nIndex)
 		m_pUI->ShowSystemMessage("Loading SoundFont", true);
 
 	TFXProfile FXProfile = m_SoundFontManager.GetSoundFontFXProfile(nIndex);
+	if (pFXOverrides)
+		FXProfile.Merge(*pFXOverrides);
 
 	// We can't use fluid_synth_sfunload() as we don't support the lazy SoundFont unload timer, so trash the entire synth and create a new one
 	if (!Reinitialize(pSoundFontPath, &FXProfile))
@@ -379,39 +554,24 @@ bool CSoundFontSynth::SwitchSoundFont(size_t nIndex)
 
 bool CSoundFontSynth::Reinitialize(const char* pSoundFontPath, const TFXProfile* pFXProfile)
 {
-	const CConfig* const pConfig = CConfig::Get();
+	u32 ModulatedControllers[4];
+	GetModulatedControllers(pSoundFontPath, ModulatedControllers);
 
 	m_Lock.Acquire();
 
 	if (m_pSynth)
 		delete_fluid_synth(m_pSynth);
 
-	m_pSynth = new_fluid_synth(m_pSettings);
+	CLightReverb::TParameters ReverbParameters;
+	m_pSynth = CreateSynth(pFXProfile, m_nInitialGain, ReverbParameters);
 
 	if (!m_pSynth)
 	{
 		m_Lock.Release();
-		LOGERR("Failed to create synth");
 		return false;
 	}
 
-	fluid_synth_set_polyphony(m_pSynth, pConfig->FluidSynthPolyphony);
-
-	m_nInitialGain = pFXProfile->nGain.ValueOr(pConfig->FluidSynthDefaultGain);
-	fluid_synth_set_gain(m_pSynth, m_nVolume / 100.0f * m_nInitialGain);
-
-	// Use values from effects profile if set, otherwise use defaults
-	fluid_synth_reverb_on(m_pSynth, -1, pFXProfile->bReverbActive.ValueOr(pConfig->FluidSynthDefaultReverbActive));
-	fluid_synth_set_reverb_group_damp(m_pSynth, -1, pFXProfile->nReverbDamping.ValueOr(pConfig->FluidSynthDefaultReverbDamping));
-	fluid_synth_set_reverb_group_level(m_pSynth, -1, pFXProfile->nReverbLevel.ValueOr(pConfig->FluidSynthDefaultReverbLevel));
-	fluid_synth_set_reverb_group_roomsize(m_pSynth, -1, pFXProfile->nReverbRoomSize.ValueOr(pConfig->FluidSynthDefaultReverbRoomSize));
-	fluid_synth_set_reverb_group_width(m_pSynth, -1, pFXProfile->nReverbWidth.ValueOr(pConfig->FluidSynthDefaultReverbWidth));
-
-	fluid_synth_chorus_on(m_pSynth, -1, pFXProfile->bChorusActive.ValueOr(pConfig->FluidSynthDefaultChorusActive));
-	fluid_synth_set_chorus_group_depth(m_pSynth, -1, pFXProfile->nChorusDepth.ValueOr(pConfig->FluidSynthDefaultChorusDepth));
-	fluid_synth_set_chorus_group_level(m_pSynth, -1, pFXProfile->nChorusLevel.ValueOr(pConfig->FluidSynthDefaultChorusLevel));
-	fluid_synth_set_chorus_group_nr(m_pSynth, -1, pFXProfile->nChorusVoices.ValueOr(pConfig->FluidSynthDefaultChorusVoices));
-	fluid_synth_set_chorus_group_speed(m_pSynth, -1, pFXProfile->nChorusSpeed.ValueOr(pConfig->FluidSynthDefaultChorusSpeed));
+	m_LightReverb.SetParameters(ReverbParameters);
 
 #ifndef NDEBUG
 	DumpFXSettings();
@@ -419,11 +579,80 @@ bool CSoundFontSynth::Reinitialize(const char* pSoundFontPath, const TFXProfile*
 
 	ResetMIDIMonitor();
 
+	// Voice pointers belong to the old synth
+	ClearVoiceTable();
+
+	memcpy(m_ModulatedControllers, ModulatedControllers, sizeof(m_ModulatedControllers));
+	ClearControllers();
+
 	m_Lock.Release();
 
+	return LoadSoundFont(m_pSynth, pSoundFontPath);
+}
+
+fluid_synth_t* CSoundFontSynth::CreateSynth(const TFXProfile* pFXProfile, float& nOutInitialGain, CLightReverb::TParameters& OutReverbParameters)
+{
+	fluid_synth_t* pSynth = new_fluid_synth(m_pSettings);
+
+	if (!pSynth)
+	{
+		LOGERR("Failed to create synth");
+		return nullptr;
+	}
+
+	fluid_synth_set_polyphony(pSynth, CConfig::Get()->FluidSynthPolyphony);
+	if (CSoundFontRegistry* pSoundFontRegistry = CSoundFontRegistry::Get())
+		pSoundFontRegistry->AddLoader(pSynth);
+	nOutInitialGain = ApplyFXProfile(pSynth, pFXProfile, OutReverbParameters);
+
+	return pSynth;
+}
+
+float CSoundFontSynth::ApplyFXProfile(fluid_synth_t* pSynth, const TFXProfile* pFXProfile, CLightReverb::TParameters& OutReverbParameters)
+{
+	const CConfig* const pConfig = CConfig::Get();
+
+	const float nInitialGain = pFXProfile->nGain.ValueOr(pConfig->FluidSynthDefaultGain);
+	fluid_synth_set_gain(pSynth, m_nVolume / 100.0f * nInitialGain);
+
+	// Use values from effects profile if set, otherwise use defaults
+	const bool bReverbActive = pFXProfile->bReverbActive.ValueOr(pConfig->FluidSynthDefaultReverbActive);
+	const TReverbEngine ReverbEngine = pFXProfile->ReverbEngine.ValueOr(pConfig->FluidSynthDefaultReverbEngine);
+	const float nReverbDamping = pFXProfile->nReverbDamping.ValueOr(pConfig->FluidSynthDefaultReverbDamping);
+	const float nReverbLevel = pFXProfile->nReverbLevel.ValueOr(pConfig->FluidSynthDefaultReverbLevel);
+	const float nReverbRoomSize = pFXProfile->nReverbRoomSize.ValueOr(pConfig->FluidSynthDefaultReverbRoomSize);
+	const float nReverbWidth = pFXProfile->nReverbWidth.ValueOr(pConfig->FluidSynthDefaultReverbWidth);
+
+	fluid_synth_reverb_on(pSynth, -1, bReverbActive && ReverbEngine == TReverbEngine::FluidSynth);
+	fluid_synth_set_reverb_group_damp(pSynth, -1, nReverbDamping);
+	fluid_synth_set_reverb_group_level(pSynth, -1, nReverbLevel);
+	fluid_synth_set_reverb_group_roomsize(pSynth, -1, nReverbRoomSize);
+	fluid_synth_set_reverb_group_width(pSynth, -1, nReverbWidth);
+
+	OutReverbParameters.bEnabled    = bReverbActive && ReverbEngine != TReverbEngine::FluidSynth;
+	OutReverbParameters.nRoomSize   = nReverbRoomSize;
+	OutReverbParameters.nDamping    = nReverbDamping;
+	OutReverbParameters.nWidth      = nReverbWidth;
+	OutReverbParameters.nLevel      = nReverbLevel;
+
+	// The light chorus is FluidSynth's chorus with a single voice
+	const TChorusEngine ChorusEngine = pFXProfile->ChorusEngine.ValueOr(pConfig->FluidSynthDefaultChorusEngine);
+	const int nChorusVoices = ChorusEngine == TChorusEngine::Light ? 1 : pFXProfile->nChorusVoices.ValueOr(pConfig->FluidSynthDefaultChorusVoices);
+
+	fluid_synth_chorus_on(pSynth, -1, pFXProfile->bChorusActive.ValueOr(pConfig->FluidSynthDefaultChorusActive));
+	fluid_synth_set_chorus_group_depth(pSynth, -1, pFXProfile->nChorusDepth.ValueOr(pConfig->FluidSynthDefaultChorusDepth));
+	fluid_synth_set_chorus_group_level(pSynth, -1, pFXProfile->nChorusLevel.ValueOr(pConfig->FluidSynthDefaultChorusLevel));
+	fluid_synth_set_chorus_group_nr(pSynth, -1, nChorusVoices);
+	fluid_synth_set_chorus_group_speed(pSynth, -1, pFXProfile->nChorusSpeed.ValueOr(pConfig->FluidSynthDefaultChorusSpeed));
+
+	return nInitialGain;
+}
+
+bool CSoundFontSynth::LoadSoundFont(fluid_synth_t* pSynth, const char* pSoundFontPath)
+{
 	const unsigned int nLoadStart = CTimer::GetClockTicks();
 
-	if (fluid_synth_sfload(m_pSynth, pSoundFontPath, true) == FLUID_FAILED)
+	if (fluid_synth_sfload(pSynth, pSoundFontPath, true) == FLUID_FAILED)
 	{
 		LOGERR("Failed to load SoundFont");
 		return false;
@@ -435,11 +664,616 @@ bool CSoundFontSynth::Reinitialize(const char* pSoundFontPath, const TFXProfile*
 	return true;
 }
 
+bool CSoundFontSynth::RescanSoundFonts()
+{
+	const char* pCurrentPath = m_SoundFontManager.GetSoundFontPath(m_nCurrentSoundFontIndex);
+	const CString CurrentPath(pCurrentPath ? pCurrentPath : "");
+
+	// Standby index refers to the old list
+	DiscardStandby();
+
+	const bool bResult = m_SoundFontManager.ScanSoundFonts();
+
+	m_nCurrentSoundFontIndex = NoSoundFontIndex;
+	for (size_t i = 0; i < m_SoundFontManager.GetSoundFontCount(); ++i)
+	{
+		if (!strcmp(m_SoundFontManager.GetSoundFontPath(i), CurrentPath))
+		{
+			m_nCurrentSoundFontIndex = i;
+			break;
+		}
+	}
+
+	return bResult;
+}
+
+bool CSoundFontSynth::PrepareSoundFont(size_t nIndex, const TFXProfile* pFXOverrides)
+{
+	DiscardStandby();
+
+	const char* pSoundFontPath = m_SoundFontManager.GetSoundFontPath(nIndex);
+	if (!pSoundFontPath)
+		return false;
+
+	// SoundFont's own effects profile, with any overrides on top
+	TFXProfile FXProfile = m_SoundFontManager.GetSoundFontFXProfile(nIndex);
+	if (pFXOverrides)
+		FXProfile.Merge(*pFXOverrides);
+
+	m_nStandbySoundFontIndex = nIndex;
+
+	// Same SoundFont; only the effects need to change, which is cheap enough to do at commit time
+	if (nIndex == m_nCurrentSoundFontIndex)
+	{
+		m_StandbyFXProfile = FXProfile;
+		m_bStandbyIsCurrent = true;
+		return true;
+	}
+
+	// Both SoundFonts stay resident until the swap
+	m_pStandbySynth = CreateSynth(&FXProfile, m_nStandbyInitialGain, m_StandbyReverbParameters);
+	if (!m_pStandbySynth)
+		return false;
+
+	if (!LoadSoundFont(m_pStandbySynth, pSoundFontPath))
+	{
+		DiscardStandby();
+		return false;
+	}
+
+	GetModulatedControllers(pSoundFontPath, m_StandbyModulatedControllers);
+
+	return true;
+}
+
+bool CSoundFontSynth::CommitSoundFont()
+{
+	if (m_bStandbyIsCurrent)
+	{
+		CLightReverb::TParameters ReverbParameters;
+		m_Lock.Acquire();
+		m_nInitialGain = ApplyFXProfile(m_pSynth, &m_StandbyFXProfile, ReverbParameters);
+		m_LightReverb.SetParameters(ReverbParameters);
+		m_Lock.Release();
+
+		m_bStandbyIsCurrent = false;
+		return true;
+	}
+
+	if (!m_pStandbySynth)
+		return false;
+
+	// Swap between rendered chunks
+	m_Lock.Acquire();
+	fluid_synth_t* pOldSynth = m_pSynth;
+	m_pSynth = m_pStandbySynth;
+	m_nInitialGain = m_nStandbyInitialGain;
+	m_LightReverb.SetParameters(m_StandbyReverbParameters);
+
+	// Volume may have changed since the standby synth was created
+	fluid_synth_set_gain(m_pSynth, m_nVolume / 100.0f * m_nInitialGain);
+
+	ResetMIDIMonitor();
+
+	// Voice pointers belong to the old synth
+	ClearVoiceTable();
+
+	memcpy(m_ModulatedControllers, m_StandbyModulatedControllers, sizeof(m_ModulatedControllers));
+	ClearControllers();
+	m_Lock.Release();
+
+	m_pStandbySynth = nullptr;
+	m_nCurrentSoundFontIndex = m_nStandbySoundFontIndex;
+
+	// Frees the old SoundFont
+	delete_fluid_synth(pOldSynth);
+
+	LOGNOTE("Loaded \"%s\"", m_SoundFontManager.GetSoundFontName(m_nCurrentSoundFontIndex));
+
+	return true;
+}
+
+void CSoundFontSynth::DiscardStandby()
+{
+	if (m_pStandbySynth)
+	{
+		delete_fluid_synth(m_pStandbySynth);
+		m_pStandbySynth = nullptr;
+	}
+
+	m_bStandbyIsCurrent = false;
+}
+
+void CSoundFontSynth::DumpVoiceStats() const
+{
+	if (!m_pVoiceTable)
+	{
+		LOGNOTE("Voice statistics are disabled");
+		return;
+	}
+
+	TVoiceStats Stats;
+	GetVoiceStats(Stats);
+
+	LOGNOTE("Voices: %d active, %d peak, %d polyphony", Stats.nActiveVoices, Stats.nPeakVoices, Stats.nPolyphony);
+	LOGNOTE("Average voice lifetime: %dms over %d voices", Stats.nAvgLifetimeMillis, Stats.nEndedVoices);
+
+	for (size_t i = 0; i < Utility::ArraySize(Stats.ChannelVoices); ++i)
+	{
+		if (Stats.ChannelVoices[i] || Stats.ChannelSteals[i])
+			LOGNOTE("Channel %d: %d voices, %d stolen", i + 1, Stats.ChannelVoices[i], Stats.ChannelSteals[i]);
+	}
+
+	for (size_t i = 0; i < Stats.nPresets; ++i)
+		LOGNOTE("Bank %d program %d: %d peak voices", Stats.Presets[i].nBank, Stats.Presets[i].nProgram, Stats.Presets[i].nPeakVoices);
+}
+
+void CSoundFontSynth::UpdateVoiceStats()
+{
+	const unsigned int nTicks = CTimer::GetClockTicks();
+	TVoiceStats& Stats = m_VoiceStats;
+
+	if (m_bVoiceStatsResetRequested)
+	{
+		const u16 nPolyphony = Stats.nPolyphony;
+		Stats = TVoiceStats{};
+		Stats.nPolyphony = nPolyphony;
+		m_nTotalLifetime = 0;
+		m_bVoiceStatsResetRequested = false;
+	}
+
+	++m_nVoiceStatsChunk;
+
+	const int nVoices = fluid_synth_get_voicelist(m_pSynth, m_pVoiceList, Stats.nPolyphony, -1);
+
+	for (auto& nCount : Stats.ChannelVoices)
+		nCount = 0;
+
+	for (int i = 0; i < nVoices; ++i)
+	{
+		const fluid_voice_t* pVoice = m_pVoiceList[i];
+		const unsigned int nID = fluid_voice_get_id(pVoice);
+		const u8 nChannel = fluid_voice_get_channel(pVoice) & 0x0F;
+		TTrackedVoice* pTracked = FindTrackedVoice(pVoice);
+
+		// Slot reused by a new voice
+		if (pTracked->bActive && pTracked->nID != nID)
+		{
+			// The old voice was killed before its note was released; most likely stolen
+			if (pTracked->bOn)
+				++Stats.ChannelSteals[pTracked->nChannel];
+
+			EndTrackedVoice(*pTracked, nTicks);
+		}
+
+		if (!pTracked->bActive)
+		{
+			pTracked->nID = nID;
+			pTracked->nStartTime = nTicks;
+			pTracked->nChannel = nChannel;
+			pTracked->bActive = true;
+		}
+
+		pTracked->bOn = fluid_voice_is_on(pVoice);
+		pTracked->nLastSeenChunk = m_nVoiceStatsChunk;
+		++Stats.ChannelVoices[nChannel];
+	}
+
+	// Voices no longer playing
+	for (size_t i = 0; i <= m_nVoiceTableMask; ++i)
+	{
+		TTrackedVoice& Tracked = m_pVoiceTable[i];
+		if (Tracked.bActive && Tracked.nLastSeenChunk != m_nVoiceStatsChunk)
+			EndTrackedVoice(Tracked, nTicks);
+	}
+
+	Stats.nActiveVoices = nVoices;
+	Stats.nPeakVoices = Utility::Max(Stats.nPeakVoices, Stats.nActiveVoices);
+	Stats.nAvgLifetimeMillis = Stats.nEndedVoices ? Utility::TicksToMillis(m_nTotalLifetime / Stats.nEndedVoices) : 0;
+
+	// Attribute each channel's voices to its current preset
+	u16 PresetVoices[TVoiceStats::MaxPresets] = {0};
+	for (u8 nChannel = 0; nChannel < Utility::ArraySize(Stats.ChannelVoices); ++nChannel)
+	{
+		if (!Stats.ChannelVoices[nChannel])
+			continue;
+
+		int nSoundFontID, nBank, nProgram;
+		if (fluid_synth_get_program(m_pSynth, nChannel, &nSoundFontID, &nBank, &nProgram) != FLUID_OK)
+			continue;
+
+		size_t nIndex = 0;
+		while (nIndex < Stats.nPresets && (Stats.Presets[nIndex].nBank != nBank || Stats.Presets[nIndex].nProgram != nProgram))
+			++nIndex;
+
+		// Not seen before; add it, or replace the least busy preset not playing in this chunk
+		if (nIndex == Stats.nPresets)
+		{
+			if (Stats.nPresets < TVoiceStats::MaxPresets)
+				++Stats.nPresets;
+			else
+			{
+				nIndex = 0;
+				for (size_t i = 1; i < Stats.nPresets; ++i)
+				{
+					if (!PresetVoices[i] && (PresetVoices[nIndex] || Stats.Presets[i].nPeakVoices < Stats.Presets[nIndex].nPeakVoices))
+						nIndex = i;
+				}
+			}
+
+			Stats.Presets[nIndex] = TVoiceStats::TPresetPeak{static_cast<u16>(nBank), static_cast<u8>(nProgram), 0};
+		}
+
+		PresetVoices[nIndex] += Stats.ChannelVoices[nChannel];
+		Stats.Presets[nIndex].nPeakVoices = Utility::Max(Stats.Presets[nIndex].nPeakVoices, PresetVoices[nIndex]);
+	}
+
+	m_VoiceStatsSnapshot.Publish(Stats);
+}
+
+void CSoundFontSynth::ClearVoiceTable()
+{
+	if (!m_pVoiceTable)
+		return;
+
+	for (size_t i = 0; i <= m_nVoiceTableMask; ++i)
+		m_pVoiceTable[i] = TTrackedVoice{};
+}
+
+CSoundFontSynth::TTrackedVoice* CSoundFontSynth::FindTrackedVoice(const fluid_voice_t* pVoice)
+{
+	// Voice slots are never freed, so entries are never deleted and probing always ends at the slot or an empty entry
+	size_t nIndex = (reinterpret_cast<uintptr>(pVoice) >> 4) & m_nVoiceTableMask;
+	while (m_pVoiceTable[nIndex].pVoice && m_pVoiceTable[nIndex].pVoice != pVoice)
+		nIndex = (nIndex + 1) & m_nVoiceTableMask;
+
+	m_pVoiceTable[nIndex].pVoice = pVoice;
+	return &m_pVoiceTable[nIndex];
+}
+
+void CSoundFontSynth::EndTrackedVoice(TTrackedVoice& Voice, unsigned int nTicks)
+{
+	m_nTotalLifetime += nTicks - Voice.nStartTime;
+	++m_VoiceStats.nEndedVoices;
+	Voice.bActive = false;
+}
+
 void CSoundFontSynth::ResetMIDIMonitor()
 {
 	m_MIDIMonitor.AllNotesOff();
 	m_MIDIMonitor.ResetControllers(false);
 	m_nPercussionMask = 1 << 9;
+
+	// Channels come back with FluidSynth's default interpolation
+	m_bInterpolationApplied = false;
+}
+
+void CSoundFontSynth::UpdateInterpolation(unsigned int nRenderMicros, size_t nFrames)
+{
+	TInterpolationStats& Stats = m_InterpolationStats;
+	const unsigned int nTicks = CTimer::GetClockTicks();
+
+	if (m_bInterpolationStatsResetRequested)
+	{
+		const u8 nLevel = Stats.nLevel;
+		Stats = TInterpolationStats{};
+		Stats.nLevel = nLevel;
+		m_bInterpolationStatsResetRequested = false;
+	}
+
+	if (m_InterpolationMode == TInterpolation::Adaptive && nFrames)
+	{
+		// Render time as a percentage of the time the chunk takes to play
+		const u64 nLoad = static_cast<u64>(nRenderMicros) * m_nSampleRate * 100 / (static_cast<u64>(Utility::MillisToTicks(1000u)) * nFrames);
+		Stats.nLoad = Utility::Min(nLoad, static_cast<u64>(UINT8_MAX));
+
+		u8 nNewLevel = Stats.nLevel;
+		if (Stats.nLoad >= InterpolationDowngradeLoad)
+		{
+			// New methods only apply to new voices, so give the last change time to take effect
+			if (nNewLevel + 1u < TInterpolationStats::LevelCount && nTicks - m_nInterpolationChangeTime >= Utility::MillisToTicks(InterpolationDowngradeHoldMillis))
+				++nNewLevel;
+			m_nInterpolationHeadroomTime = nTicks;
+		}
+		else if (Stats.nLoad >= InterpolationUpgradeLoad)
+			m_nInterpolationHeadroomTime = nTicks;
+		else if (nNewLevel > 0 && nTicks - m_nInterpolationHeadroomTime >= Utility::MillisToTicks(InterpolationUpgradeHoldMillis))
+		{
+			--nNewLevel;
+			m_nInterpolationHeadroomTime = nTicks;
+		}
+
+		if (nNewLevel != Stats.nLevel)
+		{
+			Stats.nLevel = nNewLevel;
+			++Stats.nLevelChanges;
+			m_nInterpolationChangeTime = nTicks;
+		}
+
+		++Stats.LevelChunks[Stats.nLevel];
+	}
+
+	if (!m_bInterpolationApplied || m_nAppliedInterpolationLevel != Stats.nLevel || m_nInterpolationPercussionMask != m_nPercussionMask)
+		ApplyInterpolation();
+
+	m_InterpolationStatsSnapshot.Publish(Stats);
+}
+
+void CSoundFontSynth::ApplyInterpolation()
+{
+	const u8 nLevel = m_InterpolationStats.nLevel;
+
+	switch (m_InterpolationMode)
+	{
+		case TInterpolation::Adaptive:
+			for (u8 nChannel = 0; nChannel < 16; ++nChannel)
+			{
+				const bool bPercussion = (m_nPercussionMask >> nChannel) & 1;
+				fluid_synth_set_interp_method(m_pSynth, nChannel, InterpolationLevels[nLevel][bPercussion]);
+			}
+			break;
+
+		case TInterpolation::None:
+			fluid_synth_set_interp_method(m_pSynth, -1, FLUID_INTERP_NONE);
+			break;
+
+		case TInterpolation::Linear:
+			fluid_synth_set_interp_method(m_pSynth, -1, FLUID_INTERP_LINEAR);
+			break;
+
+		case TInterpolation::FourthOrder:
+			fluid_synth_set_interp_method(m_pSynth, -1, FLUID_INTERP_4THORDER);
+			break;
+
+		case TInterpolation::SeventhOrder:
+			fluid_synth_set_interp_method(m_pSynth, -1, FLUID_INTERP_7THORDER);
+			break;
+	}
+
+	m_bInterpolationApplied = true;
+	m_nAppliedInterpolationLevel = nLevel;
+	m_nInterpolationPercussionMask = m_nPercussionMask;
+}
+
+void CSoundFontSynth::UpdateEffectsStats(unsigned int nReverbMicros, size_t nFrames)
+{
+	if (m_bEffectsStatsResetRequested)
+	{
+		m_EffectsStats = TEffectsStats{};
+		m_bEffectsStatsResetRequested = false;
+	}
+
+	m_EffectsStats.nReverbMicros += nReverbMicros;
+	m_EffectsStats.nReverbFrames += nFrames;
+	m_EffectsStatsSnapshot.Publish(m_EffectsStats);
+}
+
+void CSoundFontSynth::DumpEffectsStats() const
+{
+	TEffectsStats Stats;
+	m_EffectsStatsSnapshot.Read(Stats);
+
+	if (!Stats.nReverbFrames)
+	{
+		LOGNOTE("Light reverb has not been used");
+		return;
+	}
+
+	// Processing time per second of audio output
+	const u32 nMicrosPerSecond = Stats.nReverbMicros * m_nSampleRate / Stats.nReverbFrames;
+	LOGNOTE("Light reverb: %dus/s (%d.%02d%% load)", nMicrosPerSecond, nMicrosPerSecond / 10000, nMicrosPerSecond / 100 % 100);
+}
+
+void CSoundFontSynth::GetModulatedControllers(const char* pSoundFontPath, u32 OutControllerMask[4])
+{
+	size_t nModulators;
+	if (!CSoundFontManager::GetModulatorControllers(pSoundFontPath, OutControllerMask, nModulators))
+	{
+		// Couldn't tell; assume any controller may be read, so none are skipped
+		memset(OutControllerMask, 0xFF, sizeof(u32) * 4);
+		return;
+	}
+
+	if (nModulators)
+		LOGNOTE("SoundFont has %d custom modulators", nModulators);
+	else
+		LOGNOTE("SoundFont only uses default modulators");
+
+	for (u8 nController : DefaultModulatorControllers)
+		OutControllerMask[nController / 32] |= 1u << (nController % 32);
+}
+
+bool CSoundFontSynth::DeferController(u8 nType, u8 nChannel, u8 nData1, u8 nData2)
+{
+	TChannelControllers& Channel = m_ChannelControllers[nChannel];
+
+	switch (nType)
+	{
+		case 0xB0:
+		{
+			if (IsControllerInMask(DirectControllers, nData1))
+				return false;
+
+			// FluidSynth would only store it and scan every voice's modulators for nothing
+			if (!IsControllerInMask(m_ModulatedControllers, nData1))
+			{
+				++m_ControllerStats.nUnused;
+				return true;
+			}
+
+			u32& nPendingMask = Channel.PendingMask[nData1 / 32];
+			const u32 nBit = 1u << (nData1 % 32);
+			if (nPendingMask & nBit)
+				++m_ControllerStats.nCoalesced;
+
+			nPendingMask |= nBit;
+			Channel.Values[nData1] = nData2;
+			break;
+		}
+
+		case 0xD0:
+			if (Channel.bPressurePending)
+				++m_ControllerStats.nCoalesced;
+
+			Channel.bPressurePending = true;
+			Channel.nPressure = nData1;
+			break;
+
+		case 0xE0:
+			if (Channel.bPitchBendPending)
+				++m_ControllerStats.nCoalesced;
+
+			Channel.bPitchBendPending = true;
+			Channel.nPitchBend = (nData2 << 7) | nData1;
+			break;
+
+		default:
+			return false;
+	}
+
+	m_nPendingControllerChannels |= 1 << nChannel;
+	return true;
+}
+
+void CSoundFontSynth::FlushControllers(u8 nChannel)
+{
+	TChannelControllers& Channel = m_ChannelControllers[nChannel];
+	TControllerStats& Stats = m_ControllerStats;
+	const unsigned int nStartTime = CTimer::GetClockTicks();
+
+	// Only final values matter, so order between different controllers is irrelevant
+	for (size_t i = 0; i < Utility::ArraySize(Channel.PendingMask); ++i)
+	{
+		u32 nMask = Channel.PendingMask[i];
+		Channel.PendingMask[i] = 0;
+
+		while (nMask)
+		{
+			const u8 nController = i * 32 + __builtin_ctz(nMask);
+			nMask &= nMask - 1;
+
+			const u8 nValue = Channel.Values[nController];
+			if (Channel.AppliedValues[nController] == nValue)
+			{
+				++Stats.nRedundant;
+				continue;
+			}
+
+			fluid_synth_cc(m_pSynth, nChannel, nController, nValue);
+			Channel.AppliedValues[nController] = nValue;
+			++Stats.nApplied;
+		}
+	}
+
+	if (Channel.bPressurePending)
+	{
+		if (Channel.nAppliedPressure == Channel.nPressure)
+			++Stats.nRedundant;
+		else
+		{
+			fluid_synth_channel_pressure(m_pSynth, nChannel, Channel.nPressure);
+			Channel.nAppliedPressure = Channel.nPressure;
+			++Stats.nApplied;
+		}
+
+		Channel.bPressurePending = false;
+	}
+
+	if (Channel.bPitchBendPending)
+	{
+		if (Channel.nAppliedPitchBend == Channel.nPitchBend)
+			++Stats.nRedundant;
+		else
+		{
+			fluid_synth_pitch_bend(m_pSynth, nChannel, Channel.nPitchBend);
+			Channel.nAppliedPitchBend = Channel.nPitchBend;
+			++Stats.nApplied;
+		}
+
+		Channel.bPitchBendPending = false;
+	}
+
+	m_nPendingControllerChannels &= ~(1 << nChannel);
+	Stats.nControlMicros += CTimer::GetClockTicks() - nStartTime;
+}
+
+void CSoundFontSynth::FlushControllers()
+{
+	while (m_nPendingControllerChannels)
+		FlushControllers(__builtin_ctz(m_nPendingControllerChannels));
+}
+
+void CSoundFontSynth::ClearControllers()
+{
+	// Pending values are dropped; they would have been superseded by the reset or belong to the old synth
+	for (u8 nChannel = 0; nChannel < 16; ++nChannel)
+	{
+		TChannelControllers& Channel = m_ChannelControllers[nChannel];
+		memset(Channel.PendingMask, 0, sizeof(Channel.PendingMask));
+		Channel.bPressurePending = false;
+		Channel.bPitchBendPending = false;
+		InvalidateControllers(nChannel);
+	}
+
+	m_nPendingControllerChannels = 0;
+}
+
+void CSoundFontSynth::InvalidateControllers(u8 nChannel)
+{
+	// Out-of-range values, so the next value received is always applied
+	TChannelControllers& Channel = m_ChannelControllers[nChannel];
+	memset(Channel.AppliedValues, 0xFF, sizeof(Channel.AppliedValues));
+	Channel.nAppliedPitchBend = 0xFFFF;
+	Channel.nAppliedPressure = 0xFF;
+}
+
+void CSoundFontSynth::UpdateControllerStats()
+{
+	if (m_bControllerStatsResetRequested)
+	{
+		m_ControllerStats = TControllerStats{};
+		m_bControllerStatsResetRequested = false;
+	}
+
+	m_ControllerStatsSnapshot.Publish(m_ControllerStats);
+}
+
+void CSoundFontSynth::DumpControllerStats() const
+{
+	TControllerStats Stats;
+	m_ControllerStatsSnapshot.Read(Stats);
+
+	LOGNOTE("Controller fast path: %s", m_bControllerFastPath ? "on" : "off");
+	LOGNOTE("Controllers: %d received, %d applied, %d coalesced, %d redundant, %d unused by SoundFont", Stats.nReceived, Stats.nApplied, Stats.nCoalesced, Stats.nRedundant, Stats.nUnused);
+
+	if (Stats.nReceived)
+	{
+		const u32 nNanosPerMessage = Stats.nControlMicros * 1000 / Stats.nReceived;
+		LOGNOTE("Control path: %dus total, %dns per message received", static_cast<u32>(Stats.nControlMicros), nNanosPerMessage);
+	}
+}
+
+void CSoundFontSynth::DumpInterpolationStats() const
+{
+	if (m_InterpolationMode != TInterpolation::Adaptive)
+	{
+		LOGNOTE("Interpolation is fixed; adaptive interpolation is disabled");
+		return;
+	}
+
+	TInterpolationStats Stats;
+	m_InterpolationStatsSnapshot.Read(Stats);
+
+	u32 nTotalChunks = 0;
+	for (u32 nChunks : Stats.LevelChunks)
+		nTotalChunks += nChunks;
+
+	LOGNOTE("Interpolation: %s, render load %d%%, %d changes", InterpolationLevelNames[Stats.nLevel], Stats.nLoad, Stats.nLevelChanges);
+	for (size_t i = 0; i < TInterpolationStats::LevelCount; ++i)
+	{
+		const u32 nPercent = nTotalChunks ? static_cast<u64>(Stats.LevelChunks[i]) * 100 / nTotalChunks : 0;
+		LOGNOTE("%s: %d chunks (%d%%)", InterpolationLevelNames[i], Stats.LevelChunks[i], nPercent);
+	}
 }
 
 #ifndef NDEBUG
@@ -0,0 +1,348 @@
+//
+// sysexfiletransfer.cpp
+//
+// mt32-pi - A baremetal MIDI synthesizer for Raspberry Pi
+// Copyright (C) 2020-2023 Dale Whinham <daleyo@gmail.com>
+//
+// This file is part of mt32-pi.
+//
+// mt32-pi is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// mt32-pi is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// mt32-pi. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <circle/logger.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "sysexfiletransfer.h"
+#include "utility.h"
+
+LOGMODULE("sysexfiletransfer");
+const char* const Volumes[] = { "SD", "USB" };
+const char TempFileSuffix[] = ".part";
+
+CSysExFileTransfer::CSysExFileTransfer()
+	: m_bActive(false),
+	  m_File{},
+	  m_Path{'\0'},
+	  m_TempPath{'\0'},
+
+	  m_nFileSize(0),
+	  m_nReceivedSize(0),
+	  m_nExpectedSequence(0),
+	  m_LastError(TError::None),
+
+	  m_WriteBuffer{0},
+	  m_nWriteBufferSize(0)
+{
+}
+
+CSysExFileTransfer::~CSysExFileTransfer()
+{
+	if (m_bActive)
+		Abort();
+}
+
+CSysExFileTransfer::TResult CSysExFileTransfer::HandleMessage(const u8* pData, size_t nSize, u8* pOutReply, size_t& nOutReplySize)
+{
+	nOutReplySize = 0;
+
+	// F0 7D 07 cc ... F7
+	if (nSize < 5)
+		return TResult::Ignored;
+
+	const auto Command = static_cast<TCommand>(pData[3]);
+	const u8* pPayload = pData + 4;
+	const size_t nPayloadSize = nSize - 5;
+
+	TResult Result;
+	u16 nReplySequence = 0;
+	m_LastError = TError::None;
+
+	switch (Command)
+	{
+		case TCommand::Open:
+			Result = Open(pPayload, nPayloadSize);
+			break;
+
+		case TCommand::Data:
+			if (nPayloadSize < 4)
+			{
+				m_LastError = TError::BadRequest;
+				Result = TResult::Failed;
+				break;
+			}
+
+			nReplySequence = pPayload[0] | pPayload[1] << 7;
+			Result = WriteBlock(nReplySequence, pPayload, nPayloadSize);
+			break;
+
+		case TCommand::Close:
+			Result = Close();
+			break;
+
+		case TCommand::Abort:
+			if (m_bActive)
+			{
+				LOGNOTE("Transfer of '%s' aborted by host", m_Path);
+				Abort();
+				Result = TResult::Aborted;
+			}
+			else
+				Result = TResult::Ignored;
+			break;
+
+		default:
+			return TResult::Ignored;
+	}
+
+	pOutReply[nOutReplySize++] = 0xF0;
+	pOutReply[nOutReplySize++] = 0x7D;
+	pOutReply[nOutReplySize++] = pData[2];
+
+	// Report the sequence number we expect next so that the host can resume from it
+	if (m_LastError != TError::None)
+	{
+		nReplySequence = m_nExpectedSequence;
+		pOutReply[nOutReplySize++] = static_cast<u8>(TCommand::Nak);
+		pOutReply[nOutReplySize++] = static_cast<u8>(Command);
+		pOutReply[nOutReplySize++] = static_cast<u8>(m_LastError);
+	}
+	else
+	{
+		pOutReply[nOutReplySize++] = static_cast<u8>(TCommand::Ack);
+		pOutReply[nOutReplySize++] = static_cast<u8>(Command);
+	}
+
+	pOutReply[nOutReplySize++] = nReplySequence & 0x7F;
+	pOutReply[nOutReplySize++] = (nReplySequence >> 7) & 0x7F;
+	pOutReply[nOutReplySize++] = 0xF7;
+
+	return Result;
+}
+
+u8 CSysExFileTransfer::GetProgressPercent() const
+{
+	return m_nFileSize ? static_cast<u64>(m_nReceivedSize) * 100 / m_nFileSize : 100;
+}
+
+CSysExFileTransfer::TResult CSysExFileTransfer::Open(const u8* pData, size_t nSize)
+{
+	// Volume, 5 size bytes, at least one path character, checksum
+	if (nSize < 8 || nSize - 7 > MaxPathLength)
+	{
+		m_LastError = TError::BadRequest;
+		return TResult::Failed;
+	}
+
+	if (!VerifyChecksum(pData, nSize))
+	{
+		m_LastError = TError::Checksum;
+		return TResult::Failed;
+	}
+
+	const u8 nVolume = pData[0];
+	u64 nFileSize = 0;
+	for (size_t i = 0; i < 5; ++i)
+		nFileSize |= static_cast<u64>(pData[1 + i]) << (7 * i);
+
+	char Path[MaxPathLength + 1];
+	const size_t nPathLength = nSize - 7;
+	memcpy(Path, pData + 6, nPathLength);
+	Path[nPathLength] = '\0';
+
+	if (nVolume >= Utility::ArraySize(Volumes) || nFileSize > UINT32_MAX || !IsValidPath(Path))
+	{
+		m_LastError = TError::BadRequest;
+		return TResult::Failed;
+	}
+
+	// A new transfer replaces any unfinished one
+	if (m_bActive)
+	{
+		LOGWARN("Abandoning unfinished transfer of '%s'", m_Path);
+		Abort();
+	}
+
+	snprintf(m_Path, sizeof(m_Path), "%s:%s", Volumes[nVolume], Path);
+	snprintf(m_TempPath, sizeof(m_TempPath), "%s%s", m_Path, TempFileSuffix);
+
+	// Write to a temporary file so that an interrupted transfer never replaces a good file
+	if (f_open(&m_File, m_TempPath, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK)
+	{
+		LOGERR("Couldn't open '%s' for writing", m_TempPath);
+		m_LastError = TError::File;
+		return TResult::Failed;
+	}
+
+	m_bActive = true;
+	m_nFileSize = nFileSize;
+	m_nReceivedSize = 0;
+	m_nExpectedSequence = 0;
+	m_nWriteBufferSize = 0;
+
+	LOGNOTE("Receiving '%s' (%d bytes)", m_Path, m_nFileSize);
+	return TResult::Started;
+}
+
+CSysExFileTransfer::TResult CSysExFileTransfer::WriteBlock(u16 nSequence, const u8* pData, size_t nSize)
+{
+	if (!m_bActive)
+	{
+		m_LastError = TError::NotOpen;
+		return TResult::Failed;
+	}
+
+	if (!VerifyChecksum(pData, nSize))
+	{
+		m_LastError = TError::Checksum;
+		return TResult::Failed;
+	}
+
+	// Our acknowledgement of the previous block was lost; acknowledge it again without writing
+	if (nSequence == ((m_nExpectedSequence - 1) & 0x3FFF))
+		return TResult::Progress;
+
+	if (nSequence != m_nExpectedSequence)
+	{
+		m_LastError = TError::Sequence;
+		return TResult::Failed;
+	}
+
+	// Unpack groups of 8 bytes (MSBs followed by 7 bytes of low bits) into the write buffer
+	const u8* pPacked = pData + 2;
+	size_t nPackedSize = nSize - 3;
+
+	while (nPackedSize)
+	{
+		const size_t nGroupSize = Utility::Min(nPackedSize, static_cast<size_t>(8));
+		if (nGroupSize < 2)
+		{
+			m_LastError = TError::BadRequest;
+			return TResult::Failed;
+		}
+
+		const u8 nMSBs = pPacked[0];
+		for (size_t i = 1; i < nGroupSize; ++i)
+		{
+			if (m_nReceivedSize == m_nFileSize)
+			{
+				m_LastError = TError::SizeMismatch;
+				return TResult::Failed;
+			}
+
+			if (m_nWriteBufferSize == WriteBufferSize && !FlushWriteBuffer())
+				return TResult::Failed;
+
+			m_WriteBuffer[m_nWriteBufferSize++] = pPacked[i] | ((nMSBs << (8 - i)) & 0x80);
+			++m_nReceivedSize;
+		}
+
+		pPacked += nGroupSize;
+		nPackedSize -= nGroupSize;
+	}
+
+	m_nExpectedSequence = (m_nExpectedSequence + 1) & 0x3FFF;
+	return TResult::Progress;
+}
+
+CSysExFileTransfer::TResult CSysExFileTransfer::Close()
+{
+	if (!m_bActive)
+	{
+		m_LastError = TError::NotOpen;
+		return TResult::Failed;
+	}
+
+	if (m_nReceivedSize != m_nFileSize)
+	{
+		LOGERR("Transfer of '%s' ended after %d of %d bytes", m_Path, m_nReceivedSize, m_nFileSize);
+		m_LastError = TError::SizeMismatch;
+		Abort();
+		return TResult::Failed;
+	}
+
+	// Aborts the transfer on failure
+	if (!FlushWriteBuffer())
+		return TResult::Failed;
+
+	m_bActive = false;
+	if (f_close(&m_File) != FR_OK)
+	{
+		m_LastError = TError::File;
+		f_unlink(m_TempPath);
+		return TResult::Failed;
+	}
+
+	// Replace any existing file
+	f_unlink(m_Path);
+	if (f_rename(m_TempPath, m_Path) != FR_OK)
+	{
+		LOGERR("Couldn't rename '%s' to '%s'", m_TempPath, m_Path);
+		m_LastError = TError::File;
+		f_unlink(m_TempPath);
+		return TResult::Failed;
+	}
+
+	LOGNOTE("Received '%s'", m_Path);
+	return TResult::Completed;
+}
+
+void CSysExFileTransfer::Abort()
+{
+	f_close(&m_File);
+	f_unlink(m_TempPath);
+	m_bActive = false;
+}
+
+bool CSysExFileTransfer::FlushWriteBuffer()
+{
+	UINT nWritten;
+	const FRESULT Result = f_write(&m_File, m_WriteBuffer, m_nWriteBufferSize, &nWritten);
+
+	if (Result != FR_OK || nWritten != m_nWriteBufferSize)
+	{
+		LOGERR("Write to '%s' failed (disk full?)", m_TempPath);
+		m_LastError = TError::File;
+		Abort();
+		return false;
+	}
+
+	m_nWriteBufferSize = 0;
+	return true;
+}
+
+bool CSysExFileTransfer::IsValidPath(const char* pPath)
+{
+	// Relative paths within the volume only
+	if (pPath[0] == '/' || strstr(pPath, "..") || strchr(pPath, ':'))
+		return false;
+
+	for (const char* p = pPath; *p; ++p)
+	{
+		if (*p < ' ' || *p == '\\' || *p == '*' || *p == '?' || *p == '"' || *p == '<' || *p == '>' || *p == '|')
+			return false;
+	}
+
+	return true;
+}
+
+bool CSysExFileTransfer::VerifyChecksum(const u8* pData, size_t nSize)
+{
+	u8 nSum = 0;
+	for (size_t i = 0; i < nSize; ++i)
+		nSum += pData[i];
+
+	return (nSum & 0x7F) == 0;
+}
@@ -0,0 +1,188 @@
+//
+// telemetry.cpp
+//
+// mt32-pi - A baremetal MIDI synthesizer for Raspberry Pi
+// Copyright (C) 2020-2023 Dale Whinham <daleyo@gmail.com>
+//
+// This file is part of mt32-pi.
+//
+// mt32-pi is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// mt32-pi is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// mt32-pi. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <circle/logger.h>
+#include <circle/timer.h>
+#include <cstdio>
+#include <fatfs/ff.h>
+
+#include "firmwarestatus.h"
+#include "telemetry.h"
+
+LOGMODULE("telemetry");
+
+const char LogFile[] = "SD:telemetry.csv";
+
+// Start over once the log gets this big, so that it can't fill the SD card
+constexpr FSIZE_t MaxLogSize = 1024 * 1024;
+
+// Bits in the throttled status response that reflect the current state
+constexpr u32 CurrentThrottledStatusMask = 0xF;
+
+CTelemetry::CTelemetry()
+	: m_bLogEnabled(true),
+	  m_nLastUpdateTime(0),
+
+	  m_nRenderLoadPeak(0),
+	  m_nUnderruns(0),
+	  m_nStalls(0),
+
+	  m_nLastUnderruns(0),
+	  m_nLastStalls(0),
+
+	  m_Samples{},
+	  m_nSampleCount(0),
+
+	  m_bCapturing(false),
+	  m_nCaptureBegin(0),
+	  m_nCaptureEnd(0),
+	  m_nCaptureCount(0)
+{
+}
+
+void CTelemetry::OnRender(u32 nLoad)
+{
+	// Only the audio core writes the peak; the main core exchanges it with zero
+	if (nLoad > m_nRenderLoadPeak)
+		m_nRenderLoadPeak = nLoad;
+
+	if (nLoad > 100)
+		__atomic_add_fetch(&m_nStalls, 1, __ATOMIC_RELAXED);
+}
+
+void CTelemetry::Update(unsigned int nTicks)
+{
+	if (nTicks - m_nLastUpdateTime < HZ)
+		return;
+
+	m_nLastUpdateTime = nTicks;
+
+	const CFirmwareStatus* const pFirmwareStatus = CFirmwareStatus::Get();
+	const u32 nUnderruns = __atomic_load_n(&m_nUnderruns, __ATOMIC_RELAXED);
+	const u32 nStalls = __atomic_load_n(&m_nStalls, __ATOMIC_RELAXED);
+
+	TSample& Sample = m_Samples[m_nSampleCount % HistorySize];
+	Sample.nTime = nTicks / HZ;
+	Sample.nThrottledStatus = pFirmwareStatus ? pFirmwareStatus->GetThrottledStatus() : 0;
+	Sample.nClockMHz = pFirmwareStatus ? pFirmwareStatus->GetClockRate() / 1000000 : 0;
+	Sample.nRenderLoadPeak = __atomic_exchange_n(&m_nRenderLoadPeak, 0, __ATOMIC_RELAXED);
+	Sample.nUnderruns = nUnderruns - m_nLastUnderruns;
+	Sample.nStalls = nStalls - m_nLastStalls;
+	Sample.nTemperature = pFirmwareStatus ? pFirmwareStatus->GetTemperature() : 0;
+	++m_nSampleCount;
+
+	m_nLastUnderruns = nUnderruns;
+	m_nLastStalls = nStalls;
+
+	if (Sample.nUnderruns || Sample.nStalls)
+	{
+		if (!m_bCapturing)
+		{
+			LOGWARN("Audio %s; %dC, ARM clock %dMHz, throttled status 0x%x, render load %d%%",
+				Sample.nUnderruns ? "underrun" : "render stall", Sample.nTemperature, Sample.nClockMHz,
+				Sample.nThrottledStatus, Sample.nRenderLoadPeak);
+
+			m_bCapturing = true;
+			m_nCaptureBegin = m_nSampleCount > PreEventSamples + 1 ? m_nSampleCount - PreEventSamples - 1 : 0;
+		}
+
+		// Keep extending the window while the problem persists
+		m_nCaptureEnd = m_nSampleCount + PostEventSamples;
+	}
+
+	// Write out once the window is complete, or before the oldest sample would be overwritten
+	if (m_bCapturing && (m_nSampleCount >= m_nCaptureEnd || m_nSampleCount - m_nCaptureBegin >= HistorySize))
+	{
+		WriteCapture();
+		m_bCapturing = false;
+	}
+}
+
+void CTelemetry::Dump() const
+{
+	LOGNOTE("%d underruns, %d render stalls, %d captures", m_nUnderruns, m_nStalls, m_nCaptureCount);
+
+	const u32 nBegin = m_nSampleCount > PostEventSamples ? m_nSampleCount - PostEventSamples : 0;
+	for (u32 i = nBegin; i < m_nSampleCount; ++i)
+	{
+		const TSample& Sample = GetSample(i);
+		LOGNOTE("%5ds: %dC, %dMHz, throttled 0x%05x, load %d%%, %d underruns, %d stalls",
+			Sample.nTime, Sample.nTemperature, Sample.nClockMHz, Sample.nThrottledStatus,
+			Sample.nRenderLoadPeak, Sample.nUnderruns, Sample.nStalls);
+	}
+}
+
+void CTelemetry::WriteCapture()
+{
+	++m_nCaptureCount;
+
+	if (!m_bLogEnabled)
+		return;
+
+	FIL File;
+	if (f_open(&File, LogFile, FA_WRITE | FA_OPEN_APPEND) != FR_OK)
+	{
+		LOGERR("Couldn't open '%s' for writing", LogFile);
+		return;
+	}
+
+	if (f_size(&File) >= MaxLogSize)
+	{
+		f_close(&File);
+		if (f_open(&File, LogFile, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK)
+		{
+			LOGERR("Couldn't open '%s' for writing", LogFile);
+			return;
+		}
+	}
+
+	char Line[128];
+	bool bFailed = false;
+
+	auto WriteLine = [&](int nLength) {
+		UINT nWritten;
+		if (nLength < 0 || static_cast<size_t>(nLength) >= sizeof(Line))
+			bFailed = true;
+		else if (f_write(&File, Line, nLength, &nWritten) != FR_OK || nWritten != static_cast<UINT>(nLength))
+			bFailed = true;
+	};
+
+	if (f_size(&File) == 0)
+		WriteLine(snprintf(Line, sizeof(Line), "capture,time_s,temp_c,arm_mhz,throttled,throttled_now,render_load_pct,underruns,stalls\n"));
+
+	for (u32 i = m_nCaptureBegin; i < m_nSampleCount && !bFailed; ++i)
+	{
+		const TSample& Sample = GetSample(i);
+		WriteLine(snprintf(Line, sizeof(Line), "%u,%u,%u,%u,0x%05x,%u,%u,%u,%u\n",
+			m_nCaptureCount, Sample.nTime, Sample.nTemperature, Sample.nClockMHz, Sample.nThrottledStatus,
+			(Sample.nThrottledStatus & CurrentThrottledStatusMask) != 0, Sample.nRenderLoadPeak,
+			Sample.nUnderruns, Sample.nStalls));
+	}
+
+	if (f_close(&File) != FR_OK)
+		bFailed = true;
+
+	if (bFailed)
+		LOGERR("Couldn't write telemetry capture to '%s'", LogFile);
+	else
+		LOGNOTE("Telemetry capture %d written to '%s' (%d samples)", m_nCaptureCount, LogFile, m_nSampleCount - m_nCaptureBegin);
+}
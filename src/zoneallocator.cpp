@@ -32,7 +32,12 @@
 
 LOGMODULE("zoneallocator");
 
+#ifdef LOW_MEMORY
+// Space left for Circle/libc malloc(); check the boot memory map before shrinking this further
+constexpr size_t MallocHeapSize = 16 * MEGABYTE;
+#else
 constexpr size_t MallocHeapSize = 32 * MEGABYTE;
+#endif
 
 CZoneAllocator* CZoneAllocator::s_pThis = nullptr;
 
@@ -424,6 +429,29 @@ void CZoneAllocator::FreeTag(u32 Tag)
 	} while (pBlock != &m_MainBlock);
 }
 
+size_t CZoneAllocator::GetFreeSpace(size_t* pOutLargestBlock) const
+{
+	size_t nFree = 0;
+	size_t nLargest = 0;
+	const TBlock* pBlock = m_MainBlock.pNext;
+
+	do
+	{
+		if (pBlock->Tag == TZoneTag::Free)
+		{
+			nFree += pBlock->nSize;
+			nLargest = Utility::Max(nLargest, pBlock->nSize);
+		}
+
+		pBlock = pBlock->pNext;
+	} while (pBlock != &m_MainBlock);
+
+	if (pOutLargestBlock)
+		*pOutLargestBlock = nLargest;
+
+	return nFree;
+}
+
 void CZoneAllocator::Dump() const
 {
 	LOGNOTE("Allocation diagnostics:");